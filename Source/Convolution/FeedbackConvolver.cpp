@@ -0,0 +1,325 @@
+// FeedbackConvolver.cpp
+
+#include "FeedbackConvolver.h"
+
+namespace
+{
+    int getMaxLengthInSamples(double sampleRate)
+    {
+        return (int)std::ceil(FeedbackImpulseResponse::maxLength_mSec * sampleRate / 1000.0);
+    }
+
+    struct CacheKey
+    {
+        juce::uint64 contentHash;
+        int numChannels;
+        int numSamples;
+        double irSampleRate;
+        double sampleRate;
+        int partitionSize;
+
+        bool operator<(const CacheKey& other) const
+        {
+            return std::tie(contentHash, numChannels, numSamples, irSampleRate, sampleRate, partitionSize)
+                 < std::tie(other.contentHash, other.numChannels, other.numSamples, other.irSampleRate, other.sampleRate, other.partitionSize);
+        }
+    };
+
+    // --- FNV-1a over the sample bits: the same file loaded twice hashes the same
+    juce::uint64 hashSamples(const juce::AudioBuffer<float>& ir)
+    {
+        juce::uint64 hash = 14695981039346656037ull;
+
+        for (int ch = 0; ch < ir.getNumChannels(); ++ch)
+        {
+            auto* bytes = reinterpret_cast<const juce::uint8*>(ir.getReadPointer(ch));
+            for (size_t i = 0; i < (size_t)ir.getNumSamples() * sizeof(float); ++i)
+                hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+
+        return hash;
+    }
+
+    // --- the IR at the processing rate; its gain is scaled so the response keeps its level
+    juce::AudioBuffer<float> resample(const juce::AudioBuffer<float>& ir, double irSampleRate, double sampleRate)
+    {
+        auto ratio = irSampleRate / sampleRate;
+        auto numSamples = juce::jmin(getMaxLengthInSamples(sampleRate), (int)std::ceil(ir.getNumSamples() / ratio));
+
+        juce::AudioBuffer<float> resampled(ir.getNumChannels(), numSamples);
+
+        if (ratio == 1.0)
+        {
+            for (int ch = 0; ch < ir.getNumChannels(); ++ch)
+                resampled.copyFrom(ch, 0, ir, ch, 0, numSamples);
+            return resampled;
+        }
+
+        // --- the interpolator reads a few samples past the end: pad with silence
+        juce::AudioBuffer<float> padded(1, ir.getNumSamples() + (int)std::ceil(ratio) * 8 + 8);
+
+        for (int ch = 0; ch < ir.getNumChannels(); ++ch)
+        {
+            padded.clear();
+            padded.copyFrom(0, 0, ir, ch, 0, ir.getNumSamples());
+
+            juce::LagrangeInterpolator interpolator;
+            interpolator.process(ratio, padded.getReadPointer(0), resampled.getWritePointer(ch), numSamples);
+        }
+
+        resampled.applyGain((float)ratio);
+        return resampled;
+    }
+
+    // --- scale so no frequency is boosted: with feedback up to 100% the loop stays stable
+    void normalizeToUnityPeakGain(juce::AudioBuffer<float>& ir)
+    {
+        int order = 1;
+        while ((1 << order) < 2 * ir.getNumSamples())
+            ++order;
+
+        juce::dsp::FFT fft(order);
+        std::vector<float> buffer((size_t)(2 << order));
+        float peak = 0.0f;
+
+        for (int ch = 0; ch < ir.getNumChannels(); ++ch)
+        {
+            std::fill(buffer.begin(), buffer.end(), 0.0f);
+            std::copy(ir.getReadPointer(ch), ir.getReadPointer(ch) + ir.getNumSamples(), buffer.begin());
+
+            fft.performFrequencyOnlyForwardTransform(buffer.data(), true);
+            peak = juce::jmax(peak, juce::FloatVectorOperations::findMaximum(buffer.data(), (1 << order) / 2 + 1));
+        }
+
+        if (peak > 0.0f)
+            ir.applyGain(1.0f / peak);
+    }
+}
+
+//==============================================================================
+bool FeedbackImpulseResponse::loadFile(const juce::File& file, juce::AudioBuffer<float>& ir, double& irSampleRate,
+                                       juce::String& errorMessage)
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+
+    if (reader == nullptr)
+    {
+        errorMessage = "Unsupported or unreadable audio file " + file.getFullPathName();
+        return false;
+    }
+
+    auto numChannels = juce::jmin(2, (int)reader->numChannels);
+    auto numSamples = (int)juce::jmin(reader->lengthInSamples, (juce::int64)getMaxLengthInSamples(reader->sampleRate));
+
+    if (numChannels == 0 || numSamples == 0)
+    {
+        errorMessage = "Empty impulse response " + file.getFullPathName();
+        return false;
+    }
+
+    ir.setSize(numChannels, numSamples);
+    reader->read(&ir, 0, numSamples, 0, true, numChannels > 1);
+    irSampleRate = reader->sampleRate;
+
+    return true;
+}
+
+std::shared_ptr<const FeedbackImpulseResponse> FeedbackImpulseResponse::get(const juce::AudioBuffer<float>& ir, double irSampleRate,
+                                                                            double sampleRate, int partitionSize)
+{
+    static std::mutex cacheMutex;
+    static std::map<CacheKey, std::weak_ptr<const FeedbackImpulseResponse>> cache;
+
+    CacheKey key { hashSamples(ir), ir.getNumChannels(), ir.getNumSamples(), irSampleRate, sampleRate, partitionSize };
+
+    // --- built under the lock, so instances asking for the same IR at once build it only once
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    for (auto it = cache.begin(); it != cache.end();)
+        it = it->second.expired() ? cache.erase(it) : std::next(it);
+
+    if (auto cached = cache[key].lock())
+        return cached;
+
+    auto resampled = resample(ir, irSampleRate, sampleRate);
+    normalizeToUnityPeakGain(resampled);
+
+    std::shared_ptr<const FeedbackImpulseResponse> built(new FeedbackImpulseResponse(resampled, partitionSize));
+    cache[key] = built;
+    return built;
+}
+
+FeedbackImpulseResponse::FeedbackImpulseResponse(const juce::AudioBuffer<float>& ir, int _partitionSize)
+    : partitionSize(_partitionSize),
+      numPartitions((ir.getNumSamples() + _partitionSize - 1) / _partitionSize),
+      numChannels(ir.getNumChannels()),
+      partitionStride(2 * (_partitionSize + 1))
+{
+    spectra.resize((size_t)numChannels * (size_t)numPartitions * (size_t)partitionStride);
+
+    // --- each partition zero-padded to 2 * partitionSize, as the convolver transforms its input
+    juce::dsp::FFT fft(juce::roundToInt(std::log2(2 * partitionSize)));
+    std::vector<float> buffer((size_t)(4 * partitionSize));
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        for (int p = 0; p < numPartitions; ++p)
+        {
+            auto start = p * partitionSize;
+            auto length = juce::jmin(partitionSize, ir.getNumSamples() - start);
+
+            std::fill(buffer.begin(), buffer.end(), 0.0f);
+            std::copy(ir.getReadPointer(ch) + start, ir.getReadPointer(ch) + start + length, buffer.begin());
+
+            fft.performRealOnlyForwardTransform(buffer.data(), true);
+            std::copy(buffer.begin(), buffer.begin() + partitionStride, spectra.begin() + (std::ptrdiff_t)(getPartition(ch, p) - spectra.data()));
+        }
+    }
+}
+
+//==============================================================================
+int FeedbackConvolver::getPartitionSize(double minimumDelayInSamples)
+{
+    int size = minPartitionSize;
+    while (size < maxPartitionSize && 2 * size <= minimumDelayInSamples)
+        size *= 2;
+
+    return size;
+}
+
+void FeedbackConvolver::prepare(double sampleRate)
+{
+    maxLengthInSamples = getMaxLengthInSamples(sampleRate);
+    maxSpectraSize = 0;
+
+    // --- the smallest partitions need the most spectra: one row of 2 * (size + 1) floats per partition
+    for (int i = 0, size = minPartitionSize; i < numPartitionSizes; ++i, size *= 2)
+    {
+        ffts[i] = std::make_unique<juce::dsp::FFT>(juce::roundToInt(std::log2(2 * size)));
+
+        auto spectraSize = (size_t)((maxLengthInSamples + size - 1) / size) * (size_t)(2 * (size + 1));
+        maxSpectraSize = juce::jmax(maxSpectraSize, spectraSize);
+    }
+
+    input.calloc((size_t)(2 * maxPartitionSize));
+    output.calloc((size_t)maxPartitionSize);
+    fftBuffer.calloc((size_t)(4 * maxPartitionSize));
+    accumulator.calloc((size_t)(2 * (maxPartitionSize + 1)));
+    inputSpectra.calloc(maxSpectraSize);
+
+    partitionSize = minPartitionSize;
+    partitionStride = 2 * (partitionSize + 1);
+    maxNumPartitions = (maxLengthInSamples + partitionSize - 1) / partitionSize;
+    fft = ffts[0].get();
+
+    irPartitions = nullptr;
+    numPartitions = 0;
+    reset(sampleRate);
+}
+
+void FeedbackConvolver::setImpulseResponse(const FeedbackImpulseResponse* ir, int channel)
+{
+    jassert(ir == nullptr || (ir->getPartitionSize() >= minPartitionSize && ir->getPartitionSize() <= maxPartitionSize));
+
+    if (ir == nullptr || fft == nullptr)
+    {
+        irPartitions = nullptr;
+        numPartitions = 0;
+    }
+    else
+    {
+        // --- everything was allocated for every size: switching is just picking the FFT and the strides
+        partitionSize = ir->getPartitionSize();
+        partitionStride = 2 * (partitionSize + 1);
+        maxNumPartitions = (maxLengthInSamples + partitionSize - 1) / partitionSize;
+        fft = ffts[juce::roundToInt(std::log2(partitionSize / minPartitionSize))].get();
+
+        irPartitions = ir->getPartition(juce::jmin(channel, ir->getNumChannels() - 1), 0);
+        numPartitions = juce::jmin(ir->getNumPartitions(), maxNumPartitions);
+    }
+
+    reset(0.0);
+}
+
+bool FeedbackConvolver::reset(double)
+{
+    if (partitionSize == 0)
+        return false;
+
+    juce::FloatVectorOperations::clear(input.get(), 2 * partitionSize);
+    juce::FloatVectorOperations::clear(output.get(), partitionSize);
+    juce::FloatVectorOperations::clear(inputSpectra.get(), numPartitions * partitionStride);
+    spectrumIndex = 0;
+    position = 0;
+
+    return true;
+}
+
+double FeedbackConvolver::processAudioSample(double xn)
+{
+    if (irPartitions == nullptr)
+        return 0.0;
+
+    double yn = output[position];
+    input[partitionSize + position] = (float)xn;
+
+    if (++position == partitionSize)
+        processPartition();
+
+    return yn;
+}
+
+void FeedbackConvolver::processPartition()
+{
+    auto* data = fftBuffer.get();
+
+    // --- spectrum of the last two partitions of input, into the frequency-domain delay line
+    juce::FloatVectorOperations::copy(data, input.get(), 2 * partitionSize);
+    juce::FloatVectorOperations::clear(data + 2 * partitionSize, 2 * partitionSize);
+    fft->performRealOnlyForwardTransform(data, true);
+
+    spectrumIndex = (spectrumIndex == 0 ? numPartitions : spectrumIndex) - 1;
+    juce::FloatVectorOperations::copy(inputSpectra.get() + spectrumIndex * partitionStride, data, partitionStride);
+
+    // --- IR partition p meets the input spectrum from p partitions ago: newest first, in two runs around the ring
+    auto* sum = accumulator.get();
+    juce::FloatVectorOperations::clear(sum, partitionStride);
+
+    const float* h = irPartitions;
+    for (int run = 0; run < 2; ++run)
+    {
+        auto first = run == 0 ? spectrumIndex : 0;
+        auto last = run == 0 ? numPartitions : spectrumIndex;
+
+        for (int row = first; row < last; ++row, h += partitionStride)
+        {
+            const float* x = inputSpectra.get() + row * partitionStride;
+            for (int k = 0; k < partitionStride; k += 2)
+            {
+                sum[k] += x[k] * h[k] - x[k + 1] * h[k + 1];
+                sum[k + 1] += x[k] * h[k + 1] + x[k + 1] * h[k];
+            }
+        }
+    }
+
+    // --- overlap-save: the second half is the convolution of the partition just completed
+    juce::FloatVectorOperations::copy(data, sum, partitionStride);
+    juce::FloatVectorOperations::clear(data + partitionStride, 4 * partitionSize - partitionStride);
+    fft->performRealOnlyInverseTransform(data);
+
+    juce::FloatVectorOperations::copy(output.get(), data + partitionSize, partitionSize);
+    juce::FloatVectorOperations::copy(input.get(), input.get() + partitionSize, partitionSize);
+    position = 0;
+}
+
+size_t FeedbackConvolver::getMemoryBytes() const
+{
+    if (fft == nullptr)
+        return 0;
+
+    return (size_t)(2 * maxPartitionSize + maxPartitionSize + 4 * maxPartitionSize + 2 * (maxPartitionSize + 1)) * sizeof(float)
+         + maxSpectraSize * sizeof(float);
+}
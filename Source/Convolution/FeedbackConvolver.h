@@ -0,0 +1,128 @@
+// FeedbackConvolver.h
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "../DSP/IAudioSignalProcessor.h"
+
+/**
+Impulse response of a FeedbackConvolver, ready to use: resampled to the processing rate, cut to
+maxLength_mSec, split into partitions of partitionSize samples and transformed. It never changes
+after it is built, so every convolver in the process that uses the same IR at the same rate and
+partition size shares one: get() returns the cached one while anything still holds it.
+
+Memory per channel: about 8 bytes per IR sample (one complex float per bin, each partition of
+partitionSize samples has partitionSize + 1 bins).
+*/
+class FeedbackImpulseResponse
+{
+public:
+    static constexpr double maxLength_mSec = 100.0;
+
+    /** read an IR file: the first maxLength_mSec of up to two channels; do NOT call from the realtime audio thread */
+    static bool loadFile(const juce::File& file, juce::AudioBuffer<float>& ir, double& irSampleRate, juce::String& errorMessage);
+
+    /** the IR for processing at sampleRate in partitions of partitionSize (a power of two), from the cache or
+        built now; thread-safe, but do NOT call from the realtime audio thread */
+    static std::shared_ptr<const FeedbackImpulseResponse> get(const juce::AudioBuffer<float>& ir, double irSampleRate,
+                                                              double sampleRate, int partitionSize);
+
+    int getPartitionSize() const { return partitionSize; }
+    int getNumPartitions() const { return numPartitions; }
+    int getNumChannels() const { return numChannels; }
+
+    /** partition p of a channel: partitionSize + 1 bins, interleaved real and imaginary parts */
+    const float* getPartition(int channel, int p) const { return spectra.data() + ((size_t)channel * (size_t)numPartitions + (size_t)p) * (size_t)partitionStride; }
+
+    /** floats per partition */
+    int getPartitionStride() const { return partitionStride; }
+
+    size_t getMemoryBytes() const { return spectra.size() * sizeof(float); }
+
+private:
+    FeedbackImpulseResponse(const juce::AudioBuffer<float>& ir, int partitionSize);
+
+    int partitionSize = 0;
+    int numPartitions = 0;
+    int numChannels = 0;
+    int partitionStride = 0;
+    std::vector<float> spectra;			// channel-major, then partition-major
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FeedbackImpulseResponse)
+};
+
+/**
+Convolves one channel with a FeedbackImpulseResponse, for AudioDelay::setFeedbackInserts(): every
+echo goes through the IR once more, so the repeats pick up the sound of a room or a speaker cabinet.
+
+- Uniformly partitioned overlap-save convolution on juce::dsp::FFT: every partitionSize input
+  samples, one forward FFT of 2 * partitionSize points, one complex multiply-add per IR partition
+  from a frequency-domain delay line of past input spectra, and one inverse FFT. The cost depends
+  only on the partition size and the IR length, never on the signal.
+- Latency is exactly partitionSize samples (getLatencySamples()); AudioDelay reads its lines that
+  much later, which only works for delays of at least one partition: getPartitionSize() picks the
+  largest power of two that fits the shortest delay.
+- The partition size is the IR's: when the shortest delay changes, an IR built for the new size is
+  swapped in with setImpulseResponse().
+- prepare() allocates for the longest IR at the rate, for every partition size; setImpulseResponse()
+  and everything else are realtime-safe.
+*/
+class FeedbackConvolver : public IAudioSignalProcessor
+{
+public:
+    static constexpr int minPartitionSize = 16;
+    static constexpr int maxPartitionSize = 1024;
+
+    FeedbackConvolver() {}
+
+    /** largest power of two partition, between minPartitionSize and maxPartitionSize, that fits the delay */
+    static int getPartitionSize(double minimumDelayInSamples);
+
+    /** allocate for an IR of up to FeedbackImpulseResponse::maxLength_mSec in any partition size; do NOT call
+        from the realtime audio thread */
+    void prepare(double sampleRate);
+
+    /** convolve with one channel of ir (the last one if it has fewer) in its partition size, nullptr for
+        silence; ir must outlive its use here; clears the convolution state */
+    void setImpulseResponse(const FeedbackImpulseResponse* ir, int channel);
+
+    /** clear the convolution state */
+    bool reset(double _sampleRate) override;
+
+    /** one sample in, the convolution of the sample partitionSize samples ago out */
+    double processAudioSample(double xn) override;
+
+    bool canProcessAudioFrame() override { return false; }
+
+    uint32_t getLatencySamples() override { return (uint32_t)partitionSize; }
+
+    size_t getMemoryBytes() const;
+
+private:
+    static constexpr int numPartitionSizes = 7;		// minPartitionSize to maxPartitionSize in octaves
+    static_assert((minPartitionSize << (numPartitionSizes - 1)) == maxPartitionSize, "one FFT per partition size");
+
+    void processPartition();
+
+    std::unique_ptr<juce::dsp::FFT> ffts[numPartitionSizes];	// one per partition size, 2 * partitionSize points
+    juce::dsp::FFT* fft = nullptr;			// of the partition size in use
+    int maxLengthInSamples = 0;				// longest IR at the prepared rate
+    size_t maxSpectraSize = 0;				// floats of inputSpectra: the most any partition size needs
+    int partitionSize = 0;
+    int maxNumPartitions = 0;
+    int partitionStride = 0;
+
+    const float* irPartitions = nullptr;	// first partition of the channel; nullptr = silence
+    int numPartitions = 0;					// of the IR in use
+
+    juce::HeapBlock<float> input;			// previous and current partition of input, 2 * partitionSize
+    juce::HeapBlock<float> output;			// convolution of the previous partition, partitionSize
+    juce::HeapBlock<float> fftBuffer;		// 4 * partitionSize
+    juce::HeapBlock<float> accumulator;		// partitionStride
+    juce::HeapBlock<float> inputSpectra;	// maxNumPartitions rows of partitionStride, newest at spectrumIndex
+    int spectrumIndex = 0;
+    int position = 0;						// samples into the current partition
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FeedbackConvolver)
+};
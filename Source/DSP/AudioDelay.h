@@ -2,12 +2,24 @@
 
 #pragma once
 
-#include <JuceHeader.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <utility>
 
 #include "AudioDelayParameters.h"
+#include "AudioDucker.h"
+#include "BBDDelay.h"
 #include "CircularBuffer.h"
+#include "DSPKernels.h"
 #include "DSPUtils.h"
+#include "FeedbackDelayNetwork.h"
+#include "FreezeLoopReader.h"
 #include "IAudioSignalProcessor.h"
+#include "MultibandDelay.h"
+#include "PitchShiftReader.h"
+#include "ReverseSegmentReader.h"
 
 /**
 \class AudioDelay
@@ -17,9 +29,13 @@ The AudioDelay object implements a stereo audio delay with multiple delay algori
 
 Audio I/O:
 - Processes mono input to mono output OR stereo output.
+- Optional aux (sidechain) input keys the wet signal ducking; with the aux input disabled the
+  ducking is keyed from the main input.
 
 Control I/F:
 - Use AudioDelayParameters structure to get/set object params.
+- kNormal runs the stereo line inputs through a 2x2 matrix: crossFeedback_Pct moves from separate
+  lines (0) through every blend to the kPingPong routing (100).
 
 \author Will Pirkle http://www.willpirkle.com
 \remark This object is included in Designing Audio Effects Plugins in C++ 2nd Ed. by Will Pirkle
@@ -42,6 +58,23 @@ public:
             // --- just flush buffer and return
             delayBuffer_L.flushBuffer();
             delayBuffer_R.flushBuffer();
+            fdn.flush();
+            multiband.flush();
+            bbd.flush();
+            resetFeedbackInserts();
+            reverse_L.reset();
+            reverse_R.reset();
+            pitch_L.reset();
+            pitch_R.reset();
+            ducker.reset(sampleRate);
+            duckGain = 1.0;
+
+            // --- nothing left to crossfade
+            renderQualityMix = renderQualityTarget;
+
+            // --- a held freeze goes on looping the cleared lines
+            frozen = false;
+            updateFreeze();
             return true;
         }
 
@@ -58,17 +91,63 @@ public:
     */
     virtual double processAudioSample(double xn)
     {
-        // --- read delay
-        double yn = delayBuffer_L.readBuffer(delayInSamples_L);
+        // --- ducking keyed from the main input
+        if (ducker.isActive() && !auxInputEnabled)
+            duckGain = ducker.processKeySample(xn);
+
+        double wet = wetMix * duckGain;
+
+        // --- diffuse mode: mono in, sum of the decorrelated outputs
+        if (parameters.algorithm == delayAlgorithm::kFDN)
+        {
+            double ynL = 0.0, ynR = 0.0;
+            fdn.processAudioFrame(xn, xn, ynL, ynR);
+            return dryMix * xn + wet * 0.5 * (ynL + ynR);
+        }
+
+        // --- multiband mode: left lanes only
+        if (parameters.algorithm == delayAlgorithm::kMultiband)
+        {
+            double ynL = 0.0, ynR = 0.0;
+            multiband.processAudioFrame<false>(xn, xn, ynL, ynR);
+            return dryMix * xn + wet * ynL;
+        }
+
+        // --- bucket-brigade mode: left chip only
+        if (parameters.algorithm == delayAlgorithm::kBBD)
+        {
+            double ynL = 0.0, ynR = 0.0;
+            bbd.processAudioFrame<false>(xn, xn, ynL, ynR);
+            return dryMix * xn + wet * ynL;
+        }
+
+        // --- frozen: play the loop, nothing is written
+        if (frozen)
+            return dryMix * xn + wet * freeze_L.readSample(delayBuffer_L);
+
+        bool reverse = parameters.algorithm == delayAlgorithm::kReverse;
+        bool inserts = feedbackInsert_L != nullptr && !reverse;
+
+        // --- feedback inserts delay what enters the line: read that much later
+        double readDelay = inserts ? getInsertReadDelay(delayInSamples_L) : delayInSamples_L;
+
+        // --- read delay (backwards in reverse mode, through the grains when pitch shifting)
+        double yn = reverse ? reverse_L.readSample(delayBuffer_L)
+                  : isPitchShifting() ? pitch_L.readSample(delayBuffer_L, readDelay)
+                  : readDelayLine(delayBuffer_L, readDelay, nextRenderQualityWeightIfUsed());
 
         // --- create input for delay buffer
         double dn = xn + (parameters.feedback_Pct / 100.0) * yn;
 
+        // --- feedback insert, between the feedback sum and the line
+        if (inserts)
+            dn = feedbackInsert_L->processAudioSample(dn);
+
         // --- write to delay buffer
         delayBuffer_L.writeBuffer(dn);
 
         // --- form mixture out = dry*xn + wet*yn
-        double output = dryMix * xn + wetMix * yn;
+        double output = dryMix * xn + wet * yn;
 
         return output;
     }
@@ -88,7 +167,11 @@ public:
 
         // --- make sure we support this delay algorithm
         if (parameters.algorithm != delayAlgorithm::kNormal &&
-            parameters.algorithm != delayAlgorithm::kPingPong)
+            parameters.algorithm != delayAlgorithm::kPingPong &&
+            parameters.algorithm != delayAlgorithm::kFDN &&
+            parameters.algorithm != delayAlgorithm::kReverse &&
+            parameters.algorithm != delayAlgorithm::kMultiband &&
+            parameters.algorithm != delayAlgorithm::kBBD)
             return false;
 
         // --- if only one output channel, revert to mono operation
@@ -109,11 +192,60 @@ public:
         // --- RIGHT channel (duplicate left input if mono-in)
         double xnR = inputChannels > 1 ? inputFrame[1] : xnL;
 
+        // --- ducking keyed from the main input
+        if (ducker.isActive() && !auxInputEnabled)
+            duckGain = ducker.processKeySample(fmax(fabs(xnL), fabs(xnR)));
+
+        double wet = wetMix * duckGain;
+
+        // --- diffuse, multiband and bucket-brigade modes run their own lines
+        if (parameters.algorithm == delayAlgorithm::kFDN || parameters.algorithm == delayAlgorithm::kMultiband ||
+            parameters.algorithm == delayAlgorithm::kBBD)
+        {
+            double ynL = 0.0, ynR = 0.0;
+            if (parameters.algorithm == delayAlgorithm::kFDN)
+                fdn.processAudioFrame(xnL, xnR, ynL, ynR);
+            else if (parameters.algorithm == delayAlgorithm::kMultiband)
+                multiband.processAudioFrame<true>(xnL, xnR, ynL, ynR);
+            else
+                bbd.processAudioFrame<true>(xnL, xnR, ynL, ynR);
+
+            outputFrame[0] = dryMix * xnL + wet * ynL;
+            outputFrame[1] = dryMix * xnR + wet * ynR;
+            return true;
+        }
+
+        // --- frozen: play the loops, nothing is written
+        if (frozen)
+        {
+            double ynL = freeze_L.readSample(delayBuffer_L);
+            double ynR = freeze_R.readSample(delayBuffer_R);
+
+            outputFrame[0] = dryMix * xnL + wet * ynL;
+            outputFrame[1] = dryMix * xnR + wet * ynR;
+            return true;
+        }
+
+        bool reverse = parameters.algorithm == delayAlgorithm::kReverse;
+        bool pitchShifting = isPitchShifting();
+        bool inserts = feedbackInsert_L != nullptr && !reverse;
+
+        // --- one crossfade step per frame, shared by both lines
+        double renderQualityWeight = reverse || pitchShifting ? 0.0 : nextRenderQualityWeightIfUsed();
+
+        // --- feedback inserts delay what enters the lines: read that much later
+        double readDelay_L = inserts ? getInsertReadDelay(delayInSamples_L) : delayInSamples_L;
+        double readDelay_R = inserts ? getInsertReadDelay(delayInSamples_R) : delayInSamples_R;
+
         // --- read delay LEFT
-        double ynL = delayBuffer_L.readBuffer(delayInSamples_L);
+        double ynL = reverse ? reverse_L.readSample(delayBuffer_L)
+                   : pitchShifting ? pitch_L.readSample(delayBuffer_L, readDelay_L)
+                   : readDelayLine(delayBuffer_L, readDelay_L, renderQualityWeight);
 
         // --- read delay RIGHT
-        double ynR = delayBuffer_R.readBuffer(delayInSamples_R);
+        double ynR = reverse ? reverse_R.readSample(delayBuffer_R)
+                   : pitchShifting ? pitch_R.readSample(delayBuffer_R, readDelay_R)
+                   : readDelayLine(delayBuffer_R, readDelay_R, renderQualityWeight);
 
         // --- create input for delay buffer with LEFT channel info
         double dnL = xnL + (parameters.feedback_Pct / 100.0) * ynL;
@@ -121,9 +253,20 @@ public:
         // --- create input for delay buffer with RIGHT channel info
         double dnR = xnR + (parameters.feedback_Pct / 100.0) * ynR;
 
+        // --- feedback inserts, between the feedback sums and the lines
+        if (inserts)
+        {
+            dnL = feedbackInsert_L->processAudioSample(dnL);
+            dnR = feedbackInsert_R->processAudioSample(dnR);
+        }
+
         // --- decode
-        if (parameters.algorithm == delayAlgorithm::kNormal)
+        if (parameters.algorithm == delayAlgorithm::kNormal || reverse)
         {
+            // --- cross feedback: both line inputs through the matrix as one stereo frame
+            if (lineCrossGain != 0.0)
+                DSPKernels::crossFeedbackFrame(dnL, dnR, lineSelfGain, lineCrossGain);
+
             // --- write to LEFT delay buffer with LEFT channel info
             delayBuffer_L.writeBuffer(dnL);
 
@@ -140,10 +283,10 @@ public:
         }
 
         // --- form mixture out = dry*xn + wet*yn
-        double outputL = dryMix * xnL + wetMix * ynL;
+        double outputL = dryMix * xnL + wet * ynL;
 
         // --- form mixture out = dry*xn + wet*yn
-        double outputR = dryMix * xnR + wetMix * ynR;
+        double outputR = dryMix * xnR + wet * ynR;
 
         // --- set left channel
         outputFrame[0] = outputL;
@@ -154,6 +297,136 @@ public:
         return true;
     }
 
+    /** switch the ducking key between the aux input (true) and the main input (false) */
+    virtual void enableAuxInput(bool enableAuxInput) { auxInputEnabled = enableAuxInput; }
+
+    /** feed one sample of the ducking key; call before processAudioSample()/processAudioFrame()
+        for the same sample. For a stereo key pass the larger magnitude of the two channels. */
+    /**
+    \return the wet gain for this sample
+    */
+    virtual double processAuxInputAudioSample(double xn)
+    {
+        if (ducker.isActive() && auxInputEnabled)
+            duckGain = ducker.processKeySample(xn);
+
+        return duckGain;
+    }
+
+    /** process a block of audio; produces exactly the same output as calling processAudioFrame() on each frame */
+    /**
+    One specialized kernel is picked per block for the current algorithm, channel layout,
+    interpolation, feedback and automation state, so the per-sample loop has no branches on them.
+
+    \param inputs channel pointers, inputs[0] = left, inputs[1] = right (if inputChannels > 1)
+    \param outputs channel pointers; may be the same buffers as inputs
+    \param automation optional per-sample parameter curves; nullptr for static parameters
+    \param auxInputs ducking key channels, used when the aux input is enabled; nullptr for a silent key
+    */
+    bool processAudioBlock(const float* const* inputs,
+        float* const* outputs,
+        uint32_t inputChannels,
+        uint32_t outputChannels,
+        uint32_t numSamples,
+        const AudioDelayAutomation* automation = nullptr,
+        const float* const* auxInputs = nullptr,
+        uint32_t auxInputChannels = 0)
+    {
+        // --- make sure we have input and outputs
+        if (inputChannels == 0 || outputChannels == 0)
+            return false;
+
+        bool modulating = automation != nullptr && !automation->isStatic();
+
+        bool stereoOut = outputChannels > 1;
+        bool stereoIn = stereoOut && inputChannels > 1;
+
+        BlockKernel kernel = nullptr;
+
+        if (parameters.algorithm == delayAlgorithm::kNormal ||
+            parameters.algorithm == delayAlgorithm::kPingPong)
+        {
+            bool pingPong = stereoOut && parameters.algorithm == delayAlgorithm::kPingPong;
+            bool crossFeedback = stereoOut && lineCrossGain != 0.0;
+            bool feedback = parameters.feedback_Pct != 0.0 || (modulating && automation->feedback_Pct != nullptr);
+
+            size_t kernelIndex = (pingPong ? 32 : 0) | (stereoOut ? 16 : 0) | (stereoIn ? 8 : 0) |
+                                 (delayBuffer_L.getInterpolate() ? 4 : 0) | (feedback ? 2 : 0) | (modulating ? 1 : 0);
+
+            // --- frozen lines only loop: no feedback, inserts or pitch shifting to run
+            if (frozen)
+                kernel = modulating ? nullptr
+                       : !stereoOut ? &AudioDelay::processFrozenSegments<false, false>
+                       : stereoIn ? &AudioDelay::processFrozenSegments<true, true>
+                       : &AudioDelay::processFrozenSegments<true, false>;
+            // --- feedback inserts process one sample at a time
+            else if (feedbackInsert_L != nullptr)
+                kernel = nullptr;
+            else if (!isPitchShifting())
+                kernel = getKernelTable()[kernelIndex | (crossFeedback ? 64 : 0)];
+            else if (!modulating && !crossFeedback)
+                kernel = getPitchShiftKernelTable()[kernelIndex >> 3];
+        }
+        else if (parameters.algorithm == delayAlgorithm::kReverse && !modulating)
+        {
+            kernel = !stereoOut ? &AudioDelay::processReverseSegments<false, false>
+                   : stereoIn ? &AudioDelay::processReverseSegments<true, true>
+                   : &AudioDelay::processReverseSegments<true, false>;
+        }
+        else if (parameters.algorithm == delayAlgorithm::kMultiband && !modulating)
+        {
+            kernel = !stereoOut ? &AudioDelay::processMultibandSegments<false, false>
+                   : stereoIn ? &AudioDelay::processMultibandSegments<true, true>
+                   : &AudioDelay::processMultibandSegments<true, false>;
+        }
+        else if (parameters.algorithm == delayAlgorithm::kBBD && !modulating)
+        {
+            kernel = !stereoOut ? &AudioDelay::processBBDSegments<false, false>
+                   : stereoIn ? &AudioDelay::processBBDSegments<true, true>
+                   : &AudioDelay::processBBDSegments<true, false>;
+        }
+
+        // --- everything else runs frame by frame
+        if (kernel == nullptr)
+        {
+            processFrameByFrame(inputs, outputs, inputChannels, outputChannels, numSamples, modulating ? automation : nullptr,
+                                auxInputs, auxInputChannels);
+            return true;
+        }
+
+        if (!ducker.isActive())
+        {
+            (this->*kernel)(inputs, outputs, numSamples, automation);
+            return true;
+        }
+
+        // --- ducking: compute the wet gain of up to scratchLength samples, then run the kernel on them
+        for (uint32_t start = 0; start < numSamples; start += scratchLength)
+        {
+            uint32_t n = std::min(scratchLength, numSamples - start);
+
+            // --- read the key first: outputs may alias the inputs
+            if (auxInputEnabled)
+                ducker.processKeyBlock(auxInputs && auxInputChannels > 0 ? auxInputs[0] + start : nullptr,
+                                       auxInputs && auxInputChannels > 1 ? auxInputs[1] + start : nullptr,
+                                       scratchDuckGain, n);
+            else
+                ducker.processKeyBlock(inputs[0] + start, stereoIn ? inputs[1] + start : nullptr, scratchDuckGain, n);
+
+            duckGain = scratchDuckGain[n - 1];
+
+            const float* partInputs[2]{ inputs[0] + start, inputs[inputChannels > 1 ? 1 : 0] + start };
+            float* partOutputs[2]{ outputs[0] + start, outputs[outputChannels > 1 ? 1 : 0] + start };
+            AudioDelayAutomation partAutomation = modulating ? automation->offsetBy(start) : AudioDelayAutomation();
+
+            blockDuckGain = scratchDuckGain;
+            (this->*kernel)(partInputs, partOutputs, n, modulating ? &partAutomation : nullptr);
+            blockDuckGain = nullptr;
+        }
+
+        return true;
+    }
+
     /** get parameters: note use of custom structure for passing param data */
     /**
     \return AudioDelayParameters custom data structure
@@ -200,11 +473,155 @@ public:
             delayInSamples_L = newDelayInSamples;
             delayInSamples_R = delayInSamples_L * delayRatio;
         }
+
+        // --- line input matrix: kNormal sends crossFeedback_Pct of each line's input to the other line
+        double crossGain = parameters.algorithm == delayAlgorithm::kNormal ? parameters.crossFeedback_Pct / 100.0 : 0.0;
+        boundValue(crossGain, 0.0, 1.0);
+        lineCrossGain = crossGain;
+        lineSelfGain = 1.0 - crossGain;
+
+        // --- diffuse mode: the left delay sets the longest line
+        if (parameters.algorithm == delayAlgorithm::kFDN)
+            fdn.setParameters(delayInSamples_L, parameters.feedback_Pct / 100.0, parameters.fdnDamping_Pct / 100.0);
+
+        // --- multiband mode: band delays are relative to each channel's delay
+        if (parameters.algorithm == delayAlgorithm::kMultiband)
+            multiband.setParameters(parameters.multibandNumBands, parameters.multibandCrossover_Hz, delayInSamples_L, delayInSamples_R,
+                                    parameters.multibandDelay_Pct, parameters.multibandFeedback_Pct, parameters.multibandLevel_dB);
+
+        // --- bucket-brigade mode: each channel's delay sets its chip's clock
+        if (parameters.algorithm == delayAlgorithm::kBBD)
+            bbd.setParameters(delayInSamples_L, delayInSamples_R, parameters.feedback_Pct / 100.0);
+
+        // --- reverse mode: the delay time sets the segment length
+        reverse_L.setSegmentLength(delayInSamples_L);
+        reverse_R.setSegmentLength(delayInSamples_R);
+
+        // --- pitch shifted reads
+        pitch_L.setPitchShift(parameters.pitchShift_Semitones);
+        pitch_R.setPitchShift(parameters.pitchShift_Semitones);
+
+        // --- wet ducking
+        ducker.setParameters(parameters.duckThreshold_dB, parameters.duckDepth_dB, parameters.duckAttack_mSec, parameters.duckRelease_mSec);
+        if (!ducker.isActive())
+            duckGain = 1.0;
+
+        // --- freeze engages or lets go of the lines
+        updateFreeze();
     }
 
-    /** creation function */
+    /** enable or disable fractional delay interpolation on both delay lines */
+    void setInterpolate(bool b)
+    {
+        delayBuffer_L.setInterpolate(b);
+        delayBuffer_R.setInterpolate(b);
+        multiband.setInterpolate(b);
+    }
+
+    /** number of lines of the delayAlgorithm::kFDN network: 4, 8 (default) or 16 */
+    void setFDNNumLines(int numLines) { fdn.setNumLines(numLines); }
+
+    /** process the feedback path of kNormal and kPingPong through a processor per line (both or nullptr for
+        none), between the feedback sum and the line. The lines are read earlier by the processors' latency,
+        so the echoes keep their timing; delays shorter than the latency come out at the latency. The
+        processors stay owned by the caller; set them from the thread that processes the audio */
+    void setFeedbackInserts(IAudioSignalProcessor* left, IAudioSignalProcessor* right)
+    {
+        feedbackInsert_L = left != nullptr && right != nullptr ? left : nullptr;
+        feedbackInsert_R = feedbackInsert_L != nullptr ? right : nullptr;
+        feedbackInsertLatency = feedbackInsert_L != nullptr ? (double)feedbackInsert_L->getLatencySamples() : 0.0;
+    }
+
+    /** the shorter of the two delay times, in samples */
+    double getMinimumDelayInSamples() const { return fmin(delayInSamples_L, delayInSamples_R); }
+
+    /** switch the kNormal and kPingPong lines between realtime quality (linear interpolation) and render
+        quality (4-point Hermite interpolation, for offline bounces); the two reads are crossfaded over
+        renderQualityCrossfade_mSec, or switched at once if nothing was written since the last flush */
+    void setRenderQuality(bool highQuality)
+    {
+        double target = highQuality ? 1.0 : 0.0;
+        if (target == renderQualityTarget)
+            return;
+
+        renderQualityTarget = target;
+        if (delayBuffer_L.isFlushed() && delayBuffer_R.isFlushed())
+            renderQualityMix = target;
+    }
+
+    /** true while the kNormal or kPingPong lines are held as loops (AudioDelayParameters::freeze) */
+    bool isFrozen() const { return frozen; }
+
+    /** true if render quality is selected (it may still be fading in) */
+    bool getRenderQuality() const { return renderQualityTarget > 0.0; }
+
+    /** get the length of the echo tail in mSec: the time it takes the repeats to decay below the threshold */
+    /**
+    \param silenceThreshold_dB level at which the tail is considered silent
+    \param maxTail_mSec upper limit, used when feedback is at (or above) 100%
+    \return tail length in mSec
+    */
+    double getTailLength_mSec(double silenceThreshold_dB = -96.0, double maxTail_mSec = 30000.0)
+    {
+        if (samplesPerMSec <= 0.0)
+            return 0.0;
+
+        // --- a held loop never decays
+        if (frozen)
+            return maxTail_mSec;
+
+        // --- the longest line sets the spacing of the repeats; reversed segments come out up to twice as late
+        double repeat_mSec = fmax(delayInSamples_L, delayInSamples_R) / samplesPerMSec;
+        if (parameters.algorithm == delayAlgorithm::kReverse)
+            repeat_mSec *= 2.0;
+        double feedback = parameters.feedback_Pct / 100.0;
+
+        // --- multiband: the longest band repeats slowest, the strongest feedback decays slowest
+        if (parameters.algorithm == delayAlgorithm::kMultiband)
+        {
+            repeat_mSec = multiband.getLongestDelay() / samplesPerMSec;
+            feedback = multiband.getLargestFeedback();
+        }
+
+        // --- diffuse and bucket-brigade modes: their lines never get shorter than their minimum
+        if (parameters.algorithm == delayAlgorithm::kFDN)
+            repeat_mSec = fdn.getLongestDelay() / samplesPerMSec;
+        else if (parameters.algorithm == delayAlgorithm::kBBD)
+            repeat_mSec = bbd.getLongestDelay() / samplesPerMSec;
+
+        if (repeat_mSec <= 0.0 || wetMix <= 0.0)
+            return 0.0;
+
+        if (feedback <= 0.0)
+            return repeat_mSec;
+
+        if (feedback >= 1.0)
+            return maxTail_mSec;
+
+        // --- repeat n has amplitude wetMix * feedback^(n-1)
+        double threshold = pow(10.0, silenceThreshold_dB / 20.0);
+        double numRepeats = 1.0 + ceil(log(threshold / wetMix) / log(feedback));
+
+        return fmin(fmax(numRepeats, 1.0) * repeat_mSec, maxTail_mSec);
+    }
+
+    /** bytes allocated for the delay lines of all algorithms */
+    size_t getBufferMemoryBytes() const
+    {
+        return delayBuffer_L.getMemoryBytes() + delayBuffer_R.getMemoryBytes() + fdn.getMemoryBytes() + multiband.getMemoryBytes() +
+               bbd.getMemoryBytes();
+    }
+
+    /** creation function; with the same sample rate and length as before the buffers are kept and only flushed */
     void createDelayBuffers(double _sampleRate, double _bufferLength_mSec)
     {
+        // --- nothing to reallocate: just clear what was written
+        if (bufferLength > 0 && _sampleRate == sampleRate && _bufferLength_mSec == bufferLength_mSec)
+        {
+            reset(sampleRate);
+            return;
+        }
+
         // --- store for math
         bufferLength_mSec = _bufferLength_mSec;
         sampleRate = _sampleRate;
@@ -213,12 +630,624 @@ public:
         // --- total buffer length including fractional part
         bufferLength = (unsigned int)(bufferLength_mSec * (samplesPerMSec)) + 1; // +1 for fractional part
 
-        // --- create new buffer
-        delayBuffer_L.createCircularBuffer(bufferLength);
-        delayBuffer_R.createCircularBuffer(bufferLength);
+        // --- create new buffer, with room for the pitch shift grains to reach back further
+        delayBuffer_L.createCircularBuffer(bufferLength + PitchShiftReader::getReadHeadroom(sampleRate));
+        delayBuffer_R.createCircularBuffer(bufferLength + PitchShiftReader::getReadHeadroom(sampleRate));
+
+        // --- diffuse mode lines
+        fdn.createDelayLines(sampleRate, bufferLength_mSec);
+
+        // --- multiband lanes; band delays longer than the buffer are clamped
+        multiband.createDelayLines(sampleRate, bufferLength_mSec);
+
+        // --- bucket-brigade chips; their length does not depend on the delay time
+        bbd.createDelayLines(sampleRate);
+
+        // --- reversed segments read up to four half-cycles back
+        reverse_L.createWindowTables(bufferLength / 4);
+        reverse_R.createWindowTables(bufferLength / 4);
+
+        // --- pitch shift grains for the new rate
+        pitch_L.createGrains(sampleRate);
+        pitch_R.createGrains(sampleRate);
+
+        // --- ducking detector runs at the new rate
+        ducker.reset(sampleRate);
+        duckGain = 1.0;
+
+        // --- render quality crossfade: new, empty lines need none
+        renderQualityStep = 1.0 / fmax(1.0, renderQualityCrossfade_mSec * samplesPerMSec);
+        renderQualityMix = renderQualityTarget;
+
+        // --- a held freeze loops the new, empty lines
+        frozen = false;
+        updateFreeze();
     }
 
 private:
+    /** pitch shifting works on the read side of the kNormal and kPingPong lines */
+    bool isPitchShifting() const
+    {
+        return parameters.pitchShift_Semitones != 0.0 &&
+               (parameters.algorithm == delayAlgorithm::kNormal || parameters.algorithm == delayAlgorithm::kPingPong);
+    }
+
+    /** capture the lines as loops when freeze is switched on, unroll the loops back into them when it is
+        switched off; only kNormal and kPingPong lines freeze, and only once they exist */
+    void updateFreeze()
+    {
+        bool freeze = parameters.freeze && bufferLength > 0 &&
+                      (parameters.algorithm == delayAlgorithm::kNormal || parameters.algorithm == delayAlgorithm::kPingPong);
+        if (freeze == frozen)
+            return;
+
+        frozen = freeze;
+
+        if (frozen)
+        {
+            // --- the loops start with what the lines would have read next
+            uint32_t crossfadeLength = (uint32_t)(freezeCrossfade_mSec * samplesPerMSec);
+            bool inserts = feedbackInsert_L != nullptr;
+
+            freeze_L.capture(delayBuffer_L, inserts ? getInsertReadDelay(delayInSamples_L) : delayInSamples_L, crossfadeLength);
+            freeze_R.capture(delayBuffer_R, inserts ? getInsertReadDelay(delayInSamples_R) : delayInSamples_R, crossfadeLength);
+        }
+        else
+        {
+            freeze_L.release(delayBuffer_L);
+            freeze_R.release(delayBuffer_R);
+        }
+    }
+
+    /** apply the automation values of one sample, exactly like a per-sample setParameters() call */
+    void applyAutomation(const AudioDelayAutomation& automation, uint32_t i)
+    {
+        AudioDelayParameters automatedParameters = parameters;
+
+        if (automation.leftDelay_mSec) automatedParameters.leftDelay_mSec = automation.leftDelay_mSec[i];
+        if (automation.rightDelay_mSec) automatedParameters.rightDelay_mSec = automation.rightDelay_mSec[i];
+        if (automation.delayRatio_Pct) automatedParameters.delayRatio_Pct = automation.delayRatio_Pct[i];
+        if (automation.feedback_Pct) automatedParameters.feedback_Pct = automation.feedback_Pct[i];
+        if (automation.wetLevel_dB) automatedParameters.wetLevel_dB = automation.wetLevel_dB[i];
+        if (automation.dryLevel_dB) automatedParameters.dryLevel_dB = automation.dryLevel_dB[i];
+
+        setParameters(automatedParameters);
+    }
+
+    /** generic block loop for algorithms without a specialized kernel */
+    void processFrameByFrame(const float* const* inputs, float* const* outputs,
+        uint32_t inputChannels, uint32_t outputChannels, uint32_t numSamples,
+        const AudioDelayAutomation* automation, const float* const* auxInputs, uint32_t auxInputChannels)
+    {
+        for (uint32_t i = 0; i < numSamples; i++)
+        {
+            if (automation)
+                applyAutomation(*automation, i);
+
+            // --- sidechain key; processAudioFrame() keys from the main input itself
+            if (ducker.isActive() && auxInputEnabled)
+            {
+                double key = 0.0;
+                if (auxInputs && auxInputChannels > 0) key = fabs(auxInputs[0][i]);
+                if (auxInputs && auxInputChannels > 1) key = fmax(key, fabs(auxInputs[1][i]));
+
+                processAuxInputAudioSample(key);
+            }
+
+            float inputFrame[2]{ inputs[0][i], inputs[inputChannels > 1 ? 1 : 0][i] };
+            float outputFrame[2];
+
+            processAudioFrame(inputFrame, outputFrame, inputChannels, outputChannels);
+
+            outputs[0][i] = outputFrame[0];
+            if (outputChannels > 1)
+                outputs[1][i] = outputFrame[1];
+        }
+    }
+
+    /** true while the Hermite read is in use, including while it fades in or out */
+    bool isRenderQualityActive() const { return renderQualityMix > 0.0 || renderQualityTarget > 0.0; }
+
+    /** weight of the Hermite read for the next sample; advances the crossfade */
+    double nextRenderQualityWeight()
+    {
+        double weight = renderQualityMix;
+
+        if (renderQualityMix < renderQualityTarget)
+            renderQualityMix = fmin(renderQualityMix + renderQualityStep, renderQualityTarget);
+        else if (renderQualityMix > renderQualityTarget)
+            renderQualityMix = fmax(renderQualityMix - renderQualityStep, renderQualityTarget);
+
+        return weight;
+    }
+
+    /** same for the frame paths: 0 without interpolation or render quality, and the crossfade stands still */
+    double nextRenderQualityWeightIfUsed()
+    {
+        return delayBuffer_L.getInterpolate() && isRenderQualityActive() ? nextRenderQualityWeight() : 0.0;
+    }
+
+    /** read delay of a line behind a feedback insert: the delay less the insert's latency, never negative */
+    double getInsertReadDelay(double delayInSamples) const { return fmax(delayInSamples - feedbackInsertLatency, 0.0); }
+
+    /** clear the feedback inserts with the lines */
+    void resetFeedbackInserts()
+    {
+        if (feedbackInsert_L == nullptr)
+            return;
+
+        feedbackInsert_L->reset(sampleRate);
+        feedbackInsert_R->reset(sampleRate);
+    }
+
+    /** read a kNormal or kPingPong line: linear (or integer), Hermite, or the crossfade between them */
+    static double readDelayLine(CircularBuffer<double>& delayBuffer, double delayInSamples, double renderQualityWeight)
+    {
+        double linear = delayBuffer.readBuffer(delayInSamples);
+        if (renderQualityWeight == 0.0)
+            return linear;
+
+        double hermite = delayBuffer.readBufferHermite(delayInSamples);
+        if (renderQualityWeight == 1.0)
+            return hermite;
+
+        return renderQualityWeight * hermite + (1.0 - renderQualityWeight) * linear;
+    }
+
+    /** read with the interpolation decision made at compile time */
+    template <bool Interpolate>
+    static double readDelay(CircularBuffer<double>& delayBuffer, double delayInSamples, double renderQualityWeight)
+    {
+        if constexpr (Interpolate)
+            return readDelayLine(delayBuffer, delayInSamples, renderQualityWeight);
+        else
+            return delayBuffer.readBuffer((int)delayInSamples);
+    }
+
+    /** how the reads of one static segment are interpolated */
+    enum class segmentQuality { kLinear, kHermite, kCrossfade };
+
+    /** quality of the next numSamples reads; while the crossfade runs its weights go to the scratch
+        arrays and it advances by numSamples, exactly as numSamples nextRenderQualityWeight() calls */
+    segmentQuality prepareSegmentQuality(uint32_t numSamples)
+    {
+        if (!isRenderQualityActive())
+            return segmentQuality::kLinear;
+
+        if (renderQualityMix == renderQualityTarget)
+            return segmentQuality::kHermite;
+
+        for (uint32_t i = 0; i < numSamples; i++)
+        {
+            double weight = nextRenderQualityWeight();
+            scratchHermiteWeight[i] = weight;
+            scratchLinearWeight[i] = 1.0 - weight;
+        }
+
+        return segmentQuality::kCrossfade;
+    }
+
+    /** read a segment of a static delay with the interpolation decision made at compile time */
+    template <bool Interpolate>
+    void readDelaySegment(const DSPKernelTable& kernels, CircularBuffer<double>& delayBuffer, double delayInSamples,
+        double* output, uint32_t numSamples, segmentQuality quality)
+    {
+        int wholeDelay = (int)delayInSamples;
+        delayBuffer.readBlock(wholeDelay, output, numSamples);
+
+        if constexpr (Interpolate)
+        {
+            // --- the sample one OLDER, then the same weighted sum readBuffer() uses
+            double fraction = delayInSamples - wholeDelay;
+            delayBuffer.readBlock(wholeDelay + 1, scratchOlder, numSamples);
+
+            if (quality == segmentQuality::kLinear)
+            {
+                kernels.interpolateBlock(output, scratchOlder, fraction, output, numSamples);
+                return;
+            }
+
+            // --- Hermite also needs one sample NEWER (if it exists, as in readBufferHermite()) and two OLDER
+            if (wholeDelay >= 1)
+                delayBuffer.readBlock(wholeDelay - 1, scratchNewer, numSamples);
+            else
+                std::copy(output, output + numSamples, scratchNewer);
+            delayBuffer.readBlock(wholeDelay + 2, scratchOldest, numSamples);
+
+            if (quality == segmentQuality::kHermite)
+            {
+                kernels.hermiteBlock(scratchNewer, output, scratchOlder, scratchOldest, fraction, output, numSamples);
+                return;
+            }
+
+            // --- crossfade: the same weighted sum readDelayLine() uses
+            kernels.hermiteBlock(scratchNewer, output, scratchOlder, scratchOldest, fraction, scratchHermite, numSamples);
+            kernels.interpolateBlock(output, scratchOlder, fraction, output, numSamples);
+            kernels.crossfadeBlock(scratchHermite, scratchHermiteWeight, output, scratchLinearWeight, output, numSamples);
+        }
+    }
+
+    /** static parameters: within a segment no shorter than the delay, every read comes from samples
+        written before the segment, so reads, feedback, writes and the mix each run as one vector loop */
+    template <bool PingPong, bool CrossFeedback, bool StereoOut, bool StereoIn, bool Interpolate, bool Feedback>
+    void processStaticSegments(const float* const* inputs, float* const* outputs, uint32_t numSamples)
+    {
+        const DSPKernelTable& kernels = DSPKernels::get();
+
+        double feedback = parameters.feedback_Pct / 100.0;
+
+        // --- longest segment that never reads a sample written within it; the Hermite read reaches one sample newer
+        uint32_t newerReach = Interpolate && isRenderQualityActive() ? 1 : 0;
+        uint32_t maxSegmentLength = std::max(1u, (uint32_t)(int)delayInSamples_L + 1 - newerReach);
+        if constexpr (StereoOut)
+            maxSegmentLength = std::min(maxSegmentLength, std::max(1u, (uint32_t)(int)delayInSamples_R + 1 - newerReach));
+        maxSegmentLength = std::min(maxSegmentLength, scratchLength);
+
+        for (uint32_t start = 0; start < numSamples; start += maxSegmentLength)
+        {
+            uint32_t n = std::min(maxSegmentLength, numSamples - start);
+
+            const float* inL = inputs[0] + start;
+            const float* inR = (StereoIn ? inputs[1] : inputs[0]) + start;
+            float* outL = outputs[0] + start;
+            float* outR = (StereoOut ? outputs[1] : outputs[0]) + start;
+
+            // --- one crossfade step per sample, shared by both lines
+            segmentQuality quality = Interpolate ? prepareSegmentQuality(n) : segmentQuality::kLinear;
+
+            readDelaySegment<Interpolate>(kernels, delayBuffer_L, delayInSamples_L, scratchDelayed_L, n, quality);
+            if constexpr (StereoOut)
+                readDelaySegment<Interpolate>(kernels, delayBuffer_R, delayInSamples_R, scratchDelayed_R, n, quality);
+
+            // --- delay line inputs, read before the mix overwrites aliased inputs
+            if constexpr (Feedback)
+                kernels.feedbackBlock(inL, scratchDelayed_L, feedback, scratchInput_L, n);
+            else
+                kernels.convertBlock(inL, scratchInput_L, n);
+
+            if constexpr (StereoOut)
+            {
+                if constexpr (Feedback)
+                    kernels.feedbackBlock(inR, scratchDelayed_R, feedback, scratchInput_R, n);
+                else
+                    kernels.convertBlock(inR, scratchInput_R, n);
+
+                if constexpr (CrossFeedback)
+                    kernels.crossFeedbackBlock(scratchInput_L, scratchInput_R, lineSelfGain, lineCrossGain, n);
+
+                delayBuffer_L.writeBlock(PingPong ? scratchInput_R : scratchInput_L, n);
+                delayBuffer_R.writeBlock(PingPong ? scratchInput_L : scratchInput_R, n);
+
+                // --- right first: with mono in, left output may alias the only input
+                if (blockDuckGain)
+                    kernels.mixGainBlock(inR, scratchDelayed_R, dryMix, wetMix, blockDuckGain + start, outR, n);
+                else
+                    kernels.mixBlock(inR, scratchDelayed_R, dryMix, wetMix, outR, n);
+            }
+            else
+            {
+                delayBuffer_L.writeBlock(scratchInput_L, n);
+            }
+
+            if (blockDuckGain)
+                kernels.mixGainBlock(inL, scratchDelayed_L, dryMix, wetMix, blockDuckGain + start, outL, n);
+            else
+                kernels.mixBlock(inL, scratchDelayed_L, dryMix, wetMix, outL, n);
+        }
+    }
+
+    /** reverse mode with static parameters: parts end at every half-cycle start, so each part only reads
+        samples written before it and reads, feedback, writes and the mix each run as one vector loop */
+    template <bool StereoOut, bool StereoIn>
+    void processReverseSegments(const float* const* inputs, float* const* outputs, uint32_t numSamples,
+        const AudioDelayAutomation*)
+    {
+        const DSPKernelTable& kernels = DSPKernels::get();
+
+        double feedback = parameters.feedback_Pct / 100.0;
+
+        for (uint32_t start = 0; start < numSamples;)
+        {
+            uint32_t n = std::min(numSamples - start, std::min(scratchLength, reverse_L.getSamplesToHalfCycleEnd()));
+            if constexpr (StereoOut)
+                n = std::min(n, reverse_R.getSamplesToHalfCycleEnd());
+
+            const float* inL = inputs[0] + start;
+            const float* inR = (StereoIn ? inputs[1] : inputs[0]) + start;
+            float* outL = outputs[0] + start;
+            float* outR = (StereoOut ? outputs[1] : outputs[0]) + start;
+
+            reverse_L.readBlock(kernels, delayBuffer_L, scratchDelayed_L, scratchOlder, n);
+            kernels.feedbackBlock(inL, scratchDelayed_L, feedback, scratchInput_L, n);
+
+            if constexpr (StereoOut)
+            {
+                reverse_R.readBlock(kernels, delayBuffer_R, scratchDelayed_R, scratchOlder, n);
+                kernels.feedbackBlock(inR, scratchDelayed_R, feedback, scratchInput_R, n);
+
+                delayBuffer_R.writeBlock(scratchInput_R, n);
+
+                // --- right first: with mono in, left output may alias the only input
+                if (blockDuckGain)
+                    kernels.mixGainBlock(inR, scratchDelayed_R, dryMix, wetMix, blockDuckGain + start, outR, n);
+                else
+                    kernels.mixBlock(inR, scratchDelayed_R, dryMix, wetMix, outR, n);
+            }
+
+            delayBuffer_L.writeBlock(scratchInput_L, n);
+
+            if (blockDuckGain)
+                kernels.mixGainBlock(inL, scratchDelayed_L, dryMix, wetMix, blockDuckGain + start, outL, n);
+            else
+                kernels.mixBlock(inL, scratchDelayed_L, dryMix, wetMix, outL, n);
+
+            start += n;
+        }
+    }
+
+    /** multiband mode with static parameters: the crossovers run over each part, then the band lanes,
+        then the mix runs as one vector loop */
+    template <bool StereoOut, bool StereoIn>
+    void processMultibandSegments(const float* const* inputs, float* const* outputs, uint32_t numSamples,
+        const AudioDelayAutomation*)
+    {
+        const DSPKernelTable& kernels = DSPKernels::get();
+
+        for (uint32_t start = 0; start < numSamples; start += scratchLength)
+        {
+            uint32_t n = std::min(scratchLength, numSamples - start);
+
+            const float* inL = inputs[0] + start;
+            const float* inR = (StereoIn ? inputs[1] : inputs[0]) + start;
+            float* outL = outputs[0] + start;
+            float* outR = (StereoOut ? outputs[1] : outputs[0]) + start;
+
+            multiband.processBlock<StereoOut>(inL, inR, scratchDelayed_L, scratchDelayed_R, n);
+
+            if constexpr (StereoOut)
+            {
+                // --- right first: with mono in, left output may alias the only input
+                if (blockDuckGain)
+                    kernels.mixGainBlock(inR, scratchDelayed_R, dryMix, wetMix, blockDuckGain + start, outR, n);
+                else
+                    kernels.mixBlock(inR, scratchDelayed_R, dryMix, wetMix, outR, n);
+            }
+
+            if (blockDuckGain)
+                kernels.mixGainBlock(inL, scratchDelayed_L, dryMix, wetMix, blockDuckGain + start, outL, n);
+            else
+                kernels.mixBlock(inL, scratchDelayed_L, dryMix, wetMix, outL, n);
+        }
+    }
+
+    /** bucket-brigade mode with static parameters: the chips run over each part, then the mix runs as
+        one vector loop */
+    template <bool StereoOut, bool StereoIn>
+    void processBBDSegments(const float* const* inputs, float* const* outputs, uint32_t numSamples,
+        const AudioDelayAutomation*)
+    {
+        const DSPKernelTable& kernels = DSPKernels::get();
+
+        for (uint32_t start = 0; start < numSamples; start += scratchLength)
+        {
+            uint32_t n = std::min(scratchLength, numSamples - start);
+
+            const float* inL = inputs[0] + start;
+            const float* inR = (StereoIn ? inputs[1] : inputs[0]) + start;
+            float* outL = outputs[0] + start;
+            float* outR = (StereoOut ? outputs[1] : outputs[0]) + start;
+
+            bbd.processBlock<StereoOut>(inL, inR, scratchDelayed_L, scratchDelayed_R, n);
+
+            if constexpr (StereoOut)
+            {
+                // --- right first: with mono in, left output may alias the only input
+                if (blockDuckGain)
+                    kernels.mixGainBlock(inR, scratchDelayed_R, dryMix, wetMix, blockDuckGain + start, outR, n);
+                else
+                    kernels.mixBlock(inR, scratchDelayed_R, dryMix, wetMix, outR, n);
+            }
+
+            if (blockDuckGain)
+                kernels.mixGainBlock(inL, scratchDelayed_L, dryMix, wetMix, blockDuckGain + start, outL, n);
+            else
+                kernels.mixBlock(inL, scratchDelayed_L, dryMix, wetMix, outL, n);
+        }
+    }
+
+    /** pitch shifting with static parameters: parts end at every grain start and are no longer than the
+        delay, so each part only reads samples written before it; grain reads, feedback, writes and the
+        mix each run as one vector loop */
+    template <bool PingPong, bool StereoOut, bool StereoIn>
+    void processPitchShiftSegments(const float* const* inputs, float* const* outputs, uint32_t numSamples,
+        const AudioDelayAutomation*)
+    {
+        const DSPKernelTable& kernels = DSPKernels::get();
+
+        double feedback = parameters.feedback_Pct / 100.0;
+
+        uint32_t maxPartLength = std::min(scratchLength, (uint32_t)(int)delayInSamples_L + 1);
+        if constexpr (StereoOut)
+            maxPartLength = std::min(maxPartLength, (uint32_t)(int)delayInSamples_R + 1);
+
+        for (uint32_t start = 0; start < numSamples;)
+        {
+            uint32_t n = std::min(numSamples - start, std::min(maxPartLength, pitch_L.getSamplesToGrainStart()));
+            if constexpr (StereoOut)
+                n = std::min(n, pitch_R.getSamplesToGrainStart());
+
+            const float* inL = inputs[0] + start;
+            const float* inR = (StereoIn ? inputs[1] : inputs[0]) + start;
+            float* outL = outputs[0] + start;
+            float* outR = (StereoOut ? outputs[1] : outputs[0]) + start;
+
+            pitch_L.readBlock(kernels, delayBuffer_L, delayInSamples_L, scratchDelayed_L, n);
+            kernels.feedbackBlock(inL, scratchDelayed_L, feedback, scratchInput_L, n);
+
+            if constexpr (StereoOut)
+            {
+                pitch_R.readBlock(kernels, delayBuffer_R, delayInSamples_R, scratchDelayed_R, n);
+                kernels.feedbackBlock(inR, scratchDelayed_R, feedback, scratchInput_R, n);
+
+                delayBuffer_L.writeBlock(PingPong ? scratchInput_R : scratchInput_L, n);
+                delayBuffer_R.writeBlock(PingPong ? scratchInput_L : scratchInput_R, n);
+
+                // --- right first: with mono in, left output may alias the only input
+                if (blockDuckGain)
+                    kernels.mixGainBlock(inR, scratchDelayed_R, dryMix, wetMix, blockDuckGain + start, outR, n);
+                else
+                    kernels.mixBlock(inR, scratchDelayed_R, dryMix, wetMix, outR, n);
+            }
+            else
+            {
+                delayBuffer_L.writeBlock(scratchInput_L, n);
+            }
+
+            if (blockDuckGain)
+                kernels.mixGainBlock(inL, scratchDelayed_L, dryMix, wetMix, blockDuckGain + start, outL, n);
+            else
+                kernels.mixBlock(inL, scratchDelayed_L, dryMix, wetMix, outL, n);
+
+            start += n;
+        }
+    }
+
+    /** frozen lines: the loops are read as block copies and mixed with the input; nothing is written */
+    template <bool StereoOut, bool StereoIn>
+    void processFrozenSegments(const float* const* inputs, float* const* outputs, uint32_t numSamples,
+        const AudioDelayAutomation*)
+    {
+        const DSPKernelTable& kernels = DSPKernels::get();
+
+        for (uint32_t start = 0; start < numSamples; start += scratchLength)
+        {
+            uint32_t n = std::min(scratchLength, numSamples - start);
+
+            const float* inL = inputs[0] + start;
+            const float* inR = (StereoIn ? inputs[1] : inputs[0]) + start;
+            float* outL = outputs[0] + start;
+            float* outR = (StereoOut ? outputs[1] : outputs[0]) + start;
+
+            freeze_L.readBlock(delayBuffer_L, scratchDelayed_L, n);
+
+            if constexpr (StereoOut)
+            {
+                freeze_R.readBlock(delayBuffer_R, scratchDelayed_R, n);
+
+                // --- right first: with mono in, left output may alias the only input
+                if (blockDuckGain)
+                    kernels.mixGainBlock(inR, scratchDelayed_R, dryMix, wetMix, blockDuckGain + start, outR, n);
+                else
+                    kernels.mixBlock(inR, scratchDelayed_R, dryMix, wetMix, outR, n);
+            }
+
+            if (blockDuckGain)
+                kernels.mixGainBlock(inL, scratchDelayed_L, dryMix, wetMix, blockDuckGain + start, outL, n);
+            else
+                kernels.mixBlock(inL, scratchDelayed_L, dryMix, wetMix, outL, n);
+        }
+    }
+
+    /** the per-sample math of processAudioFrame() with every per-sample decision hoisted into template arguments */
+    template <bool PingPong, bool CrossFeedback, bool StereoOut, bool StereoIn, bool Interpolate, bool Feedback, bool Modulating>
+    void processBlockKernel(const float* const* inputs, float* const* outputs, uint32_t numSamples,
+        const AudioDelayAutomation* automation)
+    {
+        if constexpr (!Modulating)
+        {
+            processStaticSegments<PingPong, CrossFeedback, StereoOut, StereoIn, Interpolate, Feedback>(inputs, outputs, numSamples);
+        }
+        else
+        {
+            processModulatingBlock<PingPong, CrossFeedback, StereoOut, StereoIn, Interpolate, Feedback>(inputs, outputs, numSamples, *automation);
+        }
+    }
+
+    /** modulating parameters: sample by sample, applying the automation before each one */
+    template <bool PingPong, bool CrossFeedback, bool StereoOut, bool StereoIn, bool Interpolate, bool Feedback>
+    void processModulatingBlock(const float* const* inputs, float* const* outputs, uint32_t numSamples,
+        const AudioDelayAutomation& automation)
+    {
+        const float* inL = inputs[0];
+        const float* inR = StereoIn ? inputs[1] : inputs[0];
+        float* outL = outputs[0];
+        float* outR = StereoOut ? outputs[1] : outputs[0];
+
+        for (uint32_t i = 0; i < numSamples; i++)
+        {
+            applyAutomation(automation, i);
+            double feedback = parameters.feedback_Pct / 100.0;
+            double wet = blockDuckGain ? wetMix * blockDuckGain[i] : wetMix;
+            double renderQualityWeight = Interpolate && isRenderQualityActive() ? nextRenderQualityWeight() : 0.0;
+
+            // --- read both inputs first: outputs may alias them
+            double xnL = inL[i];
+            double xnR = inR[i];
+
+            if constexpr (!StereoOut)
+            {
+                // --- mono: same as processAudioSample()
+                double yn = readDelay<Interpolate>(delayBuffer_L, delayInSamples_L, renderQualityWeight);
+                delayBuffer_L.writeBuffer(Feedback ? xnL + feedback * yn : xnL);
+                outL[i] = (float)(dryMix * xnL + wet * yn);
+            }
+            else
+            {
+                double ynL = readDelay<Interpolate>(delayBuffer_L, delayInSamples_L, renderQualityWeight);
+                double ynR = readDelay<Interpolate>(delayBuffer_R, delayInSamples_R, renderQualityWeight);
+
+                double dnL = Feedback ? xnL + feedback * ynL : xnL;
+                double dnR = Feedback ? xnR + feedback * ynR : xnR;
+
+                if constexpr (CrossFeedback)
+                    DSPKernels::crossFeedbackFrame(dnL, dnR, lineSelfGain, lineCrossGain);
+
+                delayBuffer_L.writeBuffer(PingPong ? dnR : dnL);
+                delayBuffer_R.writeBuffer(PingPong ? dnL : dnR);
+
+                outL[i] = (float)(dryMix * xnL + wet * ynL);
+                outR[i] = (float)(dryMix * xnR + wet * ynR);
+            }
+        }
+    }
+
+    using BlockKernel = void (AudioDelay::*)(const float* const*, float* const*, uint32_t, const AudioDelayAutomation*);
+
+    /** kernel for a table index: bit 6 = cross feedback, 5 = ping-pong, 4 = stereo out, 3 = stereo in, 2 = interpolate,
+        1 = feedback, 0 = modulating; cross feedback only exists for stereo out without ping-pong, the other
+        indices with bit 6 share the kernel without it */
+    template <size_t Index>
+    static constexpr BlockKernel kernelForIndex()
+    {
+        return &AudioDelay::processBlockKernel<(Index & 32) != 0, (Index & 64) != 0 && (Index & 48) == 16,
+                                               (Index & 16) != 0, (Index & 8) != 0,
+                                               (Index & 4) != 0, (Index & 2) != 0, (Index & 1) != 0>;
+    }
+
+    template <size_t... Indices>
+    static constexpr std::array<BlockKernel, sizeof...(Indices)> makeKernelTable(std::index_sequence<Indices...>)
+    {
+        return { kernelForIndex<Indices>()... };
+    }
+
+    /** pitch shift kernels, indexed like getKernelTable() >> 3: bit 2 = ping-pong, 1 = stereo out, 0 = stereo in */
+    static const std::array<BlockKernel, 8>& getPitchShiftKernelTable()
+    {
+        static constexpr std::array<BlockKernel, 8> kernelTable{
+            &AudioDelay::processPitchShiftSegments<false, false, false>, &AudioDelay::processPitchShiftSegments<false, false, true>,
+            &AudioDelay::processPitchShiftSegments<false, true, false>, &AudioDelay::processPitchShiftSegments<false, true, true>,
+            &AudioDelay::processPitchShiftSegments<true, false, false>, &AudioDelay::processPitchShiftSegments<true, false, true>,
+            &AudioDelay::processPitchShiftSegments<true, true, false>, &AudioDelay::processPitchShiftSegments<true, true, true> };
+        return kernelTable;
+    }
+
+    /** dispatch table of all kernel variants */
+    static const std::array<BlockKernel, 128>& getKernelTable()
+    {
+        static constexpr std::array<BlockKernel, 128> kernelTable = makeKernelTable(std::make_index_sequence<128>());
+        return kernelTable;
+    }
+
     AudioDelayParameters parameters; ///< object parameters
 
     double sampleRate = 0.0;		///< current sample rate
@@ -229,8 +1258,64 @@ private:
     unsigned int bufferLength = 0;	///< buffer length in samples
     double wetMix = 0.707; ///< wet output default = -3dB
     double dryMix = 0.707; ///< dry output default = -3dB
+    double lineSelfGain = 1.0;	///< cross feedback matrix: share of each line's input kept in its own line
+    double lineCrossGain = 0.0;	///< cross feedback matrix: share written into the other line; 0 = matrix off
+
+    // --- render quality
+    static constexpr double renderQualityCrossfade_mSec = 20.0;	///< length of the switch between the reads
+    double renderQualityTarget = 0.0;	///< 1 = Hermite reads selected, 0 = linear
+    double renderQualityMix = 0.0;		///< current weight of the Hermite reads
+    double renderQualityStep = 1.0;		///< weight change per sample while crossfading
 
     // --- delay buffer of doubles
     CircularBuffer<double> delayBuffer_L;	///< LEFT delay buffer of doubles
     CircularBuffer<double> delayBuffer_R;	///< RIGHT delay buffer of doubles
+
+    // --- block processing scratch
+    static constexpr uint32_t scratchLength = 256;	///< longest segment processed at once
+    double scratchDelayed_L[scratchLength];			///< LEFT delayed signal
+    double scratchDelayed_R[scratchLength];			///< RIGHT delayed signal
+    double scratchInput_L[scratchLength];			///< LEFT delay line input
+    double scratchInput_R[scratchLength];			///< RIGHT delay line input
+    double scratchOlder[scratchLength];				///< one sample older, for interpolation
+    double scratchNewer[scratchLength];				///< one sample newer, for Hermite interpolation
+    double scratchOldest[scratchLength];			///< two samples older, for Hermite interpolation
+    double scratchHermite[scratchLength];			///< Hermite reads while crossfading
+    double scratchHermiteWeight[scratchLength];		///< crossfade weight of the Hermite reads
+    double scratchLinearWeight[scratchLength];		///< crossfade weight of the linear reads
+    double scratchDuckGain[scratchLength];			///< wet gain per sample while ducking
+    const double* blockDuckGain = nullptr;			///< wet gain curve of the part being processed; nullptr = no ducking
+
+    // --- diffuse mode
+    FeedbackDelayNetwork fdn;				///< lines for delayAlgorithm::kFDN
+
+    // --- multiband mode
+    MultibandDelay multiband;				///< band lanes for delayAlgorithm::kMultiband
+
+    // --- bucket-brigade mode
+    BBDDelay bbd;							///< chips for delayAlgorithm::kBBD
+
+    // --- feedback inserts
+    IAudioSignalProcessor* feedbackInsert_L = nullptr;	///< LEFT line's feedback processor, not owned; nullptr = none
+    IAudioSignalProcessor* feedbackInsert_R = nullptr;	///< RIGHT line's feedback processor, not owned
+    double feedbackInsertLatency = 0.0;					///< samples the inserts delay their input
+
+    // --- freeze
+    static constexpr double freezeCrossfade_mSec = 10.0;	///< loop seam crossfade
+    FreezeLoopReader freeze_L;				///< LEFT loop while frozen
+    FreezeLoopReader freeze_R;				///< RIGHT loop while frozen
+    bool frozen = false;					///< the lines are held as loops
+
+    // --- reverse mode
+    ReverseSegmentReader reverse_L;			///< LEFT backwards reader for delayAlgorithm::kReverse
+    ReverseSegmentReader reverse_R;			///< RIGHT backwards reader for delayAlgorithm::kReverse
+
+    // --- pitch shifting
+    PitchShiftReader pitch_L;				///< LEFT grain reader
+    PitchShiftReader pitch_R;				///< RIGHT grain reader
+
+    // --- wet ducking
+    AudioDucker ducker;						///< block-rate envelope follower
+    double duckGain = 1.0;					///< wet gain of the current sample
+    bool auxInputEnabled = false;			///< key from the aux input instead of the main input
 };
\ No newline at end of file
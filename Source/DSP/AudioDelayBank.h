@@ -0,0 +1,319 @@
+// AudioDelayBank.h
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "AudioDelayParameters.h"
+#include "DSPKernels.h"
+#include "DSPUtils.h"
+
+/**
+\class AudioDelayBank
+\ingroup FX-Objects
+\brief
+The AudioDelayBank object runs NumLanes (4, 8 or 16) independent stereo delays together, for engines
+that run thousands of delays (one per voice or stream) and lose most of their time to per-instance
+overhead and to short delays that cannot be processed in long blocks.
+
+- Structure of arrays: the 2 * NumLanes lines share one allocation and one write index; per-lane
+  delay times, feedback, levels and algorithms live in arrays (DelayBankLanes), not in objects.
+- When every delay is at least minSegmentLength samples, the block is cut into segments no longer
+  than the shortest delay and each line is processed a segment at a time with the block kernels,
+  vectorized along time like AudioDelay's static path, but with no per-instance dispatch.
+- Shorter delays leave segments too short to vectorize along time; then all lanes are processed one
+  sample at a time, vectorized across lanes (DSPKernelTable::delayBankBlock(), reads are gathers
+  where the compiler's tuning emits them).
+  This is where a bank gains most over separate AudioDelay objects.
+- Every lane is bit-identical to an AudioDelay processing stereo frames with the same parameters:
+  kNormal and kPingPong with linear interpolation. Other algorithms, ducking, pitch shifting and cross
+  feedback are not lane-parallel; setParameters() rejects them.
+- Parameters are per block: a new delay time takes effect with the next processAudioBlock() call,
+  as in AudioDelay without per-sample automation.
+
+Audio I/O:
+- Stereo in, stereo out per lane; inputs[2 * lane] is the left channel of a lane, inputs[2 * lane + 1]
+  its right channel, and the same for outputs. In-place processing is fine.
+*/
+template <uint32_t NumLanes>
+class AudioDelayBank
+{
+    static_assert(NumLanes == 4 || NumLanes == 8 || NumLanes == 16, "AudioDelayBank runs 4, 8 or 16 lanes");
+
+public:
+    AudioDelayBank()									/* C-TOR */
+    {
+        lanes.numLanes = NumLanes;
+
+        // --- AudioDelay's defaults: -3dB, recomputed only when a level changes
+        for (uint32_t l = 0; l < numLines; l++)
+        {
+            lanes.dryMix[l] = 0.707;
+            lanes.wetMix[l] = 0.707;
+        }
+    }
+    ~AudioDelayBank() {}								/* D-TOR */
+
+    static constexpr uint32_t numLanes = NumLanes;
+    static constexpr uint32_t numLines = 2 * NumLanes;
+    static constexpr uint32_t scratchLength = 256;		///< longest segment processed at once
+    static constexpr uint32_t minSegmentLength = 32;	///< shorter segments go through the lane-parallel kernel
+    static constexpr uint32_t linePadding = 24;			///< doubles between lines: power-of-two strides put every line in the same cache sets
+
+    /** creation function; with the same sample rate and length as before the lines are kept and only flushed */
+    void createDelayBuffers(double _sampleRate, double _bufferLength_mSec)
+    {
+        if (lineMemory && _sampleRate == sampleRate && _bufferLength_mSec == bufferLength_mSec)
+        {
+            reset();
+            return;
+        }
+
+        sampleRate = _sampleRate;
+        bufferLength_mSec = _bufferLength_mSec;
+        samplesPerMSec = sampleRate / 1000.0;
+
+        // --- power of two per line, with room for the interpolation's older sample
+        unsigned int maxDelayInSamples = (unsigned int)(bufferLength_mSec * samplesPerMSec) + 1;
+        lineLength = 1;
+        while (lineLength < maxDelayInSamples + 2)
+            lineLength <<= 1;
+
+        lineMemory = allocateZeroed<double>((size_t)(lineLength + linePadding) * numLines);
+
+        // --- the new lines are all zeros: nothing to flush
+        lanes.lines = lineMemory.get();
+        lanes.wrapMask = lineLength - 1;
+        lanes.writeIndex = 0;
+        wrapped = false;
+
+        for (uint32_t l = 0; l < numLines; l++)
+            lanes.lineOffset[l] = l * (lineLength + linePadding);
+
+        for (uint32_t lane = 0; lane < NumLanes; lane++)
+            updateLane(lane);
+    }
+
+    /** clear every lane; only what was written since the last flush is touched */
+    void reset()
+    {
+        unsigned int written = wrapped ? lineLength : lanes.writeIndex;
+        if (lineMemory && written > 0)
+        {
+            for (uint32_t l = 0; l < numLines; l++)
+                memset(lineMemory.get() + lanes.lineOffset[l], 0, (size_t)written * sizeof(double));
+        }
+
+        lanes.writeIndex = 0;
+        wrapped = false;
+    }
+
+    /** set the parameters of one lane; returns false (and changes nothing) if the lane cannot run them:
+        an algorithm other than kNormal or kPingPong, ducking, pitch shifting or cross feedback */
+    bool setParameters(uint32_t lane, const AudioDelayParameters& _parameters)
+    {
+        if (lane >= NumLanes)
+            return false;
+
+        if ((_parameters.algorithm != delayAlgorithm::kNormal && _parameters.algorithm != delayAlgorithm::kPingPong) ||
+            _parameters.duckDepth_dB > 0.0 || _parameters.pitchShift_Semitones != 0.0 ||
+            (_parameters.algorithm == delayAlgorithm::kNormal && _parameters.crossFeedback_Pct > 0.0))
+            return false;
+
+        // --- levels as in AudioDelay::setParameters(): only a changed level is recomputed
+        for (uint32_t line = lane; line < numLines; line += NumLanes)
+        {
+            if (_parameters.dryLevel_dB != parameters[lane].dryLevel_dB)
+                lanes.dryMix[line] = pow(10.0, _parameters.dryLevel_dB / 20.0);
+            if (_parameters.wetLevel_dB != parameters[lane].wetLevel_dB)
+                lanes.wetMix[line] = pow(10.0, _parameters.wetLevel_dB / 20.0);
+        }
+
+        parameters[lane] = _parameters;
+        updateLane(lane);
+        return true;
+    }
+
+    /** the parameters of one lane */
+    AudioDelayParameters getParameters(uint32_t lane) const { return parameters[lane < NumLanes ? lane : 0]; }
+
+    /** process numSamples samples through every lane */
+    /**
+    \param inputs 2 * NumLanes channels: left and right of lane 0, then of lane 1, ...
+    \param outputs 2 * NumLanes channels in the same order; may be the inputs
+    \param numSamples samples per channel
+    */
+    void processAudioBlock(const float* const* inputs, float* const* outputs, uint32_t numSamples)
+    {
+        if (!lineMemory)
+            return;
+
+        const DSPKernelTable& kernels = DSPKernels::get();
+
+        // --- a segment may not read what it writes: no longer than the shortest delay + 1
+        uint32_t maxSegmentLength = std::min(shortestDelay + 1, scratchLength);
+
+        for (uint32_t start = 0; start < numSamples; )
+        {
+            uint32_t n = std::min(maxSegmentLength >= minSegmentLength ? maxSegmentLength : scratchLength, numSamples - start);
+
+            if (lanes.writeIndex + n >= lineLength)
+                wrapped = true;
+
+            if (maxSegmentLength >= minSegmentLength)
+                processSegment(kernels, inputs, outputs, start, n);
+            else
+                processFrames(kernels, inputs, outputs, start, n);
+
+            start += n;
+        }
+    }
+
+    /** bytes allocated for the lines */
+    size_t getBufferMemoryBytes() const { return lineMemory ? (size_t)(lineLength + linePadding) * numLines * sizeof(double) : 0; }
+
+private:
+    /** derive the delays and feedback of one lane, the same way AudioDelay::setParameters() does */
+    void updateLane(uint32_t lane)
+    {
+        const AudioDelayParameters& p = parameters[lane];
+
+        double delayInSamples_L = 0.0, delayInSamples_R = 0.0;
+        if (p.updateType == delayUpdateType::kLeftAndRight)
+        {
+            delayInSamples_L = p.leftDelay_mSec * (samplesPerMSec);
+            delayInSamples_R = p.rightDelay_mSec * (samplesPerMSec);
+        }
+        else if (p.updateType == delayUpdateType::kLeftPlusRatio)
+        {
+            double delayRatio = p.delayRatio_Pct / 100.0;
+            boundValue(delayRatio, 0.0, 1.0);
+
+            delayInSamples_L = p.leftDelay_mSec * (samplesPerMSec);
+            delayInSamples_R = delayInSamples_L * delayRatio;
+        }
+
+        // --- delays past the line length are clamped instead of reading the wrong samples
+        double longest = (double)(lineLength > 2 ? lineLength - 2 : 0);
+        double delays[2] = { std::min(delayInSamples_L, longest), std::min(delayInSamples_R, longest) };
+
+        for (uint32_t ch = 0; ch < 2; ch++)
+        {
+            uint32_t line = lane + ch * NumLanes;
+            lanes.delayWhole[line] = (uint32_t)(int)delays[ch];
+            lanes.delayFraction[line] = delays[ch] - (int)delays[ch];
+            lanes.feedback[line] = p.feedback_Pct / 100.0;
+        }
+
+        bool crossFeed = p.algorithm == delayAlgorithm::kPingPong;
+        lanes.writeOffset[lane] = lanes.lineOffset[crossFeed ? lane + NumLanes : lane];
+        lanes.writeOffset[lane + NumLanes] = lanes.lineOffset[crossFeed ? lane : lane + NumLanes];
+
+        // --- the interpolated read reaches one sample further back, never forward
+        shortestDelay = lanes.delayWhole[0];
+        for (uint32_t l = 1; l < numLines; l++)
+            shortestDelay = std::min(shortestDelay, lanes.delayWhole[l]);
+    }
+
+    /** copy numSamples consecutive samples of a line, starting delayInSamples behind the newest one */
+    void readLine(uint32_t line, uint32_t delayInSamples, double* output, uint32_t numSamples) const
+    {
+        const double* source = lineMemory.get() + lanes.lineOffset[line];
+        uint32_t readIndex = (lanes.writeIndex - 1 - delayInSamples) & lanes.wrapMask;
+
+        uint32_t firstPart = std::min(numSamples, lineLength - readIndex);
+        memcpy(output, source + readIndex, firstPart * sizeof(double));
+        memcpy(output + firstPart, source, (numSamples - firstPart) * sizeof(double));
+    }
+
+    /** write numSamples samples at the write index of the line a line feeds */
+    void writeLine(uint32_t line, const double* input, uint32_t numSamples)
+    {
+        double* destination = lineMemory.get() + lanes.writeOffset[line];
+
+        uint32_t firstPart = std::min(numSamples, lineLength - lanes.writeIndex);
+        memcpy(destination + lanes.writeIndex, input, firstPart * sizeof(double));
+        memcpy(destination, input + firstPart, (numSamples - firstPart) * sizeof(double));
+    }
+
+    /** one segment, line by line along time; numSamples <= shortestDelay + 1 */
+    void processSegment(const DSPKernelTable& kernels, const float* const* inputs, float* const* outputs,
+                        uint32_t start, uint32_t numSamples)
+    {
+        for (uint32_t lane = 0; lane < NumLanes; lane++)
+        {
+            const float* in[2] = { inputs[2 * lane] + start, inputs[2 * lane + 1] + start };
+            double* delayed[2] = { scratchDelayed_L, scratchDelayed_R };
+            double* lineInput[2] = { scratchInput_L, scratchInput_R };
+
+            // --- read both lines, then write both: ping-pong feeds each line from the other
+            for (uint32_t ch = 0; ch < 2; ch++)
+            {
+                uint32_t line = lane + ch * NumLanes;
+                readLine(line, lanes.delayWhole[line], delayed[ch], numSamples);
+                readLine(line, lanes.delayWhole[line] + 1, scratchOlder, numSamples);
+                kernels.interpolateBlock(delayed[ch], scratchOlder, lanes.delayFraction[line], delayed[ch], numSamples);
+                kernels.feedbackBlock(in[ch], delayed[ch], lanes.feedback[line], lineInput[ch], numSamples);
+            }
+
+            writeLine(lane, lineInput[0], numSamples);
+            writeLine(lane + NumLanes, lineInput[1], numSamples);
+
+            for (uint32_t ch = 0; ch < 2; ch++)
+            {
+                uint32_t line = lane + ch * NumLanes;
+                kernels.mixBlock(in[ch], delayed[ch], lanes.dryMix[line], lanes.wetMix[line],
+                                 outputs[2 * lane + ch] + start, numSamples);
+            }
+        }
+
+        lanes.writeIndex = (lanes.writeIndex + numSamples) & lanes.wrapMask;
+    }
+
+    /** numSamples frames, all lanes at once: channels to frames, the lane kernel, frames back to channels */
+    void processFrames(const DSPKernelTable& kernels, const float* const* inputs, float* const* outputs,
+                       uint32_t start, uint32_t numSamples)
+    {
+        for (uint32_t line = 0; line < numLines; line++)
+        {
+            const float* in = inputs[2 * (line % NumLanes) + line / NumLanes] + start;
+            for (uint32_t i = 0; i < numSamples; i++)
+                scratchFrameInput[i * numLines + line] = in[i];
+        }
+
+        kernels.delayBankBlock(lanes, scratchFrameInput, scratchFrameOutput, numSamples);
+
+        for (uint32_t line = 0; line < numLines; line++)
+        {
+            float* out = outputs[2 * (line % NumLanes) + line / NumLanes] + start;
+            for (uint32_t i = 0; i < numSamples; i++)
+                out[i] = scratchFrameOutput[i * numLines + line];
+        }
+    }
+
+    AudioDelayParameters parameters[NumLanes];	///< per-lane parameters
+
+    DelayBankLanes lanes;						///< kernel state: lines, write index and per-line settings
+    ZeroedArray<double> lineMemory = nullptr;	///< numLines lines of lineLength doubles, linePadding apart
+    unsigned int lineLength = 0;				///< samples per line, a power of two
+    uint32_t shortestDelay = 0;					///< shortest whole delay of all lines
+    bool wrapped = false;						///< every sample of the lines may be non-zero
+
+    double sampleRate = 0.0;					///< current sample rate
+    double samplesPerMSec = 0.0;				///< samples per millisecond
+    double bufferLength_mSec = 0.0;				///< longest delay in mSec
+
+    // --- segment scratch
+    double scratchDelayed_L[scratchLength];		///< LEFT delayed signal
+    double scratchDelayed_R[scratchLength];		///< RIGHT delayed signal
+    double scratchInput_L[scratchLength];		///< LEFT line input
+    double scratchInput_R[scratchLength];		///< RIGHT line input
+    double scratchOlder[scratchLength];			///< one sample older, for interpolation
+
+    // --- frame scratch for the lane kernel
+    float scratchFrameInput[scratchLength * numLines];	///< input frames
+    float scratchFrameOutput[scratchLength * numLines];	///< output frames
+};
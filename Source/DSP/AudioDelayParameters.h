@@ -2,7 +2,7 @@
 
 #pragma once
 
-#include <JuceHeader.h>
+#include <cstdint>
 
 #include "DSPUtils.h"
 
@@ -30,12 +30,34 @@ struct AudioDelayParameters
         wetLevel_dB = params.wetLevel_dB;
         dryLevel_dB = params.dryLevel_dB;
         feedback_Pct = params.feedback_Pct;
+        crossFeedback_Pct = params.crossFeedback_Pct;
 
         updateType = params.updateType;
         leftDelay_mSec = params.leftDelay_mSec;
         rightDelay_mSec = params.rightDelay_mSec;
         delayRatio_Pct = params.delayRatio_Pct;
 
+        fdnDamping_Pct = params.fdnDamping_Pct;
+
+        duckThreshold_dB = params.duckThreshold_dB;
+        duckDepth_dB = params.duckDepth_dB;
+        duckAttack_mSec = params.duckAttack_mSec;
+        duckRelease_mSec = params.duckRelease_mSec;
+
+        pitchShift_Semitones = params.pitchShift_Semitones;
+
+        freeze = params.freeze;
+
+        multibandNumBands = params.multibandNumBands;
+        for (int i = 0; i < 3; i++)
+            multibandCrossover_Hz[i] = params.multibandCrossover_Hz[i];
+        for (int i = 0; i < 4; i++)
+        {
+            multibandDelay_Pct[i] = params.multibandDelay_Pct[i];
+            multibandFeedback_Pct[i] = params.multibandFeedback_Pct[i];
+            multibandLevel_dB[i] = params.multibandLevel_dB[i];
+        }
+
         return *this;
     }
 
@@ -44,9 +66,69 @@ struct AudioDelayParameters
     double wetLevel_dB = -3.0;	///< wet output level in dB
     double dryLevel_dB = -3.0;	///< dry output level in dB
     double feedback_Pct = 0.0;	///< feedback as a % value
+    double crossFeedback_Pct = 0.0;	///< kNormal: % of each line's input (input + feedback) written into the other line; 0 = separate lines, 100 = kPingPong
 
     delayUpdateType updateType = delayUpdateType::kLeftAndRight;///< update algorithm
     double leftDelay_mSec = 0.0;	///< left delay time
     double rightDelay_mSec = 0.0;	///< right delay time
     double delayRatio_Pct = 100.0;	///< dela ratio: right length = (delayRatio)*(left length)
+
+    double fdnDamping_Pct = 0.0;	///< high frequency damping of the kFDN lines as a % value
+
+    double duckThreshold_dB = -30.0;	///< key level where wet ducking starts
+    double duckDepth_dB = 0.0;			///< maximum wet gain reduction in dB; 0 = ducking off
+    double duckAttack_mSec = 10.0;		///< ducking envelope attack time
+    double duckRelease_mSec = 250.0;	///< ducking envelope release time
+
+    double pitchShift_Semitones = 0.0;	///< pitch shift of the delayed signal (kNormal, kPingPong); 0 = off
+
+    bool freeze = false;	///< hold the delay lines as an endless loop, input and feedback off (kNormal, kPingPong)
+
+    int multibandNumBands = 3;										///< kMultiband: number of bands, 2 - 4
+    double multibandCrossover_Hz[3] = { 250.0, 2500.0, 8000.0 };	///< kMultiband: band edges, ascending; the first numBands - 1 are used
+    double multibandDelay_Pct[4] = { 100.0, 75.0, 50.0, 25.0 };	///< kMultiband: band delay as a % of the channel's delay time
+    double multibandFeedback_Pct[4] = { 60.0, 50.0, 40.0, 30.0 };	///< kMultiband: band feedback as a % value
+    double multibandLevel_dB[4] = { 0.0, 0.0, 0.0, 0.0 };			///< kMultiband: band output level in dB
+};
+
+/**
+\struct AudioDelayAutomation
+\ingroup FX-Objects
+\brief
+Per-sample parameter curves for one block passed to AudioDelay::processAudioBlock().
+
+Each pointer is either nullptr (the parameter stays at its current value for the whole block)
+or an array with one value per sample of the block. Values are applied exactly as if
+setParameters() had been called before each sample.
+*/
+struct AudioDelayAutomation
+{
+    const float* leftDelay_mSec = nullptr;	///< left delay time curve
+    const float* rightDelay_mSec = nullptr;	///< right delay time curve
+    const float* delayRatio_Pct = nullptr;	///< delay ratio curve
+    const float* feedback_Pct = nullptr;	///< feedback curve
+    const float* wetLevel_dB = nullptr;		///< wet level curve
+    const float* dryLevel_dB = nullptr;		///< dry level curve
+
+    /** true if no parameter changes during the block */
+    bool isStatic() const
+    {
+        return leftDelay_mSec == nullptr && rightDelay_mSec == nullptr && delayRatio_Pct == nullptr &&
+               feedback_Pct == nullptr && wetLevel_dB == nullptr && dryLevel_dB == nullptr;
+    }
+
+    /** the same curves starting numSamples later, for processing a block in parts */
+    AudioDelayAutomation offsetBy(uint32_t numSamples) const
+    {
+        auto offset = [numSamples](const float* curve) { return curve ? curve + numSamples : nullptr; };
+
+        AudioDelayAutomation result;
+        result.leftDelay_mSec = offset(leftDelay_mSec);
+        result.rightDelay_mSec = offset(rightDelay_mSec);
+        result.delayRatio_Pct = offset(delayRatio_Pct);
+        result.feedback_Pct = offset(feedback_Pct);
+        result.wetLevel_dB = offset(wetLevel_dB);
+        result.dryLevel_dB = offset(dryLevel_dB);
+        return result;
+    }
 };
\ No newline at end of file
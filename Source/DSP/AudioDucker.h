@@ -0,0 +1,174 @@
+// AudioDucker.h
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "DSPKernels.h"
+#include "DSPUtils.h"
+
+/**
+\class AudioDucker
+\ingroup FX-Objects
+\brief
+The AudioDucker object computes a gain that ducks a signal while a key signal is above a threshold;
+AudioDelay uses it to duck its wet signal from a sidechain or from its own input.
+
+- The detector runs at block rate: the peak of the key over each detection period of periodLength
+  samples drives an attack/release envelope, so the per-sample work is a vectorized peak scan and
+  a gain ramp.
+- The gain ramps linearly from one period's value to the next over the following period, so
+  ducking is click-free and one period (0.7 mSec at 48 kHz) late.
+- Periods are counted in samples, not host blocks: per-sample and block processing give identical
+  gains for any block size.
+- Gain reduction is the envelope level above the threshold, limited to the depth.
+*/
+class AudioDucker
+{
+public:
+    AudioDucker()		/* C-TOR */
+    {
+        for (uint32_t i = 0; i < periodLength; i++)
+            rampTable[i] = (double)(i + 1) / periodLength;
+    }
+    ~AudioDucker() {}	/* D-TOR */
+
+    static constexpr uint32_t periodLength = 32;	///< detection period in samples
+
+    /** reset the detector; the gain returns to unity */
+    void reset(double _sampleRate)
+    {
+        sampleRate = _sampleRate;
+        resetState();
+        updateCoefficients();
+    }
+
+    /** set the detector parameters; depth_dB = 0 turns ducking off */
+    void setParameters(double _threshold_dB, double _depth_dB, double _attack_mSec, double _release_mSec)
+    {
+        // --- start from unity gain whenever ducking is switched on
+        if (!isActive() && _depth_dB > 0.0)
+            resetState();
+
+        threshold_dB = _threshold_dB;
+        depth_dB = _depth_dB;
+
+        if (_attack_mSec != attack_mSec || _release_mSec != release_mSec)
+        {
+            attack_mSec = _attack_mSec;
+            release_mSec = _release_mSec;
+            updateCoefficients();
+        }
+    }
+
+    /** true if the depth is above 0 dB */
+    bool isActive() const { return depth_dB > 0.0; }
+
+    /** feed one key sample and return the gain for this sample */
+    double processKeySample(double xn)
+    {
+        double gain = gainStart + (gainEnd - gainStart) * rampTable[position];
+
+        float magnitude = std::fabs((float)xn);
+        peak = magnitude > peak ? magnitude : peak;
+
+        if (++position == periodLength)
+            endPeriod();
+
+        return gain;
+    }
+
+    /** feed a block of key samples and write the gain for each sample; same as numSamples calls to
+        processKeySample() with max(|key0[i]|, |key1[i]|)
+    \param key0 first key channel; nullptr for a silent key
+    \param key1 second key channel; nullptr for a mono key
+    */
+    void processKeyBlock(const float* key0, const float* key1, double* gains, uint32_t numSamples)
+    {
+        const DSPKernelTable& kernels = DSPKernels::get();
+
+        for (uint32_t start = 0; start < numSamples;)
+        {
+            // --- up to the end of the current detection period
+            uint32_t n = std::min(numSamples - start, periodLength - position);
+
+            double delta = gainEnd - gainStart;
+            for (uint32_t i = 0; i < n; i++)
+                gains[start + i] = gainStart + delta * rampTable[position + i];
+
+            if (key0)
+            {
+                float blockPeak = kernels.peakBlock(key0 + start, n);
+                peak = blockPeak > peak ? blockPeak : peak;
+            }
+            if (key1)
+            {
+                float blockPeak = kernels.peakBlock(key1 + start, n);
+                peak = blockPeak > peak ? blockPeak : peak;
+            }
+
+            position += n;
+            start += n;
+
+            if (position == periodLength)
+                endPeriod();
+        }
+    }
+
+private:
+    /** update the envelope from the period's peak and set the gain the next period ramps to */
+    void endPeriod()
+    {
+        double coefficient = peak > envelope ? attackCoefficient : releaseCoefficient;
+        envelope = peak + coefficient * (envelope - peak);
+
+        double reduction_dB = 0.0;
+        if (envelope > 0.0)
+        {
+            reduction_dB = 20.0 * log10(envelope) - threshold_dB;
+            boundValue(reduction_dB, 0.0, depth_dB);
+        }
+
+        gainStart = gainEnd;
+        gainEnd = reduction_dB > 0.0 ? pow(10.0, -reduction_dB / 20.0) : 1.0;
+
+        peak = 0.0f;
+        position = 0;
+    }
+
+    void resetState()
+    {
+        envelope = 0.0;
+        peak = 0.0f;
+        position = 0;
+        gainStart = 1.0;
+        gainEnd = 1.0;
+    }
+
+    /** one-pole coefficients at the period rate */
+    void updateCoefficients()
+    {
+        double periodsPerMSec = sampleRate / 1000.0 / periodLength;
+
+        attackCoefficient = attack_mSec > 0.0 && periodsPerMSec > 0.0 ? exp(-1.0 / (attack_mSec * periodsPerMSec)) : 0.0;
+        releaseCoefficient = release_mSec > 0.0 && periodsPerMSec > 0.0 ? exp(-1.0 / (release_mSec * periodsPerMSec)) : 0.0;
+    }
+
+    double rampTable[periodLength];		///< (i + 1) / periodLength
+
+    double sampleRate = 0.0;			///< current sample rate
+    double threshold_dB = -30.0;		///< key level where ducking starts
+    double depth_dB = 0.0;				///< maximum gain reduction; 0 = off
+    double attack_mSec = 10.0;			///< envelope attack time
+    double release_mSec = 250.0;		///< envelope release time
+    double attackCoefficient = 0.0;		///< attack one-pole coefficient per period
+    double releaseCoefficient = 0.0;	///< release one-pole coefficient per period
+
+    double envelope = 0.0;				///< key envelope, linear
+    float peak = 0.0f;					///< key peak of the current period
+    uint32_t position = 0;				///< sample position within the current period
+    double gainStart = 1.0;				///< gain at the start of the current period's ramp
+    double gainEnd = 1.0;				///< gain at the end of the current period's ramp
+};
@@ -0,0 +1,435 @@
+// BBDDelay.h
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "DSPUtils.h"
+
+/**
+\class BBDDelay
+\ingroup FX-Objects
+\brief
+The BBDDelay object models a bucket-brigade (BBD) analog delay: a chip of numBuckets charge buckets
+clocked by a virtual clock, between a compressor and anti-aliasing filter on the way in and a
+reconstruction filter and expander on the way out. The delay time sets the clock, so changing it
+bends the pitch of the repeats and longer delays get darker, like the hardware.
+
+- Clock: delay = inputLatency + (numBuckets + outputLatency) / clock. The chip has maxNumBuckets
+  buckets (an MN3005 has 4096 stages); delays too short for the clock limit (maxClockRatio times
+  the sample rate) use a shorter chip, halving the bucket count as needed. The clock, the bucket
+  count and the filters are updated every controlInterval samples; between updates the clock is
+  steady, so the resampler works on blocks of evenly spaced ticks. The filters add their group
+  delay on top, as in the hardware: a few samples, about 2 ms at a 2 second delay.
+- Resampling: every clock tick samples the filtered input at the tick's time, and every output
+  sample reads the bucket stream at its position in clock ticks. Both are windowed sinc
+  interpolations from one precomputed polyphase table (numPhases phases of numTaps taps,
+  coefficients interpolated between neighbouring phases); nothing is evaluated per sample.
+- Filters: 2nd order Butterworth lowpass in front of and behind the chip, at filterCutoffRatio
+  of the clock (capped below Nyquist). Aliasing when the clock is below the sample rate is what
+  the hardware does too; the filters only keep it down to the same degree.
+- Companding: a 2:1 compressor before the chip and a 1:2 expander after it, each with a
+  compandorTime_mSec envelope; their mistracking around transients is the BBD breathing. Buckets
+  saturate softly above the compressor's reference level.
+- Feedback goes from the expander's output back to the compressor's input.
+
+processBlock() produces exactly the same output as processAudioFrame() on each frame: segments
+never cross a control update and are never longer than the chip, so an output sample never reads
+a bucket written in the same segment.
+
+Audio I/O:
+- Processes stereo (one chip per channel) or mono (left chip only).
+- The outputs are the delayed signals; AudioDelay mixes them with the dry signal.
+*/
+class BBDDelay
+{
+public:
+    BBDDelay() {}		/* C-TOR */
+    ~BBDDelay() {}		/* D-TOR */
+
+    static constexpr uint32_t numTaps = 8;					///< interpolation kernel length
+    static constexpr uint32_t numPhases = 64;				///< kernel phases per sample
+    static constexpr uint32_t maxNumBuckets = 2048;			///< buckets of the full chip (4096 stages)
+    static constexpr uint32_t minNumBuckets = 16;			///< shortest chip for very short delays
+    static constexpr double maxClockRatio = 2.0;			///< highest clock, in multiples of the sample rate
+    static constexpr double filterCutoffRatio = 0.4;		///< filter cutoff as a fraction of the clock
+    static constexpr uint32_t controlInterval = 32;			///< samples between clock and filter updates
+    static constexpr double compandorReference = 0.25;		///< level the compressor and expander leave unchanged
+    static constexpr double compandorFloor = 0.001;			///< lowest envelope: at most 24 dB of compressor gain
+    static constexpr double compandorTime_mSec = 10.0;		///< compressor and expander envelope time constant
+    static constexpr uint32_t scratchLength = 256;			///< longest block processBlock() takes
+
+    static constexpr double inputLatency = numTaps / 2;		///< samples between the input and its tick
+    static constexpr double outputLatency = numTaps / 2;	///< ticks between a bucket and its output
+    static constexpr double minDelay = inputLatency + (minNumBuckets + outputLatency) / maxClockRatio;	///< shortest delay in samples
+
+    /** allocate the chips; do NOT call from realtime audio thread */
+    void createDelayLines(double _sampleRate)
+    {
+        sampleRate = _sampleRate;
+        envelopeCoefficient = 1.0 - exp(-1.0 / (compandorTime_mSec * sampleRate / 1000.0));
+
+        // --- the table is shared by every instance; build it here, not on the audio thread
+        getKernelTable();
+
+        memory = allocateZeroed<double>((size_t)2 * (bucketRingLength + historyLength));
+        for (int ch = 0; ch < 2; ch++)
+        {
+            chips[ch].buckets = memory.get() + (size_t)ch * (bucketRingLength + historyLength);
+            chips[ch].history = chips[ch].buckets + bucketRingLength;
+        }
+
+        // --- the new chips are all zeros: nothing to flush
+        wrapped = false;
+        resetStates();
+    }
+
+    /** clear the chips, filters and envelopes */
+    void flush()
+    {
+        if (!memory)
+            return;
+
+        // --- unused chips hold nothing
+        if (wrapped || chips[0].tickCount > 0 || chips[1].tickCount > 0 || chips[0].historyCount > 0)
+            memset(memory.get(), 0, (size_t)2 * (bucketRingLength + historyLength) * sizeof(double));
+
+        wrapped = false;
+        resetStates();
+    }
+
+    /** set each channel's delay in samples and the feedback (0 - 1); the clock follows at the next control update */
+    void setParameters(double _delayInSamples_L, double _delayInSamples_R, double _feedback)
+    {
+        chips[0].targetDelay = _delayInSamples_L;
+        chips[1].targetDelay = _delayInSamples_R;
+        feedback = _feedback;
+    }
+
+    /** bytes allocated for the chips */
+    size_t getMemoryBytes() const { return memory ? (size_t)2 * (bucketRingLength + historyLength) * sizeof(double) : 0; }
+
+    /** the longer of the two channels' delays in samples, never below minDelay; for the tail length */
+    double getLongestDelay() const { return std::max(std::max(chips[0].targetDelay, chips[1].targetDelay), minDelay); }
+
+    /** process one frame; mono uses the left chip and only sets ynL */
+    template <bool Stereo>
+    void processAudioFrame(double xnL, double xnR, double& ynL, double& ynR)
+    {
+        double inputs[2] = { xnL, xnR };
+        double outputs[2] = { 0.0, 0.0 };
+        processSegment<Stereo>(inputs, inputs + 1, outputs, outputs + 1, 1);
+        ynL = outputs[0];
+        ynR = outputs[1];
+    }
+
+    /** same as numSamples processAudioFrame() calls; numSamples must not exceed scratchLength */
+    template <bool Stereo>
+    void processBlock(const float* inL, const float* inR, double* ynL, double* ynR, uint32_t numSamples)
+    {
+        for (uint32_t start = 0; start < numSamples; )
+        {
+            if (controlPosition == 0)
+                updateClocks<Stereo>();
+
+            uint32_t n = std::min(numSamples - start, controlInterval - controlPosition);
+            n = std::min(n, chips[0].getSafeSegmentLength());
+            if constexpr (Stereo)
+                n = std::min(n, chips[1].getSafeSegmentLength());
+
+            processSegment<Stereo>(inL + start, inR + start, ynL + start, ynR + start, n);
+            start += n;
+        }
+    }
+
+private:
+    static constexpr uint32_t bucketRingLength = 4096;		///< power of two above maxNumBuckets + the kernel reach
+    static constexpr uint32_t historyLength = 512;			///< power of two above scratchLength + the kernel reach
+
+    /** one chip with its filters and compandor */
+    struct Chip
+    {
+        double* buckets = nullptr;		///< bucket ring, tick k at k & (bucketRingLength - 1)
+        double* history = nullptr;		///< filtered input ring, sample n at n & (historyLength - 1)
+        uint32_t tickCount = 0;			///< tick written next
+        uint32_t historyCount = 0;		///< input sample written next
+        uint32_t numBuckets = maxNumBuckets;
+
+        double targetDelay = 0.0;		///< delay in samples, from setParameters()
+        double tickPeriod = 0.0;		///< samples per clock tick since the last control update; 0 = not started
+        double lastTickTime = 0.0;		///< time of the last tick, relative to the control interval start
+        double nextTickTime = 0.0;		///< time of the next tick, relative to the control interval start
+        double cutoff = 0.0;			///< filter cutoff in cycles per sample
+
+        // --- 2nd order Butterworth lowpass, shared by both filters of the chip
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+        double inZ1 = 0.0, inZ2 = 0.0;		///< anti-aliasing filter states
+        double outZ1 = 0.0, outZ2 = 0.0;	///< reconstruction filter states
+
+        double compressorEnvelope = 0.0;
+        double expanderEnvelope = 0.0;
+
+        /** the longest segment whose outputs only read buckets written before it */
+        uint32_t getSafeSegmentLength() const
+        {
+            double period = std::min(tickPeriod, nextTickTime - lastTickTime);
+            return std::max(1u, (uint32_t)((numBuckets - 1) * period));
+        }
+    };
+
+    /** polyphase kernel: row p holds the taps for a position p / numPhases past the base sample,
+        for the samples base - numTaps / 2 + 1 ... base + numTaps / 2 */
+    static const double* getKernelTable()
+    {
+        static const auto table = []
+        {
+            // --- Kaiser windowed sinc, cut off just below the Nyquist of the sampled stream
+            constexpr double cutoff = 0.45;
+            constexpr double beta = 6.0;
+
+            auto besselI0 = [](double x)
+            {
+                double sum = 1.0, term = 1.0;
+                for (int k = 1; k < 30; k++)
+                {
+                    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                    sum += term;
+                }
+                return sum;
+            };
+
+            struct Table { double taps[(numPhases + 1) * numTaps]; } t;
+            for (uint32_t p = 0; p <= numPhases; p++)
+            {
+                double fraction = (double)p / numPhases;
+                double sum = 0.0;
+
+                for (uint32_t m = 0; m < numTaps; m++)
+                {
+                    double x = (double)m - (numTaps / 2 - 1) - fraction;
+                    double arg = kPi * 2.0 * cutoff * x;
+                    double sinc = x == 0.0 ? 1.0 : sin(arg) / arg;
+                    double w = x / (numTaps / 2);
+                    double window = fabs(w) >= 1.0 ? 0.0 : besselI0(beta * sqrt(1.0 - w * w)) / besselI0(beta);
+
+                    t.taps[p * numTaps + m] = 2.0 * cutoff * sinc * window;
+                    sum += t.taps[p * numTaps + m];
+                }
+
+                // --- unity gain at DC for every phase
+                for (uint32_t m = 0; m < numTaps; m++)
+                    t.taps[p * numTaps + m] /= sum;
+            }
+            return t;
+        }();
+
+        return table.taps;
+    }
+
+    /** interpolate the samples base - numTaps / 2 + 1 ... base + numTaps / 2 of a ring at base + fraction */
+    static double interpolate(const double* ring, uint32_t mask, uint32_t base, double fraction)
+    {
+        const double* kernel = getKernelTable();
+
+        double position = fraction * numPhases;
+        uint32_t phase = std::min((uint32_t)position, numPhases - 1);
+        double blend = position - phase;
+        const double* row0 = kernel + phase * numTaps;
+        const double* row1 = row0 + numTaps;
+
+        double sum = 0.0;
+        uint32_t first = base - (numTaps / 2 - 1);
+        for (uint32_t m = 0; m < numTaps; m++)
+            sum += (row0[m] + blend * (row1[m] - row0[m])) * ring[(first + m) & mask];
+
+        return sum;
+    }
+
+    /** 2nd order Butterworth lowpass (Q = 1/sqrt(2)), bilinear transform */
+    static void lowpassCoefficients(Chip& chip, double cutoff)
+    {
+        double w0 = kTwoPi * cutoff;
+        double cosw0 = cos(w0);
+        double alpha = sin(w0) / (2.0 * (1.0 / sqrt(2.0)));
+        double a0 = 1.0 + alpha;
+
+        chip.b0 = (1.0 - cosw0) / 2.0 / a0;
+        chip.b1 = (1.0 - cosw0) / a0;
+        chip.b2 = chip.b0;
+        chip.a1 = -2.0 * cosw0 / a0;
+        chip.a2 = (1.0 - alpha) / a0;
+    }
+
+    /** soft saturation of the buckets: tanh (Pade approximation) above the compressor's level */
+    static double saturate(double x)
+    {
+        x = std::min(std::max(x, -3.0), 3.0);
+        return x * (27.0 + x * x) / (27.0 + 9.0 * x * x);
+    }
+
+    void resetStates()
+    {
+        for (auto& chip : chips)
+        {
+            chip.tickCount = 0;
+            chip.historyCount = 0;
+            chip.tickPeriod = 0.0;
+            chip.lastTickTime = 0.0;
+            chip.nextTickTime = 0.0;
+            chip.inZ1 = chip.inZ2 = 0.0;
+            chip.outZ1 = chip.outZ2 = 0.0;
+            chip.compressorEnvelope = 0.0;
+            chip.expanderEnvelope = 0.0;
+        }
+        controlPosition = 0;
+    }
+
+    /** control update: clock, bucket count and filters from the target delay */
+    template <bool Stereo>
+    void updateClocks()
+    {
+        for (int ch = 0; ch < (Stereo ? 2 : 1); ch++)
+        {
+            Chip& chip = chips[ch];
+            double delay = std::max(chip.targetDelay, minDelay);
+
+            // --- the longest chip the clock limit allows: halve the buckets until the clock fits
+            uint32_t numBuckets = maxNumBuckets;
+            while (numBuckets > minNumBuckets && (delay - inputLatency) * maxClockRatio < numBuckets + outputLatency)
+                numBuckets >>= 1;
+
+            double tickPeriod = std::max((delay - inputLatency) / (numBuckets + outputLatency), 1.0 / maxClockRatio);
+
+            // --- first update after a flush: start the clock now
+            if (chip.tickPeriod == 0.0)
+            {
+                chip.lastTickTime = -tickPeriod;
+                chip.nextTickTime = 0.0;
+            }
+
+            chip.numBuckets = numBuckets;
+            chip.tickPeriod = tickPeriod;
+
+            double cutoff = std::min(filterCutoffRatio / tickPeriod, 0.45);
+            if (cutoff != chip.cutoff)
+            {
+                chip.cutoff = cutoff;
+                lowpassCoefficients(chip, cutoff);
+            }
+        }
+    }
+
+    /** numSamples samples that stay within one control interval and within every chip's safe segment length */
+    template <bool Stereo, typename Sample>
+    void processSegment(const Sample* inL, const Sample* inR, double* ynL, double* ynR, uint32_t numSamples)
+    {
+        if (controlPosition == 0)
+            updateClocks<Stereo>();
+
+        processChip(chips[0], inL, ynL, numSamples);
+        if constexpr (Stereo)
+            processChip(chips[1], inR, ynR, numSamples);
+
+        controlPosition += numSamples;
+        if (controlPosition == controlInterval)
+        {
+            // --- tick times are kept relative to the control interval
+            for (auto& chip : chips)
+            {
+                chip.lastTickTime -= controlInterval;
+                chip.nextTickTime -= controlInterval;
+            }
+            controlPosition = 0;
+        }
+    }
+
+    template <typename Sample>
+    void processChip(Chip& chip, const Sample* input, double* output, uint32_t numSamples)
+    {
+        constexpr uint32_t bucketMask = bucketRingLength - 1;
+        constexpr uint32_t historyMask = historyLength - 1;
+
+        // --- clock schedule: tick times, and where each output sample sits between two ticks
+        uint32_t numTicks = 0;
+        uint32_t tick = chip.tickCount;
+        double lastTickTime = chip.lastTickTime;
+        double nextTickTime = chip.nextTickTime;
+
+        for (uint32_t i = 0; i < numSamples; i++)
+        {
+            double t = (double)(controlPosition + i);
+            while (nextTickTime <= t)
+            {
+                scratchTickTime[numTicks++] = nextTickTime;
+                lastTickTime = nextTickTime;
+                nextTickTime += chip.tickPeriod;
+                tick++;
+            }
+
+            // --- the bucket leaving the chip now entered it numBuckets ticks ago
+            scratchReadBase[i] = tick - 1 - chip.numBuckets - (uint32_t)outputLatency;
+            scratchReadFraction[i] = (t - lastTickTime) / (nextTickTime - lastTickTime);
+        }
+
+        // --- per sample: read the chip, reconstruct, expand; feedback, compress, anti-alias into the input history
+        for (uint32_t i = 0; i < numSamples; i++)
+        {
+            double bucket = interpolate(chip.buckets, bucketMask, scratchReadBase[i], scratchReadFraction[i]);
+
+            double reconstructed = chip.b0 * bucket + chip.outZ1;
+            chip.outZ1 = chip.b1 * bucket - chip.a1 * reconstructed + chip.outZ2;
+            chip.outZ2 = chip.b2 * bucket - chip.a2 * reconstructed;
+
+            chip.expanderEnvelope += envelopeCoefficient * (fabs(reconstructed) - chip.expanderEnvelope);
+            double yn = reconstructed * chip.expanderEnvelope / compandorReference;
+            output[i] = yn;
+
+            double dn = (double)input[i] + feedback * yn;
+
+            chip.compressorEnvelope += envelopeCoefficient * (fabs(dn) - chip.compressorEnvelope);
+            double compressed = dn * sqrt(compandorReference / std::max(chip.compressorEnvelope, compandorFloor));
+
+            double filtered = chip.b0 * compressed + chip.inZ1;
+            chip.inZ1 = chip.b1 * compressed - chip.a1 * filtered + chip.inZ2;
+            chip.inZ2 = chip.b2 * compressed - chip.a2 * filtered;
+
+            chip.history[(chip.historyCount + i) & historyMask] = filtered;
+        }
+
+        // --- clock the input into the chip: each tick samples the history inputLatency samples before its time
+        //     (positions relative to the control interval, so they round the same however it is segmented)
+        for (uint32_t k = 0; k < numTicks; k++)
+        {
+            double position = scratchTickTime[k] - inputLatency;
+            double whole = floor(position);
+            uint32_t base = chip.historyCount - controlPosition + (uint32_t)(int32_t)whole;
+
+            chip.buckets[(chip.tickCount + k) & bucketMask] = saturate(interpolate(chip.history, historyMask, base, position - whole));
+        }
+
+        if (chip.tickCount + numTicks < chip.tickCount)
+            wrapped = true;
+
+        chip.tickCount += numTicks;
+        chip.historyCount += numSamples;
+        chip.lastTickTime = lastTickTime;
+        chip.nextTickTime = nextTickTime;
+    }
+
+    ZeroedArray<double> memory = nullptr;	///< both chips: bucket ring, then input history
+    Chip chips[2];							///< LEFT and RIGHT chip
+    bool wrapped = false;					///< the tick counters wrapped: every bucket may be non-zero
+
+    double sampleRate = 0.0;
+    double feedback = 0.0;					///< feedback gain, 0 - 1
+    double envelopeCoefficient = 0.0;		///< one-pole coefficient of the compandor envelopes
+    uint32_t controlPosition = 0;			///< samples into the current control interval
+
+    // --- per-segment clock schedule
+    double scratchTickTime[2 * scratchLength + 2];	///< tick times of the segment
+    uint32_t scratchReadBase[scratchLength];		///< per output sample: bucket before its position
+    double scratchReadFraction[scratchLength];		///< per output sample: position past that bucket
+};
@@ -2,7 +2,12 @@
 
 #pragma once
 
-#include <JuceHeader.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+
+#include "DSPUtils.h"
 
 /**
 \class CircularBuffer
@@ -25,8 +30,17 @@ public:
     CircularBuffer() {}		/* C-TOR */
     ~CircularBuffer() {}	/* D-TOR */
 
-                            /** flush buffer by resetting all values to 0.0 */
-    void flushBuffer() { memset(&buffer[0], 0, bufferLength * sizeof(T)); }
+    /** flush buffer by resetting all values to 0.0; only the part written since the last flush
+        is cleared, so flushing a buffer that was barely used is cheap */
+    void flushBuffer()
+    {
+        unsigned int written = wrapped ? bufferLength : writeIndex;
+        if (written > 0)
+            memset(&buffer[0], 0, written * sizeof(T));
+
+        writeIndex = 0;
+        wrapped = false;
+    }
 
     /** Create a buffer based on a target maximum in SAMPLES
     //	   do NOT call from realtime audio thread; do this prior to any processing */
@@ -40,8 +54,16 @@ public:
         pre-calculated as a power of two */
     void createCircularBufferPowerOfTwo(unsigned int _bufferLengthPowerOfTwo)
     {
+        // --- same size: keep the memory, just clear what was written
+        if (buffer && bufferLength == _bufferLengthPowerOfTwo)
+        {
+            flushBuffer();
+            return;
+        }
+
         // --- reset to top
         writeIndex = 0;
+        wrapped = false;
 
         // --- find nearest power of 2 for buffer, save it as bufferLength
         bufferLength = _bufferLengthPowerOfTwo;
@@ -49,11 +71,8 @@ public:
         // --- save (bufferLength - 1) for use as wrapping mask
         wrapMask = bufferLength - 1;
 
-        // --- create new buffer
-        buffer.reset(new T[bufferLength]);
-
-        // --- flush buffer
-        flushBuffer();
+        // --- create new buffer; it starts out zeroed, no flush needed
+        buffer = allocateZeroed<T>(bufferLength);
     }
 
     /** write a value into the buffer; this overwrites the previous oldest value in the buffer */
@@ -64,6 +83,49 @@ public:
 
         // --- wrap if index > bufferlength - 1
         writeIndex &= wrapMask;
+        wrapped |= writeIndex == 0;
+    }
+
+    /** write a block of values; same as numSamples calls to writeBuffer() */
+    void writeBlock(const T* input, unsigned int numSamples)
+    {
+        // --- copy up to the end of the buffer, then wrap to the top
+        unsigned int firstPart = std::min(numSamples, bufferLength - writeIndex);
+        memcpy(&buffer[writeIndex], input, firstPart * sizeof(T));
+        memcpy(&buffer[0], input + firstPart, (numSamples - firstPart) * sizeof(T));
+
+        wrapped |= writeIndex + numSamples >= bufferLength;
+        writeIndex = (writeIndex + numSamples) & wrapMask;
+    }
+
+    /** read the values that numSamples consecutive readBuffer(delayInSamples) calls would return
+        if the matching writes happened in between; requires numSamples <= delayInSamples + 1 */
+    void readBlock(int delayInSamples, T* output, unsigned int numSamples)
+    {
+        unsigned int readIndex = (writeIndex - 1 - delayInSamples) & wrapMask;
+
+        // --- copy up to the end of the buffer, then wrap to the top
+        unsigned int firstPart = std::min(numSamples, bufferLength - readIndex);
+        memcpy(output, &buffer[readIndex], firstPart * sizeof(T));
+        memcpy(output + firstPart, &buffer[0], (numSamples - firstPart) * sizeof(T));
+    }
+
+    /** read the values that numSamples consecutive readBuffer(delayInSamples + 2 * i) calls would return
+        if the matching writes happened in between: one sample further back per value, for playing
+        audio backwards; delayInSamples + 2 * numSamples must stay within the buffer length */
+    void readBlockReversed(int delayInSamples, T* output, unsigned int numSamples)
+    {
+        unsigned int readIndex = (writeIndex - 1 - delayInSamples) & wrapMask;
+
+        // --- copy backwards down to the top of the buffer, then wrap to the end
+        unsigned int firstPart = std::min(numSamples, readIndex + 1);
+        const T* source = &buffer[readIndex];
+        for (unsigned int i = 0; i < firstPart; i++)
+            output[i] = source[-(int)i];
+
+        source = &buffer[wrapMask];
+        for (unsigned int i = firstPart; i < numSamples; i++)
+            output[i] = source[-(int)(i - firstPart)];
     }
 
     /** read an arbitrary location that is delayInSamples old */
@@ -83,15 +145,20 @@ public:
 
     /** read an arbitrary location that includes a fractional sample */
     T readBuffer(double delayInFractionalSamples)
+    {
+        // --- if no interpolation, truncate delayInFractionalSamples and read the int part
+        if (!interpolate) return readBuffer((int)delayInFractionalSamples);
+
+        return readBufferInterpolated(delayInFractionalSamples);
+    }
+
+    /** read an arbitrary location that includes a fractional sample, always interpolating;
+        for callers that have already checked getInterpolate() outside their loop */
+    T readBufferInterpolated(double delayInFractionalSamples)
     {
         // --- truncate delayInFractionalSamples and read the int part
         T y1 = readBuffer((int)delayInFractionalSamples);
 
-        // --- if no interpolation, just return value
-        if (!interpolate) return y1;
-
-        // --- else do interpolation
-        //
         // --- read the sample at n+1 (one sample OLDER)
         T y2 = readBuffer((int)delayInFractionalSamples + 1);
 
@@ -102,12 +169,42 @@ public:
         return doLinearInterpolation(y1, y2, fraction);
     }
 
+    /** read an arbitrary location that includes a fractional sample with 4-point Hermite interpolation;
+        the sample one NEWER is only used once it exists (delays of at least one sample) */
+    T readBufferHermite(double delayInFractionalSamples)
+    {
+        int wholeDelay = (int)delayInFractionalSamples;
+
+        T y1 = readBuffer(wholeDelay);
+        T y0 = wholeDelay >= 1 ? readBuffer(wholeDelay - 1) : y1;
+        T y2 = readBuffer(wholeDelay + 1);
+        T y3 = readBuffer(wholeDelay + 2);
+
+        return doHermiteInterpolation(y0, y1, y2, y3, delayInFractionalSamples - wholeDelay);
+    }
+
     /** enable or disable interpolation; usually used for diagnostics or in algorithms that require strict integer samples times */
     void setInterpolate(bool b) { interpolate = b; }
 
+    /** true if fractional reads are interpolated */
+    bool getInterpolate() const { return interpolate; }
+
+    /** true if nothing was written since the last flush */
+    bool isFlushed() const { return !wrapped && writeIndex == 0; }
+
+    /** bytes allocated for the buffer; zero before the first create */
+    size_t getMemoryBytes() const { return buffer ? (size_t)bufferLength * sizeof(T) : 0; }
+
+    /** raw access for block kernels that compute their own read positions */
+    const T* getBuffer() const { return buffer.get(); }
+    T* getBuffer() { return buffer.get(); }
+    unsigned int getWriteIndex() const { return writeIndex; }
+    unsigned int getWrapMask() const { return wrapMask; }
+
 private:
-    std::unique_ptr<T[]> buffer = nullptr;	///< smart pointer will auto-delete
+    ZeroedArray<T> buffer = nullptr;	///< smart pointer will auto-free
     unsigned int writeIndex = 0;		///> write index
+    bool wrapped = false;				///< true once every sample was written since the last flush
     unsigned int bufferLength = 1024;	///< must be nearest power of 2
     unsigned int wrapMask = 1023;		///< must be (bufferLength - 1)
     bool interpolate = true;			///< interpolation (default is ON)
@@ -0,0 +1,332 @@
+// DSPKernels.cpp
+
+#include "DSPKernels.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+ #define JDELAY_X86_VARIANTS 1
+#else
+ #define JDELAY_X86_VARIANTS 0
+#endif
+
+// --- keep every variant bit-identical: never fuse a*b + c into an FMA. The exporters build every file with
+//     -ffp-contract=off (/fp:precise on MSVC) so the per-sample reference matches too; this keeps the
+//     kernels right when built without those flags
+#if defined(__clang__)
+ #pragma STDC FP_CONTRACT OFF
+ #define JDELAY_TARGET(isa) __attribute__((target(isa)))
+#elif defined(__GNUC__)
+ #define JDELAY_TARGET(isa) __attribute__((target(isa), optimize("fp-contract=off")))
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+ #define JDELAY_KERNEL_BODY static inline __attribute__((always_inline))
+ #define JDELAY_RESTRICT __restrict__
+#elif defined(_MSC_VER)
+ #define JDELAY_KERNEL_BODY static __forceinline
+ #define JDELAY_RESTRICT __restrict
+#else
+ #define JDELAY_KERNEL_BODY static inline
+ #define JDELAY_RESTRICT
+#endif
+
+//==============================================================================
+// Kernel bodies: plain loops, inlined into each variant and vectorized for its ISA.
+// Only out may alias x in the mix kernels, b in crossfadeBlock and y1 in hermiteBlock, so those go without restrict.
+
+JDELAY_KERNEL_BODY void interpolateBlockBody(const double* JDELAY_RESTRICT y1, const double* JDELAY_RESTRICT y2,
+                                             double fraction, double* JDELAY_RESTRICT out, uint32_t numSamples)
+{
+    for (uint32_t i = 0; i < numSamples; i++)
+        out[i] = fraction * y2[i] + (1.0 - fraction) * y1[i];
+}
+
+JDELAY_KERNEL_BODY void feedbackBlockBody(const float* JDELAY_RESTRICT x, const double* JDELAY_RESTRICT y,
+                                          double feedback, double* JDELAY_RESTRICT out, uint32_t numSamples)
+{
+    for (uint32_t i = 0; i < numSamples; i++)
+        out[i] = (double)x[i] + feedback * y[i];
+}
+
+JDELAY_KERNEL_BODY void convertBlockBody(const float* JDELAY_RESTRICT x, double* JDELAY_RESTRICT out, uint32_t numSamples)
+{
+    for (uint32_t i = 0; i < numSamples; i++)
+        out[i] = (double)x[i];
+}
+
+JDELAY_KERNEL_BODY void mixBlockBody(const float* x, const double* JDELAY_RESTRICT y, double dry, double wet,
+                                     float* out, uint32_t numSamples)
+{
+    for (uint32_t i = 0; i < numSamples; i++)
+        out[i] = (float)(dry * (double)x[i] + wet * y[i]);
+}
+
+JDELAY_KERNEL_BODY void mixGainBlockBody(const float* x, const double* JDELAY_RESTRICT y, double dry, double wet,
+                                         const double* JDELAY_RESTRICT wetGain, float* out, uint32_t numSamples)
+{
+    for (uint32_t i = 0; i < numSamples; i++)
+        out[i] = (float)(dry * (double)x[i] + (wet * wetGain[i]) * y[i]);
+}
+
+JDELAY_KERNEL_BODY void fractionalReadBlockBody(const double* JDELAY_RESTRICT buffer, uint32_t wrapMask, uint32_t newestIndex,
+                                                const double* JDELAY_RESTRICT delays, double* JDELAY_RESTRICT out, uint32_t numSamples)
+{
+    for (uint32_t i = 0; i < numSamples; i++)
+    {
+        int wholeDelay = (int)delays[i];
+        uint32_t index = (newestIndex + i - (uint32_t)wholeDelay) & wrapMask;
+        double y1 = buffer[index];
+        double y2 = buffer[(index - 1) & wrapMask];
+        double fraction = delays[i] - wholeDelay;
+        out[i] = fraction * y2 + (1.0 - fraction) * y1;
+    }
+}
+
+JDELAY_KERNEL_BODY void crossfadeBlockBody(const double* JDELAY_RESTRICT a, const double* JDELAY_RESTRICT wa,
+                                           const double* b, const double* JDELAY_RESTRICT wb, double* out, uint32_t numSamples)
+{
+    for (uint32_t i = 0; i < numSamples; i++)
+        out[i] = wa[i] * a[i] + wb[i] * b[i];
+}
+
+JDELAY_KERNEL_BODY void crossFeedbackBlockBody(double* JDELAY_RESTRICT a, double* JDELAY_RESTRICT b,
+                                               double self, double cross, uint32_t numSamples)
+{
+    for (uint32_t i = 0; i < numSamples; i++)
+    {
+        double ai = a[i];
+        double bi = b[i];
+        a[i] = self * ai + cross * bi;
+        b[i] = self * bi + cross * ai;
+    }
+}
+
+JDELAY_KERNEL_BODY float peakBlockBody(const float* JDELAY_RESTRICT x, uint32_t numSamples)
+{
+    // --- independent lanes so the reduction vectorizes without reassociation flags;
+    //     max is exact in any order
+    constexpr uint32_t numLanes = 8;
+    float lanes[numLanes] = {};
+
+    uint32_t i = 0;
+    for (; i + numLanes <= numSamples; i += numLanes)
+    {
+        for (uint32_t j = 0; j < numLanes; j++)
+        {
+            float magnitude = std::fabs(x[i + j]);
+            lanes[j] = magnitude > lanes[j] ? magnitude : lanes[j];
+        }
+    }
+
+    float peak = 0.0f;
+    for (; i < numSamples; i++)
+    {
+        float magnitude = std::fabs(x[i]);
+        peak = magnitude > peak ? magnitude : peak;
+    }
+
+    for (uint32_t j = 0; j < numLanes; j++)
+        peak = lanes[j] > peak ? lanes[j] : peak;
+
+    return peak;
+}
+
+JDELAY_KERNEL_BODY void hermiteBlockBody(const double* JDELAY_RESTRICT y0, const double* y1, const double* JDELAY_RESTRICT y2,
+                                         const double* JDELAY_RESTRICT y3, double fraction, double* out, uint32_t numSamples)
+{
+    for (uint32_t i = 0; i < numSamples; i++)
+    {
+        double c1 = 0.5 * (y2[i] - y0[i]);
+        double c2 = y0[i] - 2.5 * y1[i] + 2.0 * y2[i] - 0.5 * y3[i];
+        double c3 = 0.5 * (y3[i] - y0[i]) + 1.5 * (y1[i] - y2[i]);
+        out[i] = ((c3 * fraction + c2) * fraction + c1) * fraction + y1[i];
+    }
+}
+
+template <uint32_t NumLanes>
+JDELAY_KERNEL_BODY void delayBankBlockBody(DelayBankLanes& lanes, const float* JDELAY_RESTRICT input,
+                                           float* JDELAY_RESTRICT output, uint32_t numSamples)
+{
+    constexpr uint32_t numLines = 2 * NumLanes;
+
+    // --- locals with a fixed trip count: every line loop vectorizes across lanes, the reads become gathers
+    uint32_t lineOffset[numLines], writeOffset[numLines], delayWhole[numLines];
+    double delayFraction[numLines], feedback[numLines], dryMix[numLines], wetMix[numLines];
+    for (uint32_t l = 0; l < numLines; l++)
+    {
+        lineOffset[l] = lanes.lineOffset[l];
+        writeOffset[l] = lanes.writeOffset[l];
+        delayWhole[l] = lanes.delayWhole[l];
+        delayFraction[l] = lanes.delayFraction[l];
+        feedback[l] = lanes.feedback[l];
+        dryMix[l] = lanes.dryMix[l];
+        wetMix[l] = lanes.wetMix[l];
+    }
+
+    double* JDELAY_RESTRICT lines = lanes.lines;
+    uint32_t wrapMask = lanes.wrapMask;
+    uint32_t writeIndex = lanes.writeIndex;
+
+    for (uint32_t i = 0; i < numSamples; i++)
+    {
+        const float* x = input + i * numLines;
+        float* y = output + i * numLines;
+
+        // --- read before write, interpolated like CircularBuffer::readBufferInterpolated()
+        double delayed[numLines];
+        for (uint32_t l = 0; l < numLines; l++)
+        {
+            uint32_t readIndex = (writeIndex - 1 - delayWhole[l]) & wrapMask;
+            double y1 = lines[lineOffset[l] + readIndex];
+            double y2 = lines[lineOffset[l] + ((readIndex - 1) & wrapMask)];
+            delayed[l] = delayFraction[l] * y2 + (1.0 - delayFraction[l]) * y1;
+        }
+
+        // --- scatter, no per-lane select: ping-pong lines write to the other channel's line
+        for (uint32_t l = 0; l < numLines; l++)
+            lines[writeOffset[l] + writeIndex] = (double)x[l] + feedback[l] * delayed[l];
+
+        for (uint32_t l = 0; l < numLines; l++)
+            y[l] = (float)(dryMix[l] * (double)x[l] + wetMix[l] * delayed[l]);
+
+        writeIndex = (writeIndex + 1) & wrapMask;
+    }
+
+    lanes.writeIndex = writeIndex;
+}
+
+JDELAY_KERNEL_BODY void delayBankBlockBody(DelayBankLanes& lanes, const float* input, float* output, uint32_t numSamples)
+{
+    switch (lanes.numLanes)
+    {
+        case 4: delayBankBlockBody<4>(lanes, input, output, numSamples); break;
+        case 8: delayBankBlockBody<8>(lanes, input, output, numSamples); break;
+        case 16: delayBankBlockBody<16>(lanes, input, output, numSamples); break;
+        default: break;
+    }
+}
+
+//==============================================================================
+#define JDELAY_DEFINE_KERNEL_VARIANT(SUFFIX, ATTRIBUTES) \
+    ATTRIBUTES static void interpolateBlock_##SUFFIX(const double* y1, const double* y2, double fraction, double* out, uint32_t n) \
+        { interpolateBlockBody(y1, y2, fraction, out, n); } \
+    ATTRIBUTES static void feedbackBlock_##SUFFIX(const float* x, const double* y, double feedback, double* out, uint32_t n) \
+        { feedbackBlockBody(x, y, feedback, out, n); } \
+    ATTRIBUTES static void convertBlock_##SUFFIX(const float* x, double* out, uint32_t n) \
+        { convertBlockBody(x, out, n); } \
+    ATTRIBUTES static void mixBlock_##SUFFIX(const float* x, const double* y, double dry, double wet, float* out, uint32_t n) \
+        { mixBlockBody(x, y, dry, wet, out, n); } \
+    ATTRIBUTES static void mixGainBlock_##SUFFIX(const float* x, const double* y, double dry, double wet, const double* g, float* out, uint32_t n) \
+        { mixGainBlockBody(x, y, dry, wet, g, out, n); } \
+    ATTRIBUTES static void fractionalReadBlock_##SUFFIX(const double* b, uint32_t m, uint32_t w, const double* d, double* out, uint32_t n) \
+        { fractionalReadBlockBody(b, m, w, d, out, n); } \
+    ATTRIBUTES static void crossfadeBlock_##SUFFIX(const double* a, const double* wa, const double* b, const double* wb, double* out, uint32_t n) \
+        { crossfadeBlockBody(a, wa, b, wb, out, n); } \
+    ATTRIBUTES static float peakBlock_##SUFFIX(const float* x, uint32_t n) \
+        { return peakBlockBody(x, n); } \
+    ATTRIBUTES static void hermiteBlock_##SUFFIX(const double* y0, const double* y1, const double* y2, const double* y3, double f, double* out, uint32_t n) \
+        { hermiteBlockBody(y0, y1, y2, y3, f, out, n); } \
+    ATTRIBUTES static void delayBankBlock_##SUFFIX(DelayBankLanes& lanes, const float* x, float* y, uint32_t n) \
+        { delayBankBlockBody(lanes, x, y, n); } \
+    ATTRIBUTES static void crossFeedbackBlock_##SUFFIX(double* a, double* b, double self, double cross, uint32_t n) \
+        { crossFeedbackBlockBody(a, b, self, cross, n); } \
+    static const DSPKernelTable kernelTable_##SUFFIX { interpolateBlock_##SUFFIX, feedbackBlock_##SUFFIX, \
+                                                      convertBlock_##SUFFIX, mixBlock_##SUFFIX, \
+                                                      mixGainBlock_##SUFFIX, fractionalReadBlock_##SUFFIX, \
+                                                      crossfadeBlock_##SUFFIX, peakBlock_##SUFFIX, \
+                                                      hermiteBlock_##SUFFIX, delayBankBlock_##SUFFIX, \
+                                                      crossFeedbackBlock_##SUFFIX };
+
+JDELAY_DEFINE_KERNEL_VARIANT(generic, )
+
+#if JDELAY_X86_VARIANTS
+JDELAY_DEFINE_KERNEL_VARIANT(sse2, JDELAY_TARGET("sse2"))
+JDELAY_DEFINE_KERNEL_VARIANT(avx2, JDELAY_TARGET("avx2"))
+JDELAY_DEFINE_KERNEL_VARIANT(avx512, JDELAY_TARGET("avx512f"))
+#endif
+
+//==============================================================================
+const DSPKernelTable* DSPKernels::getTable(isaVariant variant)
+{
+#if JDELAY_X86_VARIANTS
+    switch (variant)
+    {
+        case isaVariant::kSSE2: return &kernelTable_sse2;
+        case isaVariant::kAVX2: return &kernelTable_avx2;
+        case isaVariant::kAVX512: return &kernelTable_avx512;
+        default: break;
+    }
+#endif
+
+    return &kernelTable_generic;
+}
+
+bool DSPKernels::isSupported(isaVariant variant)
+{
+    if (variant == isaVariant::kGeneric)
+        return true;
+
+#if JDELAY_X86_VARIANTS
+    __builtin_cpu_init();
+
+    switch (variant)
+    {
+        case isaVariant::kSSE2: return __builtin_cpu_supports("sse2");
+        case isaVariant::kAVX2: return __builtin_cpu_supports("avx2");
+        case isaVariant::kAVX512: return __builtin_cpu_supports("avx512f");
+        default: break;
+    }
+#endif
+
+    return false;
+}
+
+isaVariant DSPKernels::getBestSupportedVariant()
+{
+    for (auto variant : { isaVariant::kAVX512, isaVariant::kAVX2, isaVariant::kSSE2 })
+        if (isSupported(variant))
+            return variant;
+
+    return isaVariant::kGeneric;
+}
+
+const char* DSPKernels::getVariantName(isaVariant variant)
+{
+    switch (variant)
+    {
+        case isaVariant::kSSE2: return "sse2";
+        case isaVariant::kAVX2: return "avx2";
+        case isaVariant::kAVX512: return "avx512";
+        default: return "generic";
+    }
+}
+
+bool DSPKernels::forceVariant(isaVariant variant)
+{
+    if (!isSupported(variant))
+        return false;
+
+    activeVariant.store(variant);
+    activeTable.store(getTable(variant));
+    return true;
+}
+
+isaVariant DSPKernels::selectInitialVariant()
+{
+    // --- JDELAY_FORCE_ISA pins a variant, if the CPU can run it
+    if (const char* forced = std::getenv("JDELAY_FORCE_ISA"))
+    {
+        for (auto variant : { isaVariant::kGeneric, isaVariant::kSSE2, isaVariant::kAVX2, isaVariant::kAVX512 })
+            if (std::strcmp(forced, getVariantName(variant)) == 0 && isSupported(variant))
+                return variant;
+    }
+
+    return getBestSupportedVariant();
+}
+
+std::atomic<isaVariant> DSPKernels::activeVariant { DSPKernels::selectInitialVariant() };
+std::atomic<const DSPKernelTable*> DSPKernels::activeTable { DSPKernels::getTable(DSPKernels::activeVariant.load()) };
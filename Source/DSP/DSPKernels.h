@@ -0,0 +1,163 @@
+// DSPKernels.h
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define JDELAY_SSE2_FRAME 1
+#else
+ #define JDELAY_SSE2_FRAME 0
+#endif
+
+/**
+\enum isaVariant
+\ingroup Constants-Enums
+\brief
+Instruction set variants the block kernels are compiled for.
+
+- enum class isaVariant { kGeneric, kSSE2, kAVX2, kAVX512 };
+*/
+enum class isaVariant { kGeneric, kSSE2, kAVX2, kAVX512 };
+
+/**
+\struct DelayBankLanes
+\ingroup FX-Objects
+\brief
+Lane state of an AudioDelayBank, processed by DSPKernelTable::delayBankBlock(): numLanes stereo delays,
+2 * numLanes lines in one allocation with a shared write index. Lines and per-line settings are
+ordered left lines of all lanes, then right lines.
+*/
+struct DelayBankLanes
+{
+    static constexpr uint32_t maxNumLanes = 16;
+    static constexpr uint32_t maxNumLines = 2 * maxNumLanes;
+
+    double* lines = nullptr;					///< all lines, line l starting at lineOffset[l]
+    uint32_t wrapMask = 0;						///< line length - 1 (a power of two)
+    uint32_t writeIndex = 0;					///< position written next in every line; the kernel advances it
+    uint32_t numLanes = 0;						///< 4, 8 or 16
+
+    uint32_t lineOffset[maxNumLines] = {};		///< per line: start within lines, read here
+    uint32_t writeOffset[maxNumLines] = {};		///< per line: start of the line it feeds (the other channel's for kPingPong)
+
+    uint32_t delayWhole[maxNumLines] = {};		///< per line: whole samples of the delay
+    double delayFraction[maxNumLines] = {};		///< per line: fractional part of the delay
+    double feedback[maxNumLines] = {};			///< per line: feedback gain
+    double dryMix[maxNumLines] = {};			///< per line: dry gain
+    double wetMix[maxNumLines] = {};			///< per line: wet gain
+};
+
+/**
+\struct DSPKernelTable
+\ingroup FX-Objects
+\brief
+Function table of the vectorizable block kernels, one table per instruction set variant.
+
+All variants do the same arithmetic in the same order (no FMA contraction), so their output is
+bit-identical; only the vector width differs. Matching the per-sample code in the headers also needs
+the project-wide -ffp-contract=off (/fp:precise on MSVC) set in every exporter.
+*/
+struct DSPKernelTable
+{
+    /** out[i] = fraction * y2[i] + (1 - fraction) * y1[i], same as doLinearInterpolation() */
+    void (*interpolateBlock)(const double* y1, const double* y2, double fraction, double* out, uint32_t numSamples);
+
+    /** out[i] = x[i] + feedback * y[i] */
+    void (*feedbackBlock)(const float* x, const double* y, double feedback, double* out, uint32_t numSamples);
+
+    /** out[i] = x[i] */
+    void (*convertBlock)(const float* x, double* out, uint32_t numSamples);
+
+    /** out[i] = dry * x[i] + wet * y[i]; out may alias x */
+    void (*mixBlock)(const float* x, const double* y, double dry, double wet, float* out, uint32_t numSamples);
+
+    /** out[i] = dry * x[i] + (wet * wetGain[i]) * y[i]; out may alias x */
+    void (*mixGainBlock)(const float* x, const double* y, double dry, double wet, const double* wetGain, float* out, uint32_t numSamples);
+
+    /** out[i] = buffer at delays[i] behind newestIndex + i, linearly interpolated exactly like
+        CircularBuffer::readBufferInterpolated() after i writes; delays[i] >= 0 */
+    void (*fractionalReadBlock)(const double* buffer, uint32_t wrapMask, uint32_t newestIndex, const double* delays,
+                                double* out, uint32_t numSamples);
+
+    /** out[i] = wa[i] * a[i] + wb[i] * b[i]; out may alias b */
+    void (*crossfadeBlock)(const double* a, const double* wa, const double* b, const double* wb, double* out, uint32_t numSamples);
+
+    /** largest |x[i]|; exact, so it matches a sample-by-sample scan */
+    float (*peakBlock)(const float* x, uint32_t numSamples);
+
+    /** out[i] = doHermiteInterpolation(y0[i], y1[i], y2[i], y3[i], fraction); out may alias y1 */
+    void (*hermiteBlock)(const double* y0, const double* y1, const double* y2, const double* y3, double fraction,
+                         double* out, uint32_t numSamples);
+
+    /** numSamples frames through every lane, one sample of all lanes at a time, same arithmetic as
+        AudioDelay::processAudioFrame() per lane; input and output hold one frame of 2 * numLanes floats
+        per sample, in line order */
+    void (*delayBankBlock)(DelayBankLanes& lanes, const float* input, float* output, uint32_t numSamples);
+
+    /** a[i], b[i] = self * a[i] + cross * b[i], self * b[i] + cross * a[i]: the 2x2 cross feedback matrix
+        of AudioDelay on numSamples frames, in place; same arithmetic as DSPKernels::crossFeedbackFrame() */
+    void (*crossFeedbackBlock)(double* a, double* b, double self, double cross, uint32_t numSamples);
+};
+
+/**
+\class DSPKernels
+\ingroup FX-Objects
+\brief
+Runtime CPU feature dispatch for the block kernels.
+
+The best variant the CPU supports is selected once when the library loads. Set the environment
+variable JDELAY_FORCE_ISA (generic, sse2, avx2 or avx512) or call forceVariant() to pin a variant
+for benchmarking and testing.
+
+The x86 variants are built with per-function target attributes, which need GCC or Clang; other
+compilers and architectures only get the generic variant (auto-vectorized for the baseline ISA).
+*/
+class DSPKernels
+{
+public:
+    /** the active kernel table; fetch once per block */
+    static const DSPKernelTable& get() { return *activeTable.load(std::memory_order_relaxed); }
+
+    /** the variant get() currently returns */
+    static isaVariant getActiveVariant() { return activeVariant.load(std::memory_order_relaxed); }
+
+    /** the best variant this CPU and build support */
+    static isaVariant getBestSupportedVariant();
+
+    /** true if the variant is compiled in and the CPU can run it */
+    static bool isSupported(isaVariant variant);
+
+    /** pin a variant; returns false (and changes nothing) if it isn't supported */
+    static bool forceVariant(isaVariant variant);
+
+    /** name as used by JDELAY_FORCE_ISA */
+    static const char* getVariantName(isaVariant variant);
+
+    /** the cross feedback matrix of DSPKernelTable::crossFeedbackBlock() on one stereo frame, for the
+        sample-by-sample paths: one two-lane multiply-add on the {a, b} pair where SSE2 is the baseline */
+    static inline void crossFeedbackFrame(double& a, double& b, double self, double cross)
+    {
+#if JDELAY_SSE2_FRAME
+        __m128d frame = _mm_set_pd(b, a);
+        __m128d swapped = _mm_shuffle_pd(frame, frame, 1);
+        __m128d mixed = _mm_add_pd(_mm_mul_pd(frame, _mm_set1_pd(self)), _mm_mul_pd(swapped, _mm_set1_pd(cross)));
+
+        a = _mm_cvtsd_f64(mixed);
+        b = _mm_cvtsd_f64(_mm_unpackhi_pd(mixed, mixed));
+#else
+        double a0 = a;
+        a = self * a0 + cross * b;
+        b = self * b + cross * a0;
+#endif
+    }
+
+private:
+    static const DSPKernelTable* getTable(isaVariant variant);
+    static isaVariant selectInitialVariant();
+
+    static std::atomic<const DSPKernelTable*> activeTable;
+    static std::atomic<isaVariant> activeVariant;
+};
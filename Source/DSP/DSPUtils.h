@@ -2,7 +2,17 @@
 
 #pragma once
 
-#include <JuceHeader.h>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+#include "DelayMemoryArena.h"
+
+const double kPi = 3.14159265358979323846264338327950288419716939937510582097494459230781640628620899;
+const double kTwoPi = 2.0 * 3.14159265358979323846264338327950288419716939937510582097494459230781640628620899;
 
 /**
 @convertIntToEnum
@@ -37,14 +47,14 @@ inline void boundValue(double& value, double minValue, double maxValue)
 \brief
 Use this strongly typed enum to easily set the delay algorithm
 
-- enum class delayAlgorithm { kNormal, kPingPong };
+- enum class delayAlgorithm { kNormal, kPingPong, kFDN, kReverse, kMultiband, kBBD };
 
 \author Will Pirkle http://www.willpirkle.com
 \remark This object is included in Designing Audio Effects Plugins in C++ 2nd Ed. by Will Pirkle
 \version Revision : 1.0
 \date Date : 2018 / 09 / 7
 */
-enum class delayAlgorithm { kNormal, kPingPong };
+enum class delayAlgorithm { kNormal, kPingPong, kFDN, kReverse, kMultiband, kBBD };
 
 /**
 \enum delayUpdateType
@@ -62,6 +72,17 @@ of GUI controls. See the book reference for more details.
 */
 enum class delayUpdateType { kLeftAndRight, kLeftPlusRatio };
 
+/**
+\enum feedbackInsertType
+\ingroup Constants-Enums
+\brief
+Use this strongly typed enum to set the node in a slot of a FeedbackInsertGraph; kProcessor is the graph's
+external processor (e.g. the feedback IR convolution)
+
+- enum class feedbackInsertType { kOff, kLowpass, kHighpass, kSaturator, kModulation, kProcessor };
+*/
+enum class feedbackInsertType { kOff, kLowpass, kHighpass, kSaturator, kModulation, kProcessor };
+
 /**
 @doLinearInterpolation
 \ingroup FX-Functions
@@ -81,4 +102,66 @@ inline double doLinearInterpolation(double y1, double y2, double fractional_X)
 
     // --- use weighted sum method of interpolating
     return fractional_X * y2 + (1.0 - fractional_X) * y1;
-}
\ No newline at end of file
+}
+
+/**
+@doHermiteInterpolation
+\ingroup FX-Functions
+
+@brief performs 4-point, 3rd-order Hermite interpolation between the two middle points of four
+equally spaced (x,y) points; returns interpolated value. Flatter passband and far less aliasing
+than linear interpolation on modulated delays, for about four times the work.
+
+\param y0 - the y coordinate of the point before the interval
+\param y1 - the y coordinate of the first point of the interval
+\param y2 - the y coordinate of the second point of the interval
+\param y3 - the y coordinate of the point after the interval
+\param x - the interpolation location as a fractional distance between x1 and x2
+\return the interpolated value
+*/
+inline double doHermiteInterpolation(double y0, double y1, double y2, double y3, double fractional_X)
+{
+    double c1 = 0.5 * (y2 - y0);
+    double c2 = y0 - 2.5 * y1 + 2.0 * y2 - 0.5 * y3;
+    double c3 = 0.5 * (y3 - y0) + 1.5 * (y1 - y2);
+
+    return ((c3 * fractional_X + c2) * fractional_X + c1) * fractional_X + y1;
+}
+/**
+@ZeroedArray
+\ingroup FX-Functions
+
+@brief an array from allocateZeroed(), released to the DelayMemoryArena
+*/
+struct ArenaDeleter
+{
+    void operator()(void* memory) const { DelayMemoryArena::getInstance().release(memory); }
+};
+
+template <typename T>
+using ZeroedArray = std::unique_ptr<T[], ArenaDeleter>;
+
+/**
+@allocateZeroed
+\ingroup FX-Functions
+
+@brief allocate an array of zeros from the process-wide DelayMemoryArena: cache line aligned, on huge pages
+where the platform has them, and recycled from earlier buffers of the same size class. Fresh memory is
+untouched until first written. Throws std::bad_alloc like new[].
+
+\param count - number of values
+\return the zeroed array
+*/
+template <typename T>
+ZeroedArray<T> allocateZeroed(size_t count)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "all-bits-zero must be a valid T");
+    static_assert(alignof(T) <= DelayMemoryArena::cacheLineSize, "the arena aligns to cache lines");
+
+    if (count > ((size_t)-1) / 4 / sizeof(T))
+        throw std::bad_alloc();
+
+    void* memory = DelayMemoryArena::getInstance().allocate(count * sizeof(T));
+
+    return ZeroedArray<T>(static_cast<T*>(memory));
+}
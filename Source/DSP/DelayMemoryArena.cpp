@@ -0,0 +1,272 @@
+// DelayMemoryArena.cpp
+
+#include "DelayMemoryArena.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(_WIN32)
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #ifndef WIN32_LEAN_AND_MEAN
+  #define WIN32_LEAN_AND_MEAN
+ #endif
+ #include <windows.h>
+#elif defined(__linux__) || defined(__APPLE__)
+ #include <sys/mman.h>
+ #if defined(__APPLE__)
+  #include <mach/vm_statistics.h>
+ #endif
+#endif
+
+namespace
+{
+    size_t roundUp(size_t numBytes, size_t multiple)
+    {
+        return (numBytes + multiple - 1) / multiple * multiple;
+    }
+
+#if defined(__linux__)
+    // --- "always" or "madvise" in brackets: regions advised with MADV_HUGEPAGE get huge pages
+    bool isTransparentHugePageAvailable()
+    {
+        FILE* file = std::fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+        if (file == nullptr)
+            return false;
+
+        char setting[128] = {};
+        bool available = std::fgets(setting, sizeof(setting), file) != nullptr
+                         && (std::strstr(setting, "[always]") != nullptr || std::strstr(setting, "[madvise]") != nullptr);
+
+        std::fclose(file);
+        return available;
+    }
+#endif
+}
+
+DelayMemoryArena& DelayMemoryArena::getInstance()
+{
+    // --- leaked on purpose: instances in other static objects may release their buffers after main() returns
+    static DelayMemoryArena* instance = new DelayMemoryArena();
+    return *instance;
+}
+
+DelayMemoryArena::DelayMemoryArena()
+{
+    // --- JDELAY_HUGE_PAGES=off maps ordinary pages only
+    if (const char* setting = std::getenv("JDELAY_HUGE_PAGES"))
+        allowHugePages = std::strcmp(setting, "off") != 0;
+}
+
+size_t DelayMemoryArena::getClassSize(size_t numBytes)
+{
+    if (numBytes <= cacheLineSize)
+        return cacheLineSize;
+
+    // --- four classes per power of two: [2^n, 2^(n+1)) is split in steps of 2^(n-2)
+    size_t powerOfTwo = 1;
+    while (powerOfTwo <= (numBytes - 1) / 2)
+        powerOfTwo *= 2;
+
+    size_t step = powerOfTwo / 4 > cacheLineSize ? powerOfTwo / 4 : cacheLineSize;
+    return roundUp(numBytes, step);
+}
+
+void* DelayMemoryArena::allocate(size_t numBytes)
+{
+    if (numBytes > ((size_t)-1) / 4)
+        throw std::bad_alloc();
+
+    const size_t classSize = getClassSize(numBytes > 0 ? numBytes : 1);
+    const size_t blockBytes = classSize + cacheLineSize;
+
+    BlockHeader* header = nullptr;
+    bool recycled = false;
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        auto freeList = freeLists.find(classSize);
+        if (freeList != freeLists.end() && freeList->second != nullptr)
+        {
+            header = freeList->second;
+            freeList->second = header->nextFree;
+            recycled = true;
+
+            statistics.freeListBytes -= classSize;
+            statistics.numRecycled++;
+        }
+        else if (blockBytes > regionSize / 4)
+        {
+            // --- big lines get a region of their own, so they don't strand the rest of the shared one
+            header = reinterpret_cast<BlockHeader*>(addRegion(blockBytes));
+        }
+        else
+        {
+            if ((size_t)(regionEnd - regionCursor) < blockBytes)
+            {
+                char* region = addRegion(regionSize);
+                if (region != nullptr)
+                {
+                    regionCursor = region;
+                    regionEnd = region + regionSize;
+                }
+            }
+
+            if ((size_t)(regionEnd - regionCursor) >= blockBytes)
+            {
+                header = reinterpret_cast<BlockHeader*>(regionCursor);
+                regionCursor += blockBytes;
+            }
+        }
+
+        if (header == nullptr)
+            throw std::bad_alloc();
+
+        header->classSize = classSize;
+        header->requestedBytes = numBytes;
+        header->nextFree = nullptr;
+
+        statistics.inUseBytes += classSize;
+        statistics.requestedBytes += numBytes;
+        statistics.numAllocations++;
+    }
+
+    void* memory = reinterpret_cast<char*>(header) + cacheLineSize;
+
+    // --- fresh region memory is already zero and stays untouched until written
+    if (recycled)
+        std::memset(memory, 0, numBytes);
+
+    return memory;
+}
+
+void DelayMemoryArena::release(void* memory)
+{
+    if (memory == nullptr)
+        return;
+
+    BlockHeader* header = reinterpret_cast<BlockHeader*>(static_cast<char*>(memory) - cacheLineSize);
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    BlockHeader*& freeList = freeLists[header->classSize];
+    header->nextFree = freeList;
+    freeList = header;
+
+    statistics.inUseBytes -= header->classSize;
+    statistics.requestedBytes -= header->requestedBytes;
+    statistics.freeListBytes += header->classSize;
+    statistics.numAllocations--;
+}
+
+DelayMemoryStatistics DelayMemoryArena::getStatistics() const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return statistics;
+}
+
+char* DelayMemoryArena::addRegion(size_t numBytes)
+{
+    numBytes = roundUp(numBytes, hugePageSize);
+
+    hugePageMode mode = hugePageMode::kNone;
+    void* region = mapRegion(numBytes, mode, allowHugePages);
+    if (region == nullptr)
+        return nullptr;
+
+    statistics.reservedBytes += numBytes;
+    statistics.numRegions++;
+
+    if (mode != hugePageMode::kNone)
+        statistics.hugePageBytes += numBytes;
+
+    if ((int)mode > (int)statistics.mode)
+        statistics.mode = mode;
+
+    return static_cast<char*>(region);
+}
+
+void* DelayMemoryArena::mapRegion(size_t numBytes, hugePageMode& mode, bool allowHugePages)
+{
+    mode = hugePageMode::kNone;
+
+#if defined(_WIN32)
+    // --- large pages need the "Lock pages in memory" privilege; without it the call just fails
+    SIZE_T largePageSize = GetLargePageMinimum();
+    if (allowHugePages && largePageSize > 0 && numBytes % largePageSize == 0)
+    {
+        if (void* region = VirtualAlloc(nullptr, numBytes, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE))
+        {
+            mode = hugePageMode::kExplicit;
+            return region;
+        }
+    }
+
+    if (void* region = VirtualAlloc(nullptr, numBytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE))
+        return region;
+
+#elif defined(__linux__)
+ #if defined(MAP_HUGETLB)
+    // --- explicit huge pages, when the administrator reserved a pool (vm.nr_hugepages)
+    if (allowHugePages)
+    {
+        void* region = mmap(nullptr, numBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (region != MAP_FAILED)
+        {
+            mode = hugePageMode::kExplicit;
+            return region;
+        }
+    }
+ #endif
+
+    // --- over-map by a huge page and trim, so the region starts on a huge page boundary
+    void* mapping = mmap(nullptr, numBytes + hugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping != MAP_FAILED)
+    {
+        char* start = static_cast<char*>(mapping);
+        char* region = reinterpret_cast<char*>(roundUp(reinterpret_cast<uintptr_t>(start), hugePageSize));
+        size_t head = (size_t)(region - start);
+
+        if (head > 0)
+            munmap(start, head);
+        if (hugePageSize - head > 0)
+            munmap(region + numBytes, hugePageSize - head);
+
+ #if defined(MADV_HUGEPAGE)
+        if (allowHugePages && isTransparentHugePageAvailable() && madvise(region, numBytes, MADV_HUGEPAGE) == 0)
+            mode = hugePageMode::kTransparent;
+ #endif
+
+        return region;
+    }
+
+#elif defined(__APPLE__)
+ #if defined(VM_FLAGS_SUPERPAGE_SIZE_2MB)
+    // --- 2 MB superpages (Intel Macs); the flag goes in the file descriptor argument
+    if (allowHugePages)
+    {
+        void* region = mmap(nullptr, numBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, VM_FLAGS_SUPERPAGE_SIZE_2MB, 0);
+        if (region != MAP_FAILED)
+        {
+            mode = hugePageMode::kExplicit;
+            return region;
+        }
+    }
+ #endif
+
+    void* region = mmap(nullptr, numBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (region != MAP_FAILED)
+        return region;
+#endif
+
+    // --- anything else, or mapping failed: calloc, over-allocated to keep the blocks cache line aligned
+    void* memory = std::calloc(numBytes + cacheLineSize, 1);
+    if (memory == nullptr)
+        return nullptr;
+
+    return reinterpret_cast<void*>(roundUp(reinterpret_cast<uintptr_t>(memory), cacheLineSize));
+}
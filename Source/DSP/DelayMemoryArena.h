@@ -0,0 +1,113 @@
+// DelayMemoryArena.h
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+/**
+\enum hugePageMode
+\ingroup Constants-Enums
+\brief
+Use this strongly typed enum to see how the DelayMemoryArena backs its regions: kExplicit for reserved
+huge pages (MAP_HUGETLB, superpages, large pages), kTransparent for regions the kernel may back with
+transparent huge pages, kNone for ordinary pages
+
+- enum class hugePageMode { kNone, kTransparent, kExplicit };
+*/
+enum class hugePageMode { kNone, kTransparent, kExplicit };
+
+/**
+\struct DelayMemoryStatistics
+\ingroup FX-Objects
+\brief
+Usage of the DelayMemoryArena, from DelayMemoryArena::getStatistics()
+*/
+struct DelayMemoryStatistics
+{
+    hugePageMode mode = hugePageMode::kNone;    ///< best backing the arena got so far
+    size_t reservedBytes = 0;                   ///< address space of all regions
+    size_t hugePageBytes = 0;                   ///< part of reservedBytes backed (or eligible for) huge pages
+    size_t inUseBytes = 0;                      ///< size class bytes handed out and not yet released
+    size_t requestedBytes = 0;                  ///< bytes asked for by the blocks in use
+    size_t freeListBytes = 0;                   ///< released blocks waiting to be recycled
+    uint32_t numAllocations = 0;                ///< blocks in use
+    uint32_t numRecycled = 0;                   ///< allocations served from a free list since start up
+    uint32_t numRegions = 0;                    ///< regions mapped since start up
+};
+
+/**
+\class DelayMemoryArena
+\ingroup FX-Objects
+\brief
+The DelayMemoryArena is the one process-wide source of delay memory: every allocateZeroed() call, so every
+CircularBuffer and every other delay line of every plugin instance in the process, is carved from it.
+
+Memory comes in large regions, mapped with huge pages where the platform gives them out: explicit huge pages
+first, transparent huge pages next, ordinary pages (or calloc) otherwise, with no setup needed. A few hundred
+delay lines then sit on a handful of TLB entries instead of thousands. Setting the JDELAY_HUGE_PAGES
+environment variable to "off" forces ordinary pages, for A/B benchmarks.
+
+Blocks are 64-byte (cache line) aligned and rounded up to size classes, four per power of two. Released blocks
+go onto the free list of their class, so closing and reopening instances, or preparing again at the same sample
+rate, reuses the same memory. Regions are never returned to the system.
+
+Memory from fresh regions is already zero; recycled blocks are cleared on allocation.
+
+allocate() and release() take a lock and may map memory: they are NOT realtime safe, call them where you would
+call new and delete (prepare, reset with a new size, destruction).
+*/
+class DelayMemoryArena
+{
+public:
+    /** the process-wide arena; never destroyed, so blocks may be released during static destruction */
+    static DelayMemoryArena& getInstance();
+
+    /** allocate numBytes of zeroed, 64-byte aligned memory; throws std::bad_alloc */
+    void* allocate(size_t numBytes);
+
+    /** return a block from allocate(); nullptr is ignored */
+    void release(void* memory);
+
+    /** snapshot of the arena's usage */
+    DelayMemoryStatistics getStatistics() const;
+
+    /** size class a request of numBytes is rounded up to */
+    static size_t getClassSize(size_t numBytes);
+
+    static const size_t cacheLineSize = 64;                 ///< block alignment and header size
+    static const size_t hugePageSize = 2 * 1024 * 1024;     ///< region granularity
+    static const size_t regionSize = 32 * 1024 * 1024;      ///< shared region size; larger blocks get their own
+
+private:
+    DelayMemoryArena();
+
+    /** bookkeeping in the cache line before each block */
+    struct BlockHeader
+    {
+        size_t classSize = 0;               ///< usable bytes of the block
+        size_t requestedBytes = 0;          ///< bytes asked for; what must be cleared on recycling
+        BlockHeader* nextFree = nullptr;    ///< next block in the free list
+    };
+
+    static_assert(sizeof(BlockHeader) <= cacheLineSize, "the header must fit in a cache line");
+
+    /** map a new region of at least numBytes (rounded up to hugePageSize); nullptr when out of memory */
+    char* addRegion(size_t numBytes);
+
+    /** platform mapping of numBytes (a hugePageSize multiple); sets mode to the backing it got */
+    static void* mapRegion(size_t numBytes, hugePageMode& mode, bool allowHugePages);
+
+    mutable std::mutex lock;
+
+    std::map<size_t, BlockHeader*> freeLists;      ///< class size -> released blocks
+
+    char* regionCursor = nullptr;                   ///< bump pointer into the current region
+    char* regionEnd = nullptr;
+
+    bool allowHugePages = true;
+
+    DelayMemoryStatistics statistics;
+};
@@ -0,0 +1,394 @@
+// FeedbackDelayNetwork.h
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "DSPUtils.h"
+
+/**
+\class FeedbackDelayNetwork
+\ingroup FX-Objects
+\brief
+The FeedbackDelayNetwork object implements a diffuse stereo delay: 4, 8 or 16 delay lines with mutually
+prime lengths, a normalized Hadamard feedback matrix and per-line damping.
+
+- Line lengths are picked from a prime table so that no two lines share a period; they are spread
+  between 35% and 100% of the base delay time.
+- The feedback matrix is applied with a fast Walsh-Hadamard transform (N log N adds, no multiplies
+  except the final normalization). The frame processing is instantiated for 4, 8 and 16 lines and
+  picked when the line count changes, so every loop has a fixed trip count and unrolls.
+- All lines live in one contiguous block of memory, one region per line. Samples are stored as
+  float to keep 16 lines at 2 seconds within a few MB. The block is allocated zeroed, and flush()
+  only clears the part of each region written since the last flush.
+- Per-line feedback gains are scaled by line length so every line decays at the same rate; the
+  damping lowpass is scaled the same way. They are recalculated only when the feedback, the damping
+  or the lengths change.
+- A new base delay crossfades the read taps from the old to the new lengths over crossfade_mSec;
+  a sweep moves in steps of one crossfade, each picking up the latest base delay.
+- A new line count fades the output out over crossfade_mSec, then restarts the network empty on
+  the new lines: their regions still hold whatever the old lines left there.
+
+Audio I/O:
+- Processes stereo frames; left input feeds the even lines, right input the odd lines.
+  The outputs use two orthogonal Hadamard sign patterns, so they are decorrelated.
+*/
+class FeedbackDelayNetwork
+{
+public:
+    FeedbackDelayNetwork() {}		/* C-TOR */
+    ~FeedbackDelayNetwork() {}		/* D-TOR */
+
+    static constexpr int maxNumLines = 16;
+
+    /** create the delay lines and the prime table; do NOT call from realtime audio thread */
+    void createDelayLines(double _sampleRate, double maxDelay_mSec)
+    {
+        sampleRate = _sampleRate;
+        maxDelayInSamples = (unsigned int)(maxDelay_mSec * sampleRate / 1000.0) + 1;
+        crossfadeLength = std::max(1u, (unsigned int)(crossfade_mSec * sampleRate / 1000.0));
+        fadeStep = 1.0 / crossfadeLength;
+
+        // --- one region per line, sized for the longest length that line can take
+        //     plus headroom for rounding up to the next prime
+        unsigned int totalSize = 0;
+        for (int i = 0; i < maxNumLines; i++)
+        {
+            regionRatio[i] = pow(0.35, 1.0 - (double)i / (maxNumLines - 1));
+            lineOffset[i] = totalSize;
+            lineSize[i] = (unsigned int)(regionRatio[i] * maxDelayInSamples) + primeHeadroom;
+            totalSize += lineSize[i];
+        }
+
+        lineMemory = allocateZeroed<float>(totalSize);
+        lineMemorySize = totalSize;
+
+        // --- the new block is all zeros: nothing to flush
+        for (int i = 0; i < maxNumLines; i++)
+        {
+            writeIndex[i] = 0;
+            lineWrapped[i] = false;
+            regionWritten[i] = 0;
+        }
+
+        createPrimeTable(maxDelayInSamples + primeHeadroom);
+
+        targetBaseLength = std::min(std::max(targetBaseLength, minBaseLength), maxDelayInSamples);
+        switchNumLines();
+    }
+
+    /** clear all lines and filter states; a pending line count or base delay takes effect at once */
+    void flush()
+    {
+        recordWrittenExtents();
+
+        for (int i = 0; i < maxNumLines; i++)
+        {
+            if (regionWritten[i] > 0)
+                memset(lineMemory.get() + lineOffset[i], 0, regionWritten[i] * sizeof(float));
+
+            regionWritten[i] = 0;
+            writeIndex[i] = 0;
+        }
+
+        switchNumLines();
+    }
+
+    /** use 4, 8 or 16 lines; each halving costs half the CPU but sounds less dense. The switch happens
+        from processAudioFrame(), after the output has faded out */
+    void setNumLines(int _numLines)
+    {
+        targetNumLines = _numLines > 8 ? 16 : _numLines > 4 ? 8 : 4;
+    }
+
+    /** set the base delay (longest line) in samples, feedback gain (0 - 1) and damping (0 - 1) */
+    void setParameters(double delayInSamples, double _feedback, double _damping)
+    {
+        unsigned int newBaseLength = (unsigned int)delayInSamples;
+        if (newBaseLength > maxDelayInSamples) newBaseLength = maxDelayInSamples;
+        if (newBaseLength < minBaseLength) newBaseLength = minBaseLength;
+        targetBaseLength = newBaseLength;
+
+        bool gainsChanged = _feedback != feedback || _damping != damping;
+        feedback = _feedback;
+        damping = _damping;
+
+        // --- a running crossfade picks up the new base delay when it ends
+        if (lineMemory && targetBaseLength != baseLength && fadeRemaining == 0)
+            startLengthCrossfade();
+        else if (gainsChanged)
+            updateGains();
+    }
+
+    /** bytes allocated for the lines */
+    size_t getMemoryBytes() const { return (size_t)lineMemorySize * sizeof(float); }
+
+    /** the longest line in samples, or the latest base delay if a change has not crossfaded in yet;
+        never below minBaseLength; for the tail length */
+    double getLongestDelay() const
+    {
+        unsigned int longest = std::max(lineLength[numLines - 1], targetBaseLength);
+        if (fadeRemaining > 0)
+            longest = std::max(longest, fadeLength[numLines - 1]);
+        return (double)longest;
+    }
+
+    /** process one stereo frame */
+    void processAudioFrame(double xnL, double xnR, double& ynL, double& ynR)
+    {
+        (this->*frameProcessor)(xnL, xnR, ynL, ynR);
+
+        // --- read tap crossfade: on its last frame the new taps took over
+        if (fadeRemaining > 0)
+        {
+            if (--fadeRemaining == 0)
+            {
+                std::copy(fadeLength, fadeLength + numLines, lineLength);
+                if (targetBaseLength != baseLength)
+                    startLengthCrossfade();
+            }
+            else
+                fadeGain += fadeStep;
+        }
+
+        // --- line count switch: fade out, switch, and fade back in if the switch was called off
+        if (targetNumLines != numLines)
+        {
+            switchGain -= fadeStep;
+            if (switchGain <= 0.0)
+                switchNumLines();
+        }
+        else if (switchGain < 1.0)
+            switchGain = std::min(1.0, switchGain + fadeStep);
+    }
+
+private:
+    /** process one frame with a fixed line count */
+    template <int N>
+    void processFrame(double xnL, double xnR, double& ynL, double& ynR)
+    {
+        double state[N];
+
+        // --- read and damp; while the lengths change the old and new taps are crossfaded
+        for (int i = 0; i < N; i++)
+        {
+            double yn = readLine(i, lineLength[i]);
+            if (fadeRemaining > 0)
+                yn += fadeGain * (readLine(i, fadeLength[i]) - yn);
+
+            dampingState[i] = yn + dampingCoefficient[i] * (dampingState[i] - yn);
+            state[i] = dampingState[i];
+        }
+
+        // --- decorrelated outputs: Hadamard rows 1 (+-+-...) and 2 (++--...)
+        double outL = 0.0, outR = 0.0;
+        for (int i = 0; i < N; i++)
+        {
+            outL += (i & 1) ? -state[i] : state[i];
+            outR += (i & 2) ? -state[i] : state[i];
+        }
+        double scale = outputScale * switchGain;
+        ynL = outL * scale;
+        ynR = outR * scale;
+
+        // --- mix
+        fastHadamardTransform<N>(state);
+
+        // --- write back with per-line decay
+        for (int i = 0; i < N; i++)
+        {
+            double xn = (i & 1) ? xnR : xnL;
+            lineMemory[activeOffset[i] + writeIndex[i]] = (float)(xn + lineGain[i] * state[i]);
+
+            if (++writeIndex[i] == activeSize[i])
+            {
+                writeIndex[i] = 0;
+                lineWrapped[i] = true;
+                lineFilled[i] = true;
+            }
+        }
+    }
+
+    /** the sample length samples back on line i; zero where a restarted line has not written yet */
+    double readLine(int i, unsigned int length) const
+    {
+        if (writeIndex[i] >= length)
+            return lineMemory[activeOffset[i] + writeIndex[i] - length];
+
+        return lineFilled[i] ? lineMemory[activeOffset[i] + writeIndex[i] + activeSize[i] - length] : 0.0;
+    }
+
+    /** sieve of Eratosthenes up to maxValue */
+    void createPrimeTable(unsigned int maxValue)
+    {
+        std::vector<bool> composite(maxValue + 1, false);
+        primes.clear();
+
+        for (unsigned int n = 2; n <= maxValue; n++)
+        {
+            if (composite[n])
+                continue;
+
+            primes.push_back(n);
+            for (unsigned long long m = (unsigned long long)n * n; m <= maxValue; m += n)
+                composite[(size_t)m] = true;
+        }
+    }
+
+    /** fold what the active lines wrote into the per-region extents, before the lines move to other regions */
+    void recordWrittenExtents()
+    {
+        for (int i = 0; i < numLines; i++)
+        {
+            unsigned int extent = lineWrapped[i] ? activeSize[i] : writeIndex[i];
+            regionWritten[activeRegion[i]] = std::max(regionWritten[activeRegion[i]], extent);
+            lineWrapped[i] = false;
+        }
+    }
+
+    /** move the lines to the regions of targetNumLines and restart them empty at targetBaseLength */
+    void switchNumLines()
+    {
+        recordWrittenExtents();
+
+        numLines = targetNumLines;
+        int stride = maxNumLines / numLines;
+
+        for (int i = 0; i < numLines; i++)
+        {
+            // --- with fewer lines use every other (or fourth) region and ratio so the spread stays the same
+            int region = i * stride + stride - 1;
+            activeRegion[i] = region;
+            activeOffset[i] = lineOffset[region];
+            activeSize[i] = lineSize[region];
+
+            writeIndex[i] = 0;
+            lineFilled[i] = false;
+            dampingState[i] = 0.0;
+        }
+
+        // --- empty lines take the new lengths without a crossfade
+        baseLength = targetBaseLength;
+        fadeRemaining = 0;
+        calculateLineLengths(lineLength);
+        updateGains();
+
+        outputScale = 1.0 / sqrt((double)numLines);
+        switchGain = 1.0;
+
+        frameProcessor = numLines == 4 ? &FeedbackDelayNetwork::processFrame<4>
+                       : numLines == 8 ? &FeedbackDelayNetwork::processFrame<8>
+                                       : &FeedbackDelayNetwork::processFrame<16>;
+    }
+
+    /** pick the lengths for targetBaseLength and crossfade the read taps to them */
+    void startLengthCrossfade()
+    {
+        baseLength = targetBaseLength;
+        calculateLineLengths(fadeLength);
+
+        fadeRemaining = crossfadeLength;
+        fadeGain = fadeStep;
+        updateGains();
+    }
+
+    /** pick strictly increasing primes near the target lengths of baseLength so that all lines are mutually prime */
+    void calculateLineLengths(unsigned int* lengths) const
+    {
+        unsigned int previous = 0;
+
+        for (int i = 0; i < numLines; i++)
+        {
+            unsigned int target = (unsigned int)(regionRatio[activeRegion[i]] * baseLength);
+            if (target <= previous) target = previous + 1;
+
+            auto prime = std::lower_bound(primes.begin(), primes.end(), target);
+            unsigned int length = prime != primes.end() ? *prime : primes.back();
+            if (length >= activeSize[i]) length = activeSize[i] - 1;
+
+            lengths[i] = length;
+            previous = length;
+        }
+    }
+
+    /** equal decay rate for every line: gain and damping scale with the length the line is heading to */
+    void updateGains()
+    {
+        const unsigned int* lengths = fadeRemaining > 0 ? fadeLength : lineLength;
+
+        for (int i = 0; i < numLines; i++)
+        {
+            double relativeLength = (double)lengths[i] / baseLength;
+            lineGain[i] = pow(feedback, relativeLength) * matrixScale();
+            dampingCoefficient[i] = damping > 0.0 ? pow(damping, 1.0 / relativeLength) : 0.0;
+        }
+    }
+
+    /** normalization of the Hadamard matrix, folded into the line gains */
+    double matrixScale() const { return 1.0 / sqrt((double)numLines); }
+
+    /** in-place unnormalized Walsh-Hadamard transform of N values; with N fixed the butterflies unroll */
+    template <int N>
+    static void fastHadamardTransform(double* x)
+    {
+        for (int h = 1; h < N; h <<= 1)
+        {
+            for (int i = 0; i < N; i += h << 1)
+            {
+                for (int j = i; j < i + h; j++)
+                {
+                    double a = x[j];
+                    double b = x[j + h];
+                    x[j] = a + b;
+                    x[j + h] = a - b;
+                }
+            }
+        }
+    }
+
+    static constexpr unsigned int primeHeadroom = 128;	///< prime gaps below 1e6 are < 128
+    static constexpr unsigned int minBaseLength = 64;	///< keeps the shortest line longer than the line count
+    static constexpr double crossfade_mSec = 10.0;		///< read tap crossfade and line count fade out
+
+    ZeroedArray<float> lineMemory = nullptr;		///< all lines, one contiguous block
+    unsigned int lineMemorySize = 0;				///< total size in samples
+    double regionRatio[maxNumLines] = {};			///< length of each region's line relative to the base delay
+    unsigned int lineOffset[maxNumLines] = {};		///< start of each line's region
+    unsigned int lineSize[maxNumLines] = {};		///< size of each line's region
+    int activeRegion[maxNumLines] = {};				///< region of each active line
+    unsigned int activeOffset[maxNumLines] = {};	///< region start of each active line
+    unsigned int activeSize[maxNumLines] = {};		///< region size of each active line
+    unsigned int lineLength[maxNumLines] = {};		///< current (prime) delay of each active line
+    unsigned int fadeLength[maxNumLines] = {};		///< delay each active line crossfades to
+    unsigned int writeIndex[maxNumLines] = {};		///< write position within each region
+    bool lineWrapped[maxNumLines] = {};				///< active line wrapped since its extent was last recorded
+    bool lineFilled[maxNumLines] = {};				///< active line wrapped since it (re)started: its whole region is its own
+    unsigned int regionWritten[maxNumLines] = {};	///< samples from each region start that may be non-zero
+    double lineGain[maxNumLines] = {};				///< feedback gain incl. matrix normalization
+    double dampingCoefficient[maxNumLines] = {};	///< one-pole lowpass coefficient per line
+    double dampingState[maxNumLines] = {};			///< one-pole lowpass state per line
+
+    std::vector<unsigned int> primes;				///< all primes up to the longest line
+
+    /** processFrame() for the current line count */
+    void (FeedbackDelayNetwork::*frameProcessor)(double, double, double&, double&) = &FeedbackDelayNetwork::processFrame<8>;
+
+    int numLines = 8;
+    int targetNumLines = 8;				///< line count to switch to once the output has faded out
+    double sampleRate = 0.0;
+    unsigned int maxDelayInSamples = 0;
+    unsigned int baseLength = 0;		///< base delay of lineLength, or of fadeLength while crossfading
+    unsigned int targetBaseLength = 0;	///< latest base delay from setParameters()
+    double feedback = 0.0;
+    double damping = 0.0;
+    double outputScale = 1.0;
+    unsigned int crossfadeLength = 1;	///< crossfade_mSec in frames
+    double fadeStep = 1.0;				///< crossfade increment per frame
+    double fadeGain = 0.0;				///< weight of the fadeLength taps
+    unsigned int fadeRemaining = 0;		///< frames left in the read tap crossfade
+    double switchGain = 1.0;			///< output gain while fading out for a line count switch
+};
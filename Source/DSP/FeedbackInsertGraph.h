@@ -0,0 +1,443 @@
+// FeedbackInsertGraph.h
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "DSPUtils.h"
+#include "IAudioSignalProcessor.h"
+
+/**
+\struct FeedbackInsertGraphParameters
+\ingroup FX-Objects
+\brief
+Custom parameter structure for the FeedbackInsertGraph object: the node in each slot, in processing
+order, and the settings shared by all nodes of a type.
+*/
+struct FeedbackInsertGraphParameters
+{
+    static constexpr int maxNumSlots = 4;
+
+    bool operator==(const FeedbackInsertGraphParameters& other) const
+    {
+        return std::equal(slots, slots + maxNumSlots, other.slots) &&
+               lowpass_Hz == other.lowpass_Hz && highpass_Hz == other.highpass_Hz && drive_dB == other.drive_dB &&
+               modulationRate_Hz == other.modulationRate_Hz && modulationDepth_mSec == other.modulationDepth_mSec;
+    }
+    bool operator!=(const FeedbackInsertGraphParameters& other) const { return !(*this == other); }
+
+    feedbackInsertType slots[maxNumSlots] = { feedbackInsertType::kOff, feedbackInsertType::kOff,
+                                              feedbackInsertType::kOff, feedbackInsertType::kOff };	///< nodes in processing order
+
+    double lowpass_Hz = 8000.0;			///< kLowpass cutoff (2nd order Butterworth)
+    double highpass_Hz = 80.0;			///< kHighpass cutoff (2nd order Butterworth)
+    double drive_dB = 6.0;				///< kSaturator input gain
+    double modulationRate_Hz = 0.6;		///< kModulation LFO rate
+    double modulationDepth_mSec = 1.0;	///< kModulation delay swing, up to maxModulationDepth_mSec
+};
+
+/**
+\class FeedbackInsertGraph
+\ingroup FX-Objects
+\brief
+The FeedbackInsertGraph object is an ordered chain of processing nodes for the feedback path of
+AudioDelay (setFeedbackInserts(), one graph per line): filters, a saturator and a modulated delay,
+in any order, plus one external IAudioSignalProcessor such as the feedback IR convolution.
+
+- Nodes run on blocks of blockSize samples: the graph collects its input, runs every node over the
+  whole block in turn and plays the result back one block later. Its latency is one block (plus the
+  external processor's), which AudioDelay takes off the line, so the echoes keep their timing.
+- updateBlockSize() picks the block from the shortest delay: the largest power of two between
+  minBlockSize and maxBlockSize that fits next to the external processor's latency. It shrinks as
+  soon as the delay gets too short and only grows with a quarter block to spare, so a delay time
+  sitting on a boundary does not flip it. A new size drops the block in flight (a gap of one block
+  in the repeats).
+- Node storage is a pool: maxNumSlots nodes and one block of memory for their modulation lines and
+  the block buffers, allocated in prepare(). setParameters() assigns nodes to slots and is
+  realtime-safe; a node keeps its state when its slot moves, so reordering does not click.
+- The kSaturator is tanh(drive * x) / drive: unity gain for quiet repeats and a soft ceiling for
+  loud ones, so the loop never gets louder than without it. The kModulation delay swings between 0
+  and twice the depth, so the repeats come about one depth later each pass, like tape wow.
+- The external processor runs in the first kProcessor slot, or after the last node if no slot
+  places it; later kProcessor slots pass through.
+
+Audio I/O:
+- Processes mono samples; AudioDelay runs one graph per line.
+*/
+class FeedbackInsertGraph : public IAudioSignalProcessor
+{
+public:
+    FeedbackInsertGraph() {}	/* C-TOR */
+    ~FeedbackInsertGraph() {}	/* D-TOR */
+
+    static constexpr int maxNumSlots = FeedbackInsertGraphParameters::maxNumSlots;
+    static constexpr uint32_t minBlockSize = 16;
+    static constexpr uint32_t maxBlockSize = 256;
+    static constexpr double maxModulationDepth_mSec = 5.0;
+
+    /** largest power of two block, between minBlockSize and maxBlockSize, of at most availableSamples */
+    static uint32_t getBlockSize(double availableSamples)
+    {
+        uint32_t size = minBlockSize;
+        while (size < maxBlockSize && 2.0 * size <= availableSamples)
+            size *= 2;
+
+        return size;
+    }
+
+    /** allocate the node pool for a sample rate; the LFO starts at lfoPhase (radians); do NOT call from realtime audio thread */
+    void prepare(double _sampleRate, double _lfoPhase = 0.0)
+    {
+        sampleRate = _sampleRate;
+        lfoPhase = _lfoPhase;
+
+        // --- modulation lines: the longest swing plus the interpolation's older sample
+        modulationLineLength = 1;
+        while (modulationLineLength < (uint32_t)(2.0 * maxModulationDepth_mSec * sampleRate / 1000.0) + 2)
+            modulationLineLength <<= 1;
+
+        pool = allocateZeroed<double>(2 * (size_t)maxBlockSize + (size_t)maxNumSlots * modulationLineLength);
+        inputBlock = pool.get();
+        outputBlock = inputBlock + maxBlockSize;
+        for (int n = 0; n < maxNumSlots; n++)
+            nodes[n].line = outputBlock + maxBlockSize + (size_t)n * modulationLineLength;
+
+        blockSize = minBlockSize;
+        updateCoefficients();
+        reset(sampleRate);
+    }
+
+    /** set the chain and the node settings; nodes that stay in the chain keep their state */
+    void setParameters(const FeedbackInsertGraphParameters& _parameters)
+    {
+        if (_parameters == parameters && sampleRate > 0.0)
+            return;
+
+        parameters = _parameters;
+
+        // --- each slot takes the first free node already of its type, then the rest take any free node
+        int nodeOfSlot[maxNumSlots];
+        bool taken[maxNumSlots] = {};
+
+        for (int s = 0; s < maxNumSlots; s++)
+        {
+            nodeOfSlot[s] = -1;
+            if (!isNodeType(parameters.slots[s]))
+                continue;
+
+            for (int n = 0; n < maxNumSlots && nodeOfSlot[s] < 0; n++)
+                if (!taken[n] && nodes[n].type == parameters.slots[s])
+                {
+                    nodeOfSlot[s] = n;
+                    taken[n] = true;
+                }
+        }
+
+        for (int s = 0; s < maxNumSlots; s++)
+        {
+            if (!isNodeType(parameters.slots[s]) || nodeOfSlot[s] >= 0)
+                continue;
+
+            int n = 0;
+            while (taken[n])
+                n++;
+
+            nodeOfSlot[s] = n;
+            taken[n] = true;
+            nodes[n].type = parameters.slots[s];
+            clearNode(nodes[n]);
+        }
+
+        // --- nodes left over are free for the next change
+        for (int n = 0; n < maxNumSlots; n++)
+            if (!taken[n])
+                nodes[n].type = feedbackInsertType::kOff;
+
+        for (int s = 0; s < maxNumSlots; s++)
+            slotNodes[s] = nodeOfSlot[s];
+
+        updateCoefficients();
+        updateChain();
+    }
+
+    /** the processor run by the kProcessor slot, not owned; nullptr for none; changes the latency */
+    void setProcessor(IAudioSignalProcessor* _processor)
+    {
+        if (_processor == processor)
+            return;
+
+        processor = _processor;
+        if (processor != nullptr)
+            processor->reset(sampleRate);
+
+        updateChain();
+    }
+
+    IAudioSignalProcessor* getProcessor() const { return processor; }
+
+    /** pick the block size for the shortest delay of the line; true if it changed, and with it the latency */
+    bool updateBlockSize(double minimumDelayInSamples)
+    {
+        double available = minimumDelayInSamples - (double)getProcessorLatency();
+        uint32_t fitting = getBlockSize(available);
+        uint32_t roomy = getBlockSize(available / 1.25);
+
+        uint32_t next = fitting < blockSize ? fitting : roomy > blockSize ? roomy : blockSize;
+        if (next == blockSize)
+            return false;
+
+        blockSize = next;
+        clearBlocks();
+        return true;
+    }
+
+    uint32_t getBlockSize() const { return blockSize; }
+
+    /** true if anything is in the chain; an empty graph delays its input by one block and does nothing else */
+    bool isActive() const { return chainLength > 0; }
+
+    /** clear the block buffers, the node states and the processor */
+    virtual bool reset(double _sampleRate)
+    {
+        if (!pool)
+            return false;
+
+        clearBlocks();
+        for (int n = 0; n < maxNumSlots; n++)
+            clearNode(nodes[n]);
+
+        if (processor != nullptr)
+            processor->reset(_sampleRate);
+
+        return true;
+    }
+
+    /** one sample in, the chain's output for the sample one block (plus the processor's latency) ago out */
+    virtual double processAudioSample(double xn)
+    {
+        double yn = outputBlock[position];
+        inputBlock[position] = xn;
+
+        if (++position == blockSize)
+            processBlock();
+
+        return yn;
+    }
+
+    /** return false: this object only processes samples */
+    virtual bool canProcessAudioFrame() { return false; }
+
+    /** one block, plus the processor's latency when it is in the chain */
+    virtual uint32_t getLatencySamples() { return blockSize + getProcessorLatency(); }
+
+    /** bytes allocated for the pool */
+    size_t getMemoryBytes() const
+    {
+        return pool ? (2 * (size_t)maxBlockSize + (size_t)maxNumSlots * modulationLineLength) * sizeof(double) : 0;
+    }
+
+private:
+    struct Node
+    {
+        feedbackInsertType type = feedbackInsertType::kOff;
+
+        // --- kLowpass, kHighpass: transposed direct form II biquad
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+        double z1 = 0.0, z2 = 0.0;
+
+        // --- kSaturator
+        double drive = 1.0;
+
+        // --- kModulation: a slice of the pool
+        double* line = nullptr;
+        uint32_t writeIndex = 0;
+        double depth = 0.0;				///< half the swing, in samples
+        double phase = 0.0;
+        double phaseIncrement = 0.0;
+    };
+
+    static bool isNodeType(feedbackInsertType type) { return type != feedbackInsertType::kOff && type != feedbackInsertType::kProcessor; }
+
+    uint32_t getProcessorLatency() const { return processorInChain ? processor->getLatencySamples() : 0; }
+
+    void clearBlocks()
+    {
+        if (!pool)
+            return;
+
+        memset(inputBlock, 0, 2 * (size_t)maxBlockSize * sizeof(double));
+        position = 0;
+    }
+
+    void clearNode(Node& node)
+    {
+        node.z1 = node.z2 = 0.0;
+        node.writeIndex = 0;
+        node.phase = lfoPhase;
+        if (node.line != nullptr)
+            memset(node.line, 0, (size_t)modulationLineLength * sizeof(double));
+    }
+
+    /** 2nd order Butterworth lowpass or highpass, bilinear transform */
+    void setButterworth(Node& node, bool highpass, double frequency_Hz)
+    {
+        double w0 = kTwoPi * std::min(std::max(frequency_Hz, 10.0), 0.45 * sampleRate) / sampleRate;
+        double cosw0 = cos(w0);
+        double alpha = sin(w0) / (2.0 * (1.0 / sqrt(2.0)));
+        double a0 = 1.0 + alpha;
+
+        node.b0 = (highpass ? 1.0 + cosw0 : 1.0 - cosw0) / 2.0 / a0;
+        node.b1 = (highpass ? -(1.0 + cosw0) : 1.0 - cosw0) / a0;
+        node.b2 = node.b0;
+        node.a1 = -2.0 * cosw0 / a0;
+        node.a2 = (1.0 - alpha) / a0;
+    }
+
+    void updateCoefficients()
+    {
+        if (sampleRate <= 0.0)
+            return;
+
+        double depth_mSec = std::min(std::max(parameters.modulationDepth_mSec, 0.0), maxModulationDepth_mSec);
+
+        for (int n = 0; n < maxNumSlots; n++)
+        {
+            Node& node = nodes[n];
+            if (node.type == feedbackInsertType::kLowpass)
+                setButterworth(node, false, parameters.lowpass_Hz);
+            else if (node.type == feedbackInsertType::kHighpass)
+                setButterworth(node, true, parameters.highpass_Hz);
+
+            node.drive = pow(10.0, std::max(parameters.drive_dB, 0.0) / 20.0);
+            node.depth = depth_mSec * sampleRate / 1000.0;
+            node.phaseIncrement = kTwoPi * std::max(parameters.modulationRate_Hz, 0.0) / sampleRate;
+        }
+    }
+
+    /** the processing order: slot nodes, with the processor in its slot or at the end */
+    void updateChain()
+    {
+        chainLength = 0;
+        processorInChain = false;
+
+        for (int s = 0; s < maxNumSlots; s++)
+        {
+            if (parameters.slots[s] == feedbackInsertType::kProcessor && processor != nullptr && !processorInChain)
+            {
+                chain[chainLength++] = processorEntry;
+                processorInChain = true;
+            }
+            else if (isNodeType(parameters.slots[s]))
+                chain[chainLength++] = slotNodes[s];
+        }
+
+        if (processor != nullptr && !processorInChain)
+        {
+            chain[chainLength++] = processorEntry;
+            processorInChain = true;
+        }
+    }
+
+    /** run the collected input block through the chain into the output block */
+    void processBlock()
+    {
+        double* x = outputBlock;
+        memcpy(x, inputBlock, blockSize * sizeof(double));
+
+        for (int c = 0; c < chainLength; c++)
+        {
+            if (chain[c] == processorEntry)
+            {
+                for (uint32_t i = 0; i < blockSize; i++)
+                    x[i] = processor->processAudioSample(x[i]);
+                continue;
+            }
+
+            Node& node = nodes[chain[c]];
+            switch (node.type)
+            {
+            case feedbackInsertType::kLowpass:
+            case feedbackInsertType::kHighpass:
+                processFilter(node, x);
+                break;
+            case feedbackInsertType::kSaturator:
+                processSaturator(node, x);
+                break;
+            case feedbackInsertType::kModulation:
+                processModulation(node, x);
+                break;
+            default:
+                break;
+            }
+        }
+
+        position = 0;
+    }
+
+    void processFilter(Node& node, double* x)
+    {
+        double z1 = node.z1, z2 = node.z2;
+        for (uint32_t i = 0; i < blockSize; i++)
+        {
+            double yn = node.b0 * x[i] + z1;
+            z1 = node.b1 * x[i] - node.a1 * yn + z2;
+            z2 = node.b2 * x[i] - node.a2 * yn;
+            x[i] = yn;
+        }
+        node.z1 = z1;
+        node.z2 = z2;
+    }
+
+    void processSaturator(const Node& node, double* x)
+    {
+        double inverseDrive = 1.0 / node.drive;
+        for (uint32_t i = 0; i < blockSize; i++)
+            x[i] = tanh(node.drive * x[i]) * inverseDrive;
+    }
+
+    void processModulation(Node& node, double* x)
+    {
+        uint32_t wrapMask = modulationLineLength - 1;
+        for (uint32_t i = 0; i < blockSize; i++)
+        {
+            node.line[node.writeIndex] = x[i];
+
+            // --- delay swings between 0 and twice the depth; linear interpolation back from the newest sample
+            double delay = node.depth * (1.0 - cos(node.phase));
+            uint32_t whole = (uint32_t)delay;
+            double fraction = delay - whole;
+            double y1 = node.line[(node.writeIndex - whole) & wrapMask];
+            double y2 = node.line[(node.writeIndex - whole - 1) & wrapMask];
+            x[i] = y1 + fraction * (y2 - y1);
+
+            node.writeIndex = (node.writeIndex + 1) & wrapMask;
+            node.phase += node.phaseIncrement;
+            if (node.phase >= kTwoPi)
+                node.phase -= kTwoPi;
+        }
+    }
+
+    static constexpr int processorEntry = -1;	///< chain entry of the external processor
+
+    double sampleRate = 0.0;
+    double lfoPhase = 0.0;
+    FeedbackInsertGraphParameters parameters;
+
+    Node nodes[maxNumSlots];						///< the pool's nodes; kOff = free
+    int slotNodes[maxNumSlots] = { -1, -1, -1, -1 };	///< node of each slot, -1 for none
+    int chain[maxNumSlots + 1] = {};				///< node indexes in processing order, processorEntry for the processor
+    int chainLength = 0;
+
+    IAudioSignalProcessor* processor = nullptr;	///< not owned
+    bool processorInChain = false;
+
+    ZeroedArray<double> pool;						///< block buffers, then one modulation line per node
+    double* inputBlock = nullptr;
+    double* outputBlock = nullptr;
+    uint32_t modulationLineLength = 0;
+    uint32_t blockSize = minBlockSize;
+    uint32_t position = 0;							///< samples into the current block
+};
@@ -0,0 +1,113 @@
+// FreezeLoopReader.h
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "CircularBuffer.h"
+
+/**
+\class FreezeLoopReader
+\ingroup FX-Objects
+\brief
+The FreezeLoopReader object loops the newest part of a CircularBuffer that is no longer written; AudioDelay
+uses one per channel to hold (freeze) the kNormal and kPingPong lines.
+
+- capture() takes the last loopLength samples, one delay's worth, so the loop starts with exactly the sample
+  the delay would have read next.
+- The end of the loop is crossfaded into the samples before its start, in place and once, so the seam is
+  smooth and playing the loop is nothing but block copies: no writes, no feedback, no interpolation, and no
+  loss however long it is held.
+- release() writes the part of the loop played since its last start back into the line, so a delay reading
+  the same distance back carries on from where the loop was.
+*/
+class FreezeLoopReader
+{
+public:
+    FreezeLoopReader() {}		/* C-TOR */
+    ~FreezeLoopReader() {}		/* D-TOR */
+
+    /** start looping the newest samples of the buffer; nothing may be written to it until release()
+    \param delayInSamples delay the line was read at; the loop is (int)delayInSamples + 1 samples long
+    \param crossfadeLength seam crossfade; shortened for short loops and to the history the buffer holds
+    */
+    void capture(CircularBuffer<double>& buffer, double delayInSamples, uint32_t crossfadeLength)
+    {
+        uint32_t bufferLength = buffer.getWrapMask() + 1;
+
+        wrapMask = buffer.getWrapMask();
+        loopLength = std::min((uint32_t)std::max(delayInSamples, 0.0) + 1, bufferLength);
+        loopStart = (buffer.getWriteIndex() - loopLength) & wrapMask;
+        position = 0;
+
+        // --- fade the end of the loop into the samples that led up to its start
+        uint32_t fadeLength = std::min(crossfadeLength, std::min(loopLength / 2, bufferLength - loopLength));
+        double* samples = buffer.getBuffer();
+
+        for (uint32_t i = 0; i < fadeLength; i++)
+        {
+            double weight = (double)(i + 1) / fadeLength;
+            uint32_t loopIndex = (loopStart + loopLength - fadeLength + i) & wrapMask;
+            uint32_t leadInIndex = (loopStart - fadeLength + i) & wrapMask;
+
+            samples[loopIndex] = weight * samples[leadInIndex] + (1.0 - weight) * samples[loopIndex];
+        }
+    }
+
+    /** read the next numSamples of the loop */
+    void readBlock(const CircularBuffer<double>& buffer, double* output, uint32_t numSamples)
+    {
+        const double* samples = buffer.getBuffer();
+
+        // --- contiguous copies, split at the loop seam and the end of the buffer
+        while (numSamples > 0)
+        {
+            uint32_t readIndex = (loopStart + position) & wrapMask;
+            uint32_t part = std::min(numSamples, std::min(loopLength - position, wrapMask + 1 - readIndex));
+
+            std::copy(samples + readIndex, samples + readIndex + part, output);
+
+            output += part;
+            numSamples -= part;
+            position += part;
+            if (position == loopLength)
+                position = 0;
+        }
+    }
+
+    /** read the next sample of the loop */
+    double readSample(const CircularBuffer<double>& buffer)
+    {
+        double yn = buffer.getBuffer()[(loopStart + position) & wrapMask];
+
+        if (++position == loopLength)
+            position = 0;
+
+        return yn;
+    }
+
+    /** stop looping: unroll the part of the loop played since its last start into the buffer, so it reads
+        (int)delayInSamples back as if the loop had been written all along; runs through up to one loop */
+    void release(CircularBuffer<double>& buffer)
+    {
+        double chunk[64];
+
+        for (uint32_t done = 0; done < position;)
+        {
+            uint32_t n = std::min(position - done, std::min((uint32_t)64, loopLength));
+
+            buffer.readBlock((int)loopLength - 1, chunk, n);
+            buffer.writeBlock(chunk, n);
+            done += n;
+        }
+
+        position = 0;
+    }
+
+private:
+    uint32_t loopStart = 0;		///< buffer index of the first loop sample
+    uint32_t loopLength = 1;	///< samples in the loop
+    uint32_t position = 0;		///< next loop sample to play
+    uint32_t wrapMask = 0;		///< buffer wrap mask
+};
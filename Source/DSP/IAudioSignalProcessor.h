@@ -2,7 +2,7 @@
 
 #pragma once
 
-#include <JuceHeader.h>
+#include <cstdint>
 
 /**
 \class IAudioSignalProcessor
@@ -34,6 +34,9 @@ public:
     /** set or change the sample rate; normally this is done during reset( ) but may be needed outside of initialzation */
     virtual void setSampleRate(double _sampleRate) {}
 
+    /** delay between an input sample and its output, in samples; 0 unless the derived object buffers its input */
+    virtual uint32_t getLatencySamples() { return 0; }
+
     /** switch to enable/disable the aux input */
     virtual void enableAuxInput(bool enableAuxInput) {}
 
@@ -2,9 +2,11 @@
 
 #include "LowpassParamSmoother.h"
 
+#include "DSPUtils.h"
+
 void LowpassParamSmoother::initializeLowpassSmoothing(float smoothingTimeInMs, float samplingRate)
 {
-    const float twoPi = juce::MathConstants<float>::twoPi;
+    const float twoPi = (float)kTwoPi;
 
     a = exp(-twoPi / (smoothingTimeInMs * 0.001f * samplingRate));
     b = 1.0f - a;
@@ -15,4 +17,20 @@ float LowpassParamSmoother::processLowpassSmoothing(float inputValue)
 {
     outputValue = (inputValue * b) + (outputValue * a);
     return outputValue;
+}
+
+// Smooths a whole block toward inputValue; returns false if every output equals
+// the previous output, i.e. the smoother has settled and the block is static.
+bool LowpassParamSmoother::processLowpassSmoothing(float inputValue, float* outputValues, int numSamples)
+{
+    float previousValue = outputValue;
+    bool isMoving = false;
+
+    for (int i = 0; i < numSamples; i++)
+    {
+        outputValues[i] = processLowpassSmoothing(inputValue);
+        isMoving |= outputValues[i] != previousValue;
+    }
+
+    return isMoving;
 }
\ No newline at end of file
@@ -2,13 +2,12 @@
 
 #pragma once
 
-#include <JuceHeader.h>
-
 class LowpassParamSmoother
 {
 public:
     void initializeLowpassSmoothing(float smoothingTimeInMs, float samplingRate);
     float processLowpassSmoothing(float inputValue);
+    bool processLowpassSmoothing(float inputValue, float* outputValues, int numSamples);
 
 private:
     float a;
@@ -0,0 +1,424 @@
+// MultibandDelay.h
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include "DSPUtils.h"
+
+/**
+\class MultibandDelay
+\ingroup FX-Objects
+\brief
+The MultibandDelay object splits the input into 2 - 4 bands with Linkwitz-Riley crossovers and
+gives every band its own delay time, feedback and level: lows can repeat long and dark while the
+highs repeat short and die away quickly.
+
+- Crossovers are 4th order Linkwitz-Riley (two cascaded Butterworth 2nd order sections). Each band
+  also runs a Butterworth allpass for every crossover above it, so all bands have the same phase
+  and the summed bands are allpass: with equal delays and levels the spectrum stays flat.
+- Every band and channel is a lane running the same cascade of numSections biquads; unused
+  sections are identity, unused bands are muted in their first section. The lane loops have a
+  fixed count, so the compiler vectorizes them across lanes.
+- All lanes share one interleaved circular buffer of numLanes floats per frame; one frame is
+  written per sample. The buffer is allocated zeroed, and flush() only clears what was written.
+- The feedback of each band goes back into its own lane after the crossover, so repeats are not
+  filtered again.
+
+Audio I/O:
+- Processes stereo frames (left lanes 0 - 3, right lanes 4 - 7) or mono (left lanes only).
+- The outputs are the level-weighted sums of the delayed bands; AudioDelay mixes them with the dry signal.
+*/
+class MultibandDelay
+{
+public:
+    MultibandDelay() {}		/* C-TOR */
+    ~MultibandDelay() {}	/* D-TOR */
+
+    static constexpr int maxNumBands = 4;
+    static constexpr int numLanes = 2 * maxNumBands;		///< left bands, then right bands
+    static constexpr int numSections = 2 * (maxNumBands - 1);	///< longest cascade: a highpass pair per crossover
+    static constexpr uint32_t scratchLength = 256;			///< longest block processBlock() takes
+
+    /** create the shared buffer; do NOT call from realtime audio thread */
+    void createDelayLines(double _sampleRate, double maxDelay_mSec)
+    {
+        sampleRate = _sampleRate;
+        maxDelayInSamples = (unsigned int)(maxDelay_mSec * sampleRate / 1000.0) + 1;
+
+        // --- power of two frames, with room for the interpolation's older sample
+        bufferLength = 1;
+        while (bufferLength < maxDelayInSamples + 2)
+            bufferLength <<= 1;
+        wrapMask = bufferLength - 1;
+
+        buffer = allocateZeroed<float>((size_t)bufferLength * numLanes);
+
+        // --- the new block is all zeros: nothing to flush
+        writeIndex = 0;
+        wrapped = false;
+        clearFilterStates();
+
+        updateCoefficients();
+        updateDelays();
+    }
+
+    /** clear the buffer and the crossover states */
+    void flush()
+    {
+        unsigned int framesWritten = wrapped ? bufferLength : writeIndex;
+        if (buffer && framesWritten > 0)
+            memset(buffer.get(), 0, (size_t)framesWritten * numLanes * sizeof(float));
+
+        writeIndex = 0;
+        wrapped = false;
+        clearFilterStates();
+    }
+
+    /** turn fractional delay interpolation on or off */
+    void setInterpolate(bool b) { interpolate = b; }
+
+    /** set the band count (2 - 4), the crossovers in Hz (numBands - 1 used), each channel's delay in samples,
+        and per band: delay as a % of the channel's delay, feedback as a % and level in dB */
+    void setParameters(int _numBands, const double* crossover_Hz, double _delayInSamples_L, double _delayInSamples_R,
+        const double* delay_Pct, const double* feedback_Pct, const double* level_dB)
+    {
+        int newNumBands = std::min(std::max(_numBands, 2), maxNumBands);
+
+        // --- the crossovers only move when the split changes
+        bool splitChanged = newNumBands != numBands;
+        for (int i = 0; i < maxNumBands - 1; i++)
+        {
+            if (crossover_Hz[i] != crossoverSetting_Hz[i])
+            {
+                crossoverSetting_Hz[i] = crossover_Hz[i];
+                splitChanged = true;
+            }
+        }
+
+        numBands = newNumBands;
+        if (splitChanged)
+            updateCoefficients();
+
+        delayInSamples_L = _delayInSamples_L;
+        delayInSamples_R = _delayInSamples_R;
+
+        for (int b = 0; b < maxNumBands; b++)
+        {
+            bandDelay_Pct[b] = delay_Pct[b];
+            bandFeedback[b] = b < numBands ? std::min(std::max(feedback_Pct[b] / 100.0, 0.0), 1.0) : 0.0;
+
+            if (level_dB[b] != bandLevel_dB[b])
+            {
+                bandLevel_dB[b] = level_dB[b];
+                bandLevelGain[b] = pow(10.0, level_dB[b] / 20.0);
+            }
+        }
+
+        updateDelays();
+    }
+
+    /** bytes allocated for the shared buffer */
+    size_t getMemoryBytes() const { return buffer ? (size_t)bufferLength * numLanes * sizeof(float) : 0; }
+
+    /** the longest band delay in samples, for the tail length */
+    double getLongestDelay() const
+    {
+        double longest = 0.0;
+        for (int l = 0; l < numLanes; l++)
+            if (laneLevel[l] > 0.0)
+                longest = std::max(longest, laneDelay[l]);
+        return longest;
+    }
+
+    /** the largest band feedback (0 - 1), for the tail length */
+    double getLargestFeedback() const
+    {
+        double largest = 0.0;
+        for (int b = 0; b < numBands; b++)
+            largest = std::max(largest, bandFeedback[b]);
+        return largest;
+    }
+
+    /** process one frame; mono uses the left lanes and only sets ynL */
+    template <bool Stereo>
+    void processAudioFrame(double xnL, double xnR, double& ynL, double& ynR)
+    {
+        double bands[numLanes];
+        splitBands<Stereo>(xnL, xnR, bands);
+
+        if (interpolate)
+            delayBands<Stereo, true>(bands, ynL, ynR);
+        else
+            delayBands<Stereo, false>(bands, ynL, ynR);
+    }
+
+    /** same as numSamples processAudioFrame() calls: the crossovers run over the whole block first,
+        then the delay lanes; numSamples must not exceed scratchLength */
+    template <bool Stereo>
+    void processBlock(const float* inL, const float* inR, double* ynL, double* ynR, uint32_t numSamples)
+    {
+        for (uint32_t i = 0; i < numSamples; i++)
+            splitBands<Stereo>(inL[i], inR[i], scratchBands + i * numLanes);
+
+        if (interpolate)
+        {
+            for (uint32_t i = 0; i < numSamples; i++)
+                delayBands<Stereo, true>(scratchBands + i * numLanes, ynL[i], ynR[i]);
+        }
+        else
+        {
+            for (uint32_t i = 0; i < numSamples; i++)
+                delayBands<Stereo, false>(scratchBands + i * numLanes, ynL[i], ynR[i]);
+        }
+    }
+
+private:
+    struct Biquad
+    {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+    };
+
+    enum class sectionType { kLowpass, kHighpass, kAllpass };
+
+    /** 2nd order Butterworth section (Q = 1/sqrt(2)), bilinear transform; two lowpass or highpass
+        sections make a Linkwitz-Riley crossover and the allpass has the phase of their sum */
+    static Biquad butterworthSection(sectionType type, double frequency_Hz, double sampleRate)
+    {
+        double w0 = kTwoPi * frequency_Hz / sampleRate;
+        double cosw0 = cos(w0);
+        double alpha = sin(w0) / (2.0 * (1.0 / sqrt(2.0)));
+        double a0 = 1.0 + alpha;
+
+        Biquad section;
+        if (type == sectionType::kLowpass)
+        {
+            section.b0 = (1.0 - cosw0) / 2.0 / a0;
+            section.b1 = (1.0 - cosw0) / a0;
+            section.b2 = section.b0;
+        }
+        else if (type == sectionType::kHighpass)
+        {
+            section.b0 = (1.0 + cosw0) / 2.0 / a0;
+            section.b1 = -(1.0 + cosw0) / a0;
+            section.b2 = section.b0;
+        }
+        else
+        {
+            section.b0 = (1.0 - alpha) / a0;
+            section.b1 = -2.0 * cosw0 / a0;
+            section.b2 = (1.0 + alpha) / a0;
+        }
+        section.a1 = -2.0 * cosw0 / a0;
+        section.a2 = (1.0 - alpha) / a0;
+        return section;
+    }
+
+    /** cascade of each band: for every crossover below it a highpass pair, at its upper edge a lowpass pair,
+        above that one allpass per crossover */
+    void updateCoefficients()
+    {
+        if (sampleRate <= 0.0)
+            return;
+
+        // --- ascending crossovers, below Nyquist
+        double crossover_Hz[maxNumBands - 1];
+        double lowest = 20.0;
+        for (int i = 0; i < numBands - 1; i++)
+        {
+            crossover_Hz[i] = std::min(std::max(crossoverSetting_Hz[i], lowest), 0.45 * sampleRate);
+            lowest = crossover_Hz[i];
+        }
+
+        for (int b = 0; b < maxNumBands; b++)
+        {
+            Biquad cascade[numSections];
+
+            if (b >= numBands)
+            {
+                // --- unused band: silence
+                cascade[0].b0 = 0.0;
+            }
+            else
+            {
+                int s = 0;
+                for (int i = 0; i < numBands - 1; i++)
+                {
+                    if (i < b)
+                    {
+                        cascade[s++] = butterworthSection(sectionType::kHighpass, crossover_Hz[i], sampleRate);
+                        cascade[s++] = butterworthSection(sectionType::kHighpass, crossover_Hz[i], sampleRate);
+                    }
+                    else if (i == b)
+                    {
+                        cascade[s++] = butterworthSection(sectionType::kLowpass, crossover_Hz[i], sampleRate);
+                        cascade[s++] = butterworthSection(sectionType::kLowpass, crossover_Hz[i], sampleRate);
+                    }
+                    else
+                    {
+                        cascade[s++] = butterworthSection(sectionType::kAllpass, crossover_Hz[i], sampleRate);
+                    }
+                }
+            }
+
+            // --- the same cascade on both channels
+            for (int s = 0; s < numSections; s++)
+            {
+                for (int l : { b, b + maxNumBands })
+                {
+                    b0[s][l] = cascade[s].b0;
+                    b1[s][l] = cascade[s].b1;
+                    b2[s][l] = cascade[s].b2;
+                    a1[s][l] = cascade[s].a1;
+                    a2[s][l] = cascade[s].a2;
+                }
+            }
+        }
+    }
+
+    /** per-lane read offsets and gains from the band settings */
+    void updateDelays()
+    {
+        // --- the interpolated read needs one older sample
+        double longest = (double)(bufferLength > 2 ? bufferLength - 2 : 0);
+
+        for (int l = 0; l < numLanes; l++)
+        {
+            int b = l % maxNumBands;
+            double delay = (l < maxNumBands ? delayInSamples_L : delayInSamples_R) * bandDelay_Pct[b] / 100.0;
+
+            laneDelay[l] = std::min(std::max(delay, 0.0), longest);
+            laneDelayWhole[l] = (unsigned int)laneDelay[l];
+            laneDelayFraction[l] = laneDelay[l] - laneDelayWhole[l];
+            laneFeedback[l] = bandFeedback[b];
+            laneLevel[l] = b < numBands ? bandLevelGain[b] : 0.0;
+        }
+    }
+
+    void clearFilterStates()
+    {
+        for (int s = 0; s < numSections; s++)
+        {
+            for (int l = 0; l < numLanes; l++)
+            {
+                z1[s][l] = 0.0;
+                z2[s][l] = 0.0;
+            }
+        }
+    }
+
+    /** run the crossover cascades of one frame: transposed direct form II, every lane at once */
+    template <bool Stereo>
+    void splitBands(double xnL, double xnR, double* bands)
+    {
+        constexpr int lanes = Stereo ? numLanes : maxNumBands;
+
+        // --- a local frame: bands may point into scratchBands, which the compiler cannot prove apart from the states
+        double x[numLanes];
+        for (int l = 0; l < lanes; l++)
+            x[l] = l < maxNumBands ? xnL : xnR;
+
+        for (int s = 0; s < numSections; s++)
+        {
+            for (int l = 0; l < lanes; l++)
+            {
+                double xn = x[l];
+                double yn = b0[s][l] * xn + z1[s][l];
+                z1[s][l] = b1[s][l] * xn - a1[s][l] * yn + z2[s][l];
+                z2[s][l] = b2[s][l] * xn - a2[s][l] * yn;
+                x[l] = yn;
+            }
+        }
+
+        for (int l = 0; l < lanes; l++)
+            bands[l] = x[l];
+    }
+
+    /** read every lane, write band + feedback * delayed, and sum the weighted delayed bands per channel */
+    template <bool Stereo, bool Interpolate>
+    void delayBands(const double* bands, double& ynL, double& ynR)
+    {
+        constexpr int lanes = Stereo ? numLanes : maxNumBands;
+
+        double delayed[numLanes];
+        const float* frames = buffer.get();
+
+        for (int l = 0; l < lanes; l++)
+        {
+            // --- read before write: the last written frame is writeIndex - 1
+            unsigned int readIndex = (writeIndex - 1 - laneDelayWhole[l]) & wrapMask;
+            double y1 = frames[readIndex * numLanes + l];
+
+            if constexpr (Interpolate)
+            {
+                // --- same weighted sum as doLinearInterpolation() with the one older sample
+                double y2 = frames[((readIndex - 1) & wrapMask) * numLanes + l];
+                delayed[l] = laneDelayFraction[l] * y2 + (1.0 - laneDelayFraction[l]) * y1;
+            }
+            else
+            {
+                delayed[l] = y1;
+            }
+        }
+
+        float* frame = buffer.get() + (size_t)writeIndex * numLanes;
+        for (int l = 0; l < lanes; l++)
+            frame[l] = (float)(bands[l] + laneFeedback[l] * delayed[l]);
+
+        double outL = 0.0, outR = 0.0;
+        for (int b = 0; b < maxNumBands; b++)
+        {
+            outL += laneLevel[b] * delayed[b];
+            if constexpr (Stereo)
+                outR += laneLevel[b + maxNumBands] * delayed[b + maxNumBands];
+        }
+        ynL = outL;
+        ynR = outR;
+
+        writeIndex = (writeIndex + 1) & wrapMask;
+        if (writeIndex == 0)
+            wrapped = true;
+    }
+
+    ZeroedArray<float> buffer = nullptr;	///< numLanes interleaved floats per frame
+    unsigned int bufferLength = 0;			///< frames, a power of two
+    unsigned int wrapMask = 0;				///< bufferLength - 1
+    unsigned int writeIndex = 0;			///< frame written next
+    bool wrapped = false;					///< every frame may be non-zero
+    bool interpolate = true;				///< fractional delay interpolation
+
+    // --- crossover cascades, one column per lane
+    double b0[numSections][numLanes] = {};
+    double b1[numSections][numLanes] = {};
+    double b2[numSections][numLanes] = {};
+    double a1[numSections][numLanes] = {};
+    double a2[numSections][numLanes] = {};
+    double z1[numSections][numLanes] = {};	///< transposed direct form II states
+    double z2[numSections][numLanes] = {};
+
+    // --- per-lane delay settings
+    double laneDelay[numLanes] = {};				///< delay in samples incl. fraction
+    unsigned int laneDelayWhole[numLanes] = {};		///< whole samples of laneDelay
+    double laneDelayFraction[numLanes] = {};		///< fractional part of laneDelay
+    double laneFeedback[numLanes] = {};				///< feedback gain
+    double laneLevel[numLanes] = {};				///< output gain; 0 for unused bands
+
+    // --- settings
+    int numBands = 3;
+    double crossoverSetting_Hz[maxNumBands - 1] = { 250.0, 2500.0, 8000.0 };
+    double bandDelay_Pct[maxNumBands] = { 100.0, 100.0, 100.0, 100.0 };
+    double bandFeedback[maxNumBands] = {};
+    double bandLevel_dB[maxNumBands] = {};
+    double bandLevelGain[maxNumBands] = { 1.0, 1.0, 1.0, 1.0 };
+    double delayInSamples_L = 0.0;
+    double delayInSamples_R = 0.0;
+
+    double sampleRate = 0.0;
+    unsigned int maxDelayInSamples = 0;
+
+    double scratchBands[scratchLength * numLanes];	///< crossover outputs of one block, frame by frame
+};
@@ -0,0 +1,105 @@
+// QualityGovernor.h
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+/**
+\class QualityGovernor
+\ingroup FX-Objects
+\brief
+The QualityGovernor object watches how much of each block's deadline (its duration, numSamples / sampleRate)
+the processing took, and picks a quality level: 0 is full quality, every level above it is cheaper. What a
+level means is up to the caller; the governor only decides when to move.
+
+- Steps down one level when a block uses more than stepDownLoad of its deadline. After a change it waits
+  settle_mSec before stepping down again, so a single slow block costs one level, not all of them.
+- Steps up one level once every block for holdTime has stayed below stepUpLoad. The gap between the two
+  loads is the hysteresis; the cheaper levels must not bring the load below stepUpLoad by themselves.
+- A step down soon after a step up means the step up did not fit: the hold time doubles (up to
+  maxHoldTime_mSec), so a load sitting at the edge does not flip the quality every few seconds.
+
+No allocation, no locks; call update() from the audio thread after each block.
+*/
+class QualityGovernor
+{
+public:
+    QualityGovernor() {}		/* C-TOR */
+    ~QualityGovernor() {}		/* D-TOR */
+
+    static constexpr double stepDownLoad = 0.7;			///< fraction of the deadline that triggers a step down
+    static constexpr double stepUpLoad = 0.35;			///< every block must stay below this to step up
+    static constexpr double settle_mSec = 50.0;			///< no second step down within this time
+    static constexpr double minHoldTime_mSec = 2000.0;	///< quiet time before stepping up
+    static constexpr double maxHoldTime_mSec = 32000.0;	///< longest hold after repeated failed step ups
+
+    /** set the sample rate and the number of levels (2 or more); starts at full quality */
+    void prepare(double _sampleRate, int _numLevels)
+    {
+        sampleRate = _sampleRate;
+        numLevels = std::max(2, _numLevels);
+        reset();
+    }
+
+    /** back to full quality with the shortest hold time */
+    void reset()
+    {
+        level = 0;
+        holdTime_mSec = minHoldTime_mSec;
+        samplesSinceChange = UINT64_MAX / 2;	// settled: the first slow block may step down
+        quietSamples = 0;
+        lastChangeWasUp = false;
+    }
+
+    /** account for one processed block; returns the level to use from the next block on */
+    int update(uint32_t numSamples, double blockTime_Sec)
+    {
+        if (numSamples == 0 || sampleRate <= 0.0)
+            return level;
+
+        double load = blockTime_Sec * sampleRate / numSamples;
+        samplesSinceChange += numSamples;
+        quietSamples = load < stepUpLoad ? quietSamples + numSamples : 0;
+
+        if (load > stepDownLoad && level < numLevels - 1 && samplesSinceChange >= toSamples(settle_mSec))
+        {
+            // --- the last step up did not hold: wait longer before the next one
+            if (lastChangeWasUp && samplesSinceChange < toSamples(holdTime_mSec))
+                holdTime_mSec = std::min(holdTime_mSec * 2.0, maxHoldTime_mSec);
+
+            changeLevel(level + 1);
+        }
+        else if (level > 0 && quietSamples >= toSamples(holdTime_mSec))
+        {
+            changeLevel(level - 1);
+        }
+
+        return level;
+    }
+
+    /** current level: 0 = full quality */
+    int getLevel() const { return level; }
+
+    /** current hold time before a step up, in mSec */
+    double getHoldTime_mSec() const { return holdTime_mSec; }
+
+private:
+    uint64_t toSamples(double mSec) const { return (uint64_t)(mSec * sampleRate / 1000.0); }
+
+    void changeLevel(int newLevel)
+    {
+        lastChangeWasUp = newLevel < level;
+        level = newLevel;
+        samplesSinceChange = 0;
+        quietSamples = 0;
+    }
+
+    double sampleRate = 0.0;					///< current sample rate
+    int numLevels = 2;							///< levels 0 to numLevels - 1
+    int level = 0;								///< current level
+    double holdTime_mSec = minHoldTime_mSec;	///< quiet time needed for the next step up
+    uint64_t samplesSinceChange = 0;			///< samples processed since the last level change
+    uint64_t quietSamples = 0;					///< samples since the last block at or above stepUpLoad
+    bool lastChangeWasUp = false;				///< the last change went to better quality
+};
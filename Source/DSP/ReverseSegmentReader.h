@@ -0,0 +1,145 @@
+// ReverseSegmentReader.h
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+
+#include "CircularBuffer.h"
+#include "DSPKernels.h"
+#include "DSPUtils.h"
+
+/**
+\class ReverseSegmentReader
+\ingroup FX-Objects
+\brief
+The ReverseSegmentReader object plays the audio in a CircularBuffer backwards in overlapping
+segments; AudioDelay uses one per channel for delayAlgorithm::kReverse.
+
+- Time is split into half-cycles of halfLength samples. A segment starts at every half-cycle and
+  plays the 2 * halfLength samples before its start backwards, so two segments always overlap.
+- Each segment fades in over its first half-cycle and out over its second with sin^2 / cos^2
+  windows. The rising window is interpolated from one fixed-resolution sin^2 table at p / halfLength
+  and the falling window is one minus it, so the two always sum to one, even while the segment
+  length changes.
+- A new segment length is picked up at the next half-cycle start; it only changes the table step,
+  so nothing is recomputed on the audio thread.
+- Within a half-cycle every read comes from samples written before the half-cycle started, one
+  sample further back per output sample, so reads are block copies run backwards.
+*/
+class ReverseSegmentReader
+{
+public:
+    ReverseSegmentReader() {}		/* C-TOR */
+    ~ReverseSegmentReader() {}		/* D-TOR */
+
+    /** create the sin^2 table and the block window buffers; the longest read is 4 * maxHalfLength, so
+        maxHalfLength must be at most a quarter of the buffer; do NOT call from realtime audio thread */
+    void createWindowTables(unsigned int _maxHalfLength)
+    {
+        maxHalfLength = _maxHalfLength > 0 ? _maxHalfLength : 1;
+
+        // --- sin^2(pi/2 * k / windowTableSize) for k = 0 to windowTableSize; the last entry is the interpolation guard
+        windowTable.reset(new double[windowTableSize + 1]);
+        for (unsigned int k = 0; k <= windowTableSize; k++)
+        {
+            double s = sin(0.5 * kPi * k / windowTableSize);
+            windowTable[k] = s * s;
+        }
+
+        riseWindow.reset(new double[maxHalfLength]);
+        fallWindow.reset(new double[maxHalfLength]);
+
+        targetHalfLength = std::min(targetHalfLength, maxHalfLength);
+        reset();
+    }
+
+    /** restart like a new reader: a one-sample half-cycle first, then the segment length is picked up */
+    void reset()
+    {
+        halfLength = previousHalfLength = 1;
+        phase = 0;
+        windowStep = (double)windowTableSize;
+    }
+
+    /** set the segment length (2 * halfLength) from the delay time; takes effect at the next half-cycle */
+    void setSegmentLength(double delayInSamples)
+    {
+        unsigned int newHalfLength = (unsigned int)(delayInSamples / 2.0);
+        targetHalfLength = std::max(1u, std::min(newHalfLength, maxHalfLength));
+    }
+
+    /** samples left in the current half-cycle; readBlock() must not cross this */
+    uint32_t getSamplesToHalfCycleEnd() const { return halfLength - phase; }
+
+    /** read one reversed, windowed sample; call before the sample is written to the buffer */
+    double readSample(CircularBuffer<double>& buffer)
+    {
+        double rising = buffer.readBuffer((int)(2 * phase));
+        double falling = buffer.readBuffer((int)(2 * (phase + previousHalfLength)));
+
+        double rise = getRiseWindow(phase);
+        double yn = (1.0 - rise) * falling + rise * rising;
+
+        if (++phase == halfLength)
+            startHalfCycle();
+
+        return yn;
+    }
+
+    /** same as numSamples calls to readSample() with a buffer write after each one;
+        numSamples must not exceed getSamplesToHalfCycleEnd()
+    \param output reversed, windowed samples
+    \param scratch numSamples of temporary storage
+    */
+    void readBlock(const DSPKernelTable& kernels, CircularBuffer<double>& buffer, double* output, double* scratch, uint32_t numSamples)
+    {
+        buffer.readBlockReversed((int)(2 * phase), output, numSamples);
+        buffer.readBlockReversed((int)(2 * (phase + previousHalfLength)), scratch, numSamples);
+
+        for (uint32_t i = 0; i < numSamples; i++)
+        {
+            riseWindow[i] = getRiseWindow(phase + i);
+            fallWindow[i] = 1.0 - riseWindow[i];
+        }
+
+        kernels.crossfadeBlock(scratch, fallWindow.get(), output, riseWindow.get(), output, numSamples);
+
+        phase += numSamples;
+        if (phase == halfLength)
+            startHalfCycle();
+    }
+
+private:
+    void startHalfCycle()
+    {
+        previousHalfLength = halfLength;
+        halfLength = targetHalfLength;
+        phase = 0;
+        windowStep = (double)windowTableSize / halfLength;
+    }
+
+    /** rise[p] = sin^2(pi/2 * (p + 0.5) / halfLength), linearly interpolated from the table */
+    double getRiseWindow(unsigned int p) const
+    {
+        double position = (p + 0.5) * windowStep;
+        unsigned int index = (unsigned int)position;
+        double fraction = position - index;
+
+        return windowTable[index] + fraction * (windowTable[index + 1] - windowTable[index]);
+    }
+
+    static constexpr unsigned int windowTableSize = 4096;	///< sin^2 table resolution; interpolation error < 1e-7
+
+    std::unique_ptr<double[]> windowTable = nullptr;	///< sin^2 over a quarter period
+    std::unique_ptr<double[]> riseWindow = nullptr;	///< readBlock() fade in of the newer segment
+    std::unique_ptr<double[]> fallWindow = nullptr;	///< readBlock() fade out of the older segment
+    double windowStep = 1.0;				///< table entries per sample of the current half-cycle
+    unsigned int maxHalfLength = 1;			///< table size
+    unsigned int targetHalfLength = 1;		///< half-cycle length from the delay time
+    unsigned int halfLength = 1;			///< current half-cycle length
+    unsigned int previousHalfLength = 1;	///< previous half-cycle length (second half of the older segment)
+    unsigned int phase = 0;					///< sample position within the current half-cycle
+};
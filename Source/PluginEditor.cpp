@@ -24,13 +24,23 @@ JDelayAudioProcessorEditor::JDelayAudioProcessorEditor(JDelayAudioProcessor& p)
     feedbackSliderAttachment(audioProcessor.apvts, "FEEDBACK", feedbackSlider),
     ratioSliderAttachment(audioProcessor.apvts, "RATIO", ratioSlider),
     wetLevelSliderAttachment(audioProcessor.apvts, "WETLEVEL", wetLevelSlider),
-    delayTypeComboBoxAttachment(audioProcessor.apvts, "DELAYTYPE", delayTypeComboBox)
+    delayTypeComboBoxAttachment(audioProcessor.apvts, "DELAYTYPE", delayTypeComboBox),
+    freezeButtonAttachment(audioProcessor.apvts, "FREEZE", freezeButton)
 {
     juce::LookAndFeel::setDefaultLookAndFeel(&jDelayLnf);
 
     createDelayTypeComboBox();
+    createFeedbackSlotComboBoxes();
     createLabels();
 
+    feedbackIRButton.onClick = [this] { showFeedbackIRMenu(); };
+    updateFeedbackIRButton();
+
+    // --- lit while the repeats are held
+    freezeButton.setClickingTogglesState(true);
+    freezeButton.setColour(juce::TextButton::buttonOnColourId, juce::Colours::lightgrey);
+    freezeButton.setColour(juce::TextButton::textColourOnId, juce::Colours::black);
+
     modifyJDelaySliderColors(dryLevelSlider, dryLevelColorIds);
     modifyJDelaySliderColors(delayTimeSlider, delayTimeColorIds);
     modifyJDelaySliderColors(feedbackSlider, feedbackColorIds);
@@ -43,10 +53,12 @@ JDelayAudioProcessorEditor::JDelayAudioProcessorEditor(JDelayAudioProcessor& p)
     addAndMakeVisible(ratioSlider);
     addAndMakeVisible(wetLevelSlider);
     addAndMakeVisible(delayTypeComboBox);
+    addAndMakeVisible(feedbackIRButton);
+    addAndMakeVisible(freezeButton);
 
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize(635, 190);
+    setSize(635, 225);
 }
 
 JDelayAudioProcessorEditor::~JDelayAudioProcessorEditor()
@@ -75,6 +87,11 @@ void JDelayAudioProcessorEditor::resized()
                                               .withY(wetLevelSlider.getY() + 90)
                                               .withHeight(wetLevelSlider.getHeight() - 125)
                                               .withWidth(wetLevelSlider.getWidth()));
+    feedbackIRButton.setBounds(delayTypeComboBox.getBounds().withY(delayTypeComboBox.getBottom() + 10));
+
+    feedbackChainLabel.setBounds(0, 190, 103, 25);
+    for (int i = 0; i < FeedbackInsertGraphParameters::maxNumSlots; ++i)
+        feedbackSlotComboBoxes[i].setBounds(feedbackChainLabel.getBounds().withX(feedbackChainLabel.getRight() + i * 103).reduced(3, 0));
 
     dryLevelLabel.setBounds(0, 5, 103, 30);
     delayTimeLabel.setBounds(dryLevelLabel.getBounds().withX(dryLevelLabel.getRight()));
@@ -83,6 +100,7 @@ void JDelayAudioProcessorEditor::resized()
     wetLevelLabel.setBounds(ratioLabel.getBounds().withX(ratioLabel.getRight()));
     delayTypeLabel.setBounds(wetLevelLabel.getBounds().withX(wetLevelLabel.getRight())
                                                       .withY(wetLevelLabel.getY() + 55));
+    freezeButton.setBounds(delayTypeComboBox.getBounds().withY(wetLevelLabel.getY() + 20));
 
     dryLevelUnitsLabel.setBounds(0, 153, 103, 30);
     delayTimeUnitsLabel.setBounds(dryLevelUnitsLabel.getBounds().withX(dryLevelUnitsLabel.getRight()));
@@ -108,6 +126,7 @@ void JDelayAudioProcessorEditor::createLabels()
     createLabel(ratioLabel, juce::String("L/R Ratio"));
     createLabel(wetLevelLabel, juce::String("Wet Level"));
     createLabel(delayTypeLabel, juce::String("Delay Type"));
+    createLabel(feedbackChainLabel, juce::String("Feedback Chain"));
 
     createLabel(dryLevelUnitsLabel, juce::String("dB"));
     createLabel(delayTimeUnitsLabel, juce::String("mSec"));
@@ -120,10 +139,70 @@ void JDelayAudioProcessorEditor::createDelayTypeComboBox()
 {
     delayTypeComboBox.addItem("Normal", 1);
     delayTypeComboBox.addItem("Ping Pong", 2);
+    delayTypeComboBox.addItem("FDN", 3);
+    delayTypeComboBox.addItem("Reverse", 4);
+    delayTypeComboBox.addItem("Spectral", 5);
+    delayTypeComboBox.addItem("Multiband", 6);
+    delayTypeComboBox.addItem("BBD", 7);
     delayTypeComboBox.setSelectedItemIndex(0, juce::dontSendNotification);
     delayTypeComboBox.setJustificationType(juce::Justification::centred);
 }
 
+void JDelayAudioProcessorEditor::createFeedbackSlotComboBoxes()
+{
+    // --- slots run left to right; the IR, if no slot places it, runs after the last one
+    for (int i = 0; i < FeedbackInsertGraphParameters::maxNumSlots; ++i)
+    {
+        auto& comboBox = feedbackSlotComboBoxes[i];
+        comboBox.addItemList(juce::StringArray("Off", "Lowpass", "Highpass", "Saturator", "Modulation", "IR"), 1);
+        comboBox.setJustificationType(juce::Justification::centred);
+        addAndMakeVisible(comboBox);
+
+        feedbackSlotComboBoxAttachments[i] = std::make_unique<ComboBoxAttachment>(audioProcessor.apvts, "FXSLOT" + juce::String(i + 1), comboBox);
+    }
+}
+
+void JDelayAudioProcessorEditor::showFeedbackIRMenu()
+{
+    juce::PopupMenu menu;
+    menu.addItem(1, "Load Feedback IR...");
+    menu.addItem(2, "Clear Feedback IR", audioProcessor.getFeedbackImpulseResponseFile() != juce::File());
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&feedbackIRButton), [this](int result)
+    {
+        if (result == 2)
+        {
+            audioProcessor.clearFeedbackImpulseResponse();
+            updateFeedbackIRButton();
+        }
+
+        if (result != 1)
+            return;
+
+        feedbackIRChooser = std::make_unique<juce::FileChooser>("Feedback IR", audioProcessor.getFeedbackImpulseResponseFile(),
+                                                                "*.wav;*.aif;*.aiff;*.flac");
+        feedbackIRChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+                                       [this](const juce::FileChooser& chooser)
+        {
+            auto file = chooser.getResult();
+            if (file == juce::File())
+                return;
+
+            juce::String errorMessage;
+            if (! audioProcessor.loadFeedbackImpulseResponse(file, errorMessage))
+                juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon, "Feedback IR", errorMessage);
+
+            updateFeedbackIRButton();
+        });
+    });
+}
+
+void JDelayAudioProcessorEditor::updateFeedbackIRButton()
+{
+    auto file = audioProcessor.getFeedbackImpulseResponseFile();
+    feedbackIRButton.setButtonText(file == juce::File() ? "No Feedback IR" : file.getFileNameWithoutExtension());
+}
+
 void JDelayAudioProcessorEditor::modifyJDelaySliderColors(JDelaySlider& slider, std::vector<juce::String> colors)
 {
     slider.setColour(juce::Slider::rotarySliderOutlineColourId, juce::Colours::findColourForName(colors.at(0), defaultColor));
@@ -28,6 +28,9 @@ public:
     void createLabel(juce::Label& label, const juce::String& text);
     void createLabels();
     void createDelayTypeComboBox();
+    void createFeedbackSlotComboBoxes();
+    void showFeedbackIRMenu();
+    void updateFeedbackIRButton();
     void modifyJDelaySliderColors(JDelaySlider& slider, std::vector<juce::String> colors);
 
 private:
@@ -52,6 +55,12 @@ private:
     juce::Colour defaultColor;
 
     juce::ComboBox delayTypeComboBox;
+
+    juce::ComboBox feedbackSlotComboBoxes[FeedbackInsertGraphParameters::maxNumSlots];
+
+    juce::TextButton feedbackIRButton;
+    juce::TextButton freezeButton { "Freeze" };
+    std::unique_ptr<juce::FileChooser> feedbackIRChooser;
     
     using SliderAttachment = juce::AudioProcessorValueTreeState::SliderAttachment;
     SliderAttachment delayTimeSliderAttachment,
@@ -62,6 +71,10 @@ private:
 
     using ComboBoxAttachment = juce::AudioProcessorValueTreeState::ComboBoxAttachment;
     ComboBoxAttachment delayTypeComboBoxAttachment;
+    std::unique_ptr<ComboBoxAttachment> feedbackSlotComboBoxAttachments[FeedbackInsertGraphParameters::maxNumSlots];
+
+    using ButtonAttachment = juce::AudioProcessorValueTreeState::ButtonAttachment;
+    ButtonAttachment freezeButtonAttachment;
 
     juce::Label dryLevelLabel,
                 delayTimeLabel,
@@ -69,6 +82,7 @@ private:
                 ratioLabel,
                 wetLevelLabel,
                 delayTypeLabel,
+                feedbackChainLabel,
                 dryLevelUnitsLabel,
                 delayTimeUnitsLabel,
                 feedbackUnitsLabel,
@@ -16,18 +16,67 @@ JDelayAudioProcessor::JDelayAudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput ("Input",  juce::AudioChannelSet::stereo(), true)
+                       .withInput ("Sidechain", juce::AudioChannelSet::stereo(), false)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
                        )
 #endif
 {
+    dryLevelParameter = apvts.getRawParameterValue("DRYLEVEL");
+    delayTimeParameter = apvts.getRawParameterValue("DELAYTIME");
+    feedbackParameter = apvts.getRawParameterValue("FEEDBACK");
+    ratioParameter = apvts.getRawParameterValue("RATIO");
+    delayModeParameter = apvts.getRawParameterValue("DELAYMODE");
+    rightDelayTimeParameter = apvts.getRawParameterValue("RIGHTDELAYTIME");
+    crossFeedbackParameter = apvts.getRawParameterValue("CROSSFEEDBACK");
+    wetLevelParameter = apvts.getRawParameterValue("WETLEVEL");
+    delayTypeParameter = apvts.getRawParameterValue("DELAYTYPE");
+    dampingParameter = apvts.getRawParameterValue("DAMPING");
+    duckThresholdParameter = apvts.getRawParameterValue("DUCKTHRESHOLD");
+    duckDepthParameter = apvts.getRawParameterValue("DUCKDEPTH");
+    duckAttackParameter = apvts.getRawParameterValue("DUCKATTACK");
+    duckReleaseParameter = apvts.getRawParameterValue("DUCKRELEASE");
+    duckKeyParameter = apvts.getRawParameterValue("DUCKKEY");
+    pitchShiftParameter = apvts.getRawParameterValue("PITCHSHIFT");
+    spectralTiltParameter = apvts.getRawParameterValue("SPECTRALTILT");
+    multibandBandsParameter = apvts.getRawParameterValue("MBBANDS");
+    adaptiveQualityParameter = apvts.getRawParameterValue("ADAPTIVEQUALITY");
+    freezeParameter = apvts.getRawParameterValue("FREEZE");
+
+    for (int i = 0; i < 3; ++i)
+        multibandCrossoverParameters[i] = apvts.getRawParameterValue("MBCROSS" + juce::String(i + 1));
+
+    for (int i = 0; i < 4; ++i)
+    {
+        multibandTimeParameters[i] = apvts.getRawParameterValue("MBTIME" + juce::String(i + 1));
+        multibandFeedbackParameters[i] = apvts.getRawParameterValue("MBFEEDBACK" + juce::String(i + 1));
+        multibandLevelParameters[i] = apvts.getRawParameterValue("MBLEVEL" + juce::String(i + 1));
+    }
+
+    for (int i = 0; i < FeedbackInsertGraphParameters::maxNumSlots; ++i)
+        feedbackSlotParameters[i] = apvts.getRawParameterValue("FXSLOT" + juce::String(i + 1));
+
+    feedbackLowpassParameter = apvts.getRawParameterValue("FXLOWPASS");
+    feedbackHighpassParameter = apvts.getRawParameterValue("FXHIGHPASS");
+    feedbackDriveParameter = apvts.getRawParameterValue("FXDRIVE");
+    feedbackModRateParameter = apvts.getRawParameterValue("FXMODRATE");
+    feedbackModDepthParameter = apvts.getRawParameterValue("FXMODDEPTH");
 
+    for (auto* parameter : getParameters())
+        if (auto* rangedParameter = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+            apvts.addParameterListener(rangedParameter->paramID, this);
+
+    startTimerHz(4);
 }
 
 JDelayAudioProcessor::~JDelayAudioProcessor()
 {
+    stopTimer();
 
+    for (auto* parameter : getParameters())
+        if (auto* rangedParameter = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+            apvts.removeParameterListener(rangedParameter->paramID, this);
 }
 
 //==============================================================================
@@ -97,14 +146,52 @@ void JDelayAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock
 {
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
-    stereoDelay.reset(sampleRate);
-    
+    // --- allocates only when the sample rate changed, otherwise just clears what was written
     stereoDelay.createDelayBuffers(sampleRate, 2000.0);
+    stereoDelay.setRenderQuality(isNonRealtime());
+
+    // --- spectral bins can repeat up to twice the delay time
+    spectralDelay.prepare(sampleRate, 4000.0, juce::jmin(2, getMainBusNumOutputChannels()));
+    spectralActive = (int)delayTypeParameter->load() == spectralDelayType;
+    setLatencySamples(spectralActive ? SpectralDelay::getLatencySamples() : 0);
+
+    // --- feedback IR convolution and insert graph for the new rate; they allocate only when it changed
+    if (sampleRate != feedbackIRSampleRate)
+    {
+        // --- partitions for the delay at the new rate; the timer follows the delay from here
+        feedbackIRSampleRate = sampleRate;
+        feedbackIRPartitionSize = FeedbackConvolver::getPartitionSize(stereoDelay.getMinimumDelayInSamples());
+        feedbackConvolver_L.prepare(sampleRate);
+        feedbackConvolver_R.prepare(sampleRate);
+
+        // --- the right LFO a quarter cycle ahead: the modulation widens the repeats
+        feedbackGraph_L.prepare(sampleRate);
+        feedbackGraph_R.prepare(sampleRate, kPi / 2.0);
+
+        // --- the audio thread is stopped: take the IR for the new rate now
+        postFeedbackImpulseResponse();
+        pickUpFeedbackImpulseResponse();
+    }
+
+    statsPublisher.setConfiguration(sampleRate, stereoDelay.getBufferMemoryBytes() + spectralDelay.getMemoryBytes() +
+                                                feedbackConvolver_L.getMemoryBytes() + feedbackConvolver_R.getMemoryBytes() +
+                                                feedbackGraph_L.getMemoryBytes() + feedbackGraph_R.getMemoryBytes());
 
     delayTimeLowpassParamSmoothing.initializeLowpassSmoothing(1500.0, sampleRate);
     ratioLowpassParamSmoothing.initializeLowpassSmoothing(200.0, sampleRate);
+    rightDelayTimeLowpassParamSmoothing.initializeLowpassSmoothing(1500.0, sampleRate);
     dryLowpassParamSmoothing.initializeLowpassSmoothing(5.0, sampleRate);
     wetLowpassParamSmoothing.initializeLowpassSmoothing(5.0, sampleRate);
+
+    for (auto* curve : { &delayTimeCurve, &ratioCurve, &rightDelayTimeCurve, &dryLevelCurve, &wetLevelCurve })
+        curve->resize((size_t)juce::jmax(1, samplesPerBlock));
+
+    qualityGovernor.prepare(sampleRate, numQualityLevels);
+    applyQualityLevel(fullQuality);
+
+    // --- smoothers restart from zero: force a full update on the first block
+    pickedUpParameterVersion = 1;
+    smoothersMoving = true;
 }
 
 void JDelayAudioProcessor::releaseResources()
@@ -132,6 +219,17 @@ bool JDelayAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) co
    #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
+
+    // The sidechain may be disabled, mono or stereo
+    if (layouts.inputBuses.size() > 1)
+    {
+        auto sidechain = layouts.getChannelSet(true, 1);
+
+        if (! sidechain.isDisabled()
+         && sidechain != juce::AudioChannelSet::mono()
+         && sidechain != juce::AudioChannelSet::stereo())
+            return false;
+    }
    #endif
 
     return true;
@@ -142,27 +240,243 @@ bool JDelayAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) co
 void JDelayAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
+    auto blockStartTicks = juce::Time::getHighResolutionTicks();
+    auto totalNumInputChannels = getMainBusNumInputChannels();
+    auto totalNumOutputChannels = getMainBusNumOutputChannels();
+
+    // --- denormal or NaN input, before it is overwritten in place
+    bool denormalDetected = false, nanDetected = false;
+    bool scanSamples = statsPublisher.isPublishing() && appliedQualityLevel < noSampleScans;
+    if (scanSamples)
+        for (int ch = 0; ch < totalNumInputChannels; ++ch)
+            StatsPublisher::scanSamples(buffer.getReadPointer(ch), buffer.getNumSamples(), denormalDetected, nanDetected);
 
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    auto* leftChannelData = buffer.getWritePointer(0);
-    auto* rightChannelData = buffer.getWritePointer(1);
+    auto** channelData = buffer.getArrayOfWritePointers();
+    auto maxBlockSize = (int)delayTimeCurve.size();
+
+    if (maxBlockSize == 0)
+        return;
+
+    // --- the sidechain channels follow the main input channels in the buffer
+    auto* sidechainBus = getBusCount(true) > 1 ? getBus(true, 1) : nullptr;
+    auto numSidechainChannels = sidechainBus != nullptr && sidechainBus->isEnabled() ? sidechainBus->getNumberOfChannels() : 0;
+    auto sidechainBuffer = getBusBuffer(buffer, true, numSidechainChannels > 0 ? 1 : 0);
+
+    // --- without a connected sidechain the ducking is keyed from the input
+    stereoDelay.enableAuxInput(duckKeyFromSidechain && numSidechainChannels > 0);
+
+    // --- bounces get the Hermite reads; hosts may switch mid-stream, the delay crossfades
+    stereoDelay.setRenderQuality(isNonRealtime());
+
+    pickUpFeedbackImpulseResponse();
+
+    // --- offline there is no deadline to protect
+    if (appliedQualityLevel != fullQuality && (! adaptiveQuality || isNonRealtime()))
+    {
+        qualityGovernor.reset();
+        applyQualityLevel(fullQuality);
+    }
+
+    // --- hosts may send more samples than announced in prepareToPlay; split into curve-sized blocks
+    for (int start = 0; start < buffer.getNumSamples(); start += maxBlockSize)
+    {
+        auto numSamples = juce::jmin(maxBlockSize, buffer.getNumSamples() - start);
+
+        float* channels[2]{ channelData[0] + start, channelData[juce::jmin(1, totalNumOutputChannels - 1)] + start };
+
+        const float* sidechain[2]{ nullptr, nullptr };
+        for (int ch = 0; ch < juce::jmin(2, numSidechainChannels); ++ch)
+            sidechain[ch] = sidechainBuffer.getReadPointer(ch, start);
+
+        auto* blockAutomation = updateParameters(numSamples);
+        updateFeedbackInserts();
+
+        if (spectralSelected != spectralActive)
+        {
+            // --- the new mode starts from silence; the host is told about the changed latency
+            spectralActive = spectralSelected;
+
+            if (spectralActive)
+                spectralDelay.reset();
+            else
+                stereoDelay.reset(getSampleRate());
+
+            setLatencySamples(spectralActive ? SpectralDelay::getLatencySamples() : 0);
+        }
+
+        if (spectralActive)
+        {
+            SpectralDelay::Parameters spectralParams;
+            spectralParams.delay_mSec = (float)parameterTargets.leftDelay_mSec;
+            spectralParams.feedback_Pct = (float)parameterTargets.feedback_Pct;
+            spectralParams.damping_Pct = (float)parameterTargets.fdnDamping_Pct;
+            spectralParams.tilt_Pct = spectralTilt_Pct;
+            spectralParams.wetLevel_dB = (float)parameterTargets.wetLevel_dB;
+            spectralParams.dryLevel_dB = (float)parameterTargets.dryLevel_dB;
+            spectralDelay.setParameters(spectralParams);
+
+            // --- mono in, stereo out: both output channels start from the input
+            if (totalNumInputChannels == 1 && totalNumOutputChannels > 1)
+                juce::FloatVectorOperations::copy(channels[1], channels[0], numSamples);
+
+            spectralDelay.process(channels, juce::jmin(2, totalNumOutputChannels), numSamples);
+        }
+        else
+        {
+            stereoDelay.processAudioBlock(channels, channels, totalNumInputChannels, totalNumOutputChannels,
+                                          (uint32_t)numSamples, blockAutomation, sidechain, (uint32_t)juce::jmin(2, numSidechainChannels));
+        }
+    }
 
-    for (int i = 0; i < buffer.getNumSamples(); i++)
+    bool governing = adaptiveQuality && ! isNonRealtime();
+
+    if ((statsPublisher.isPublishing() || governing) && buffer.getNumSamples() > 0)
     {
-        updateParameters();
+        if (scanSamples)
+            for (int ch = 0; ch < totalNumOutputChannels; ++ch)
+                StatsPublisher::scanSamples(buffer.getReadPointer(ch), buffer.getNumSamples(), denormalDetected, nanDetected);
+
+        auto blockTime_Sec = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - blockStartTicks);
+
+        // --- the new level takes effect with the next block
+        if (governing)
+        {
+            auto level = qualityGovernor.update((juce::uint32)buffer.getNumSamples(), blockTime_Sec);
+            if (level != appliedQualityLevel)
+                applyQualityLevel(level);
+        }
+
+        auto blockTime_ns = (juce::uint64)(blockTime_Sec * 1.0e9);
+        auto deadline_ns = (juce::uint64)(buffer.getNumSamples() * 1.0e9 / getSampleRate());
+
+        statsPublisher.publishBlock((juce::uint32)buffer.getNumSamples(), blockTime_ns, deadline_ns,
+                                    denormalDetected, nanDetected, (juce::uint32)getActiveDelayType(),
+                                    (juce::uint32)appliedQualityLevel);
+    }
+}
+
+bool JDelayAudioProcessor::loadFeedbackImpulseResponse(const juce::File& file, juce::String& errorMessage)
+{
+    juce::AudioBuffer<float> ir;
+    double irSampleRate = 0.0;
+
+    if (! FeedbackImpulseResponse::loadFile(file, ir, irSampleRate, errorMessage))
+        return false;
+
+    feedbackIRFile = file;
+    feedbackIRSource = std::move(ir);
+    feedbackIRSourceRate = irSampleRate;
+    apvts.state.setProperty("FEEDBACKIR", file.getFullPathName(), nullptr);
+
+    postFeedbackImpulseResponse();
+    return true;
+}
+
+void JDelayAudioProcessor::clearFeedbackImpulseResponse()
+{
+    feedbackIRFile = juce::File();
+    feedbackIRSource.setSize(0, 0);
+    feedbackIRSourceRate = 0.0;
+    apvts.state.removeProperty("FEEDBACKIR", nullptr);
 
-        float inputFrame[2]{ leftChannelData[i], rightChannelData[i] };
-        float outputFrame[2];
+    postFeedbackImpulseResponse();
+}
+
+void JDelayAudioProcessor::postFeedbackImpulseResponse()
+{
+    std::shared_ptr<const FeedbackImpulseResponse> ir;
 
-        stereoDelay.processAudioFrame(inputFrame, outputFrame, totalNumInputChannels, totalNumOutputChannels);
+    if (feedbackIRSourceRate > 0.0 && feedbackIRSampleRate > 0.0)
+        ir = FeedbackImpulseResponse::get(feedbackIRSource, feedbackIRSourceRate, feedbackIRSampleRate, feedbackIRPartitionSize);
 
-        buffer.setSample(0, i, outputFrame[0]);
-        buffer.setSample(1, i, outputFrame[1]);
+    {
+        const juce::SpinLock::ScopedLockType lock(feedbackIRLock);
+        std::swap(ir, feedbackIRMailbox);
+        feedbackIRPosted = true;
     }
+
+    // --- ir now holds what the mailbox held: never picked up, or retired by the audio thread; released here
+}
+
+void JDelayAudioProcessor::timerCallback()
+{
+    // --- the partitions must fit the shortest delay, and longer ones cost less: rebuild when it crosses
+    //     a power of two. Each swap restarts the convolution, so this follows the delay a few times a second
+    auto partitionSize = feedbackIRWantedPartitionSize.load(std::memory_order_relaxed);
+
+    if (partitionSize == 0 || partitionSize == feedbackIRPartitionSize || feedbackIRSampleRate <= 0.0)
+        return;
+
+    feedbackIRPartitionSize = partitionSize;
+
+    if (feedbackIRSourceRate > 0.0)
+        postFeedbackImpulseResponse();
+}
+
+void JDelayAudioProcessor::pickUpFeedbackImpulseResponse()
+{
+    // --- never waits: if the message thread is posting, the next block picks it up
+    const juce::SpinLock::ScopedTryLockType lock(feedbackIRLock);
+
+    if (! lock.isLocked() || ! feedbackIRPosted)
+        return;
+
+    // --- a swap moves the pointers without releasing anything on this thread
+    std::swap(feedbackIR, feedbackIRMailbox);
+    feedbackIRPosted = false;
+
+    feedbackConvolver_L.setImpulseResponse(feedbackIR.get(), 0);
+    feedbackConvolver_R.setImpulseResponse(feedbackIR.get(), 1);
+    feedbackGraph_L.setProcessor(feedbackIR != nullptr ? &feedbackConvolver_L : nullptr);
+    feedbackGraph_R.setProcessor(feedbackIR != nullptr ? &feedbackConvolver_R : nullptr);
+    updateFeedbackInserts();
+}
+
+void JDelayAudioProcessor::updateFeedbackInserts()
+{
+    // --- both do nothing unless something changed
+    feedbackGraph_L.setParameters(feedbackGraphTargets);
+    feedbackGraph_R.setParameters(feedbackGraphTargets);
+
+    auto minimumDelay = stereoDelay.getMinimumDelayInSamples();
+    feedbackGraph_L.updateBlockSize(minimumDelay);
+    feedbackGraph_R.updateBlockSize(minimumDelay);
+    feedbackIRWantedPartitionSize.store(FeedbackConvolver::getPartitionSize(minimumDelay), std::memory_order_relaxed);
+
+    // --- picks up the graph's latency, which changes with its block size and with the IR
+    bool active = feedbackGraph_L.isActive();
+    stereoDelay.setFeedbackInserts(active ? &feedbackGraph_L : nullptr, active ? &feedbackGraph_R : nullptr);
+}
+
+void JDelayAudioProcessor::applyQualityLevel(int level)
+{
+    // --- integer delay times: straight copies instead of interpolated reads; a modulated delay time steps
+    stereoDelay.setInterpolate(level < integerDelayTimes);
+
+    // --- half the FDN lines: half the work, a less dense tail
+    stereoDelay.setFDNNumLines(level < fewerFDNLines ? 8 : 4);
+
+    // --- noSampleScans: processBlock skips the denormal and NaN scans of the stats feed
+
+    appliedQualityLevel = level;
+}
+
+int JDelayAudioProcessor::getActiveDelayType() const
+{
+    // --- DELAYTYPE choice index of what is running now
+    if (spectralActive)
+        return spectralDelayType;
+
+    if (parameterTargets.algorithm == delayAlgorithm::kMultiband)
+        return multibandDelayType;
+
+    if (parameterTargets.algorithm == delayAlgorithm::kBBD)
+        return bbdDelayType;
+
+    return (int)parameterTargets.algorithm;
 }
 
 //==============================================================================
@@ -196,8 +510,39 @@ void JDelayAudioProcessor::setStateInformation(const void* data, int sizeInBytes
     std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
 
     if (xmlState.get() != nullptr)
+    {
         if (xmlState->hasTagName(apvts.state.getType()))
+        {
+            // --- while the version is odd the audio thread keeps its last complete parameter set,
+            //     so the DSP never sees a half-restored state
+            parameterVersion.fetch_add(1, std::memory_order_acq_rel);
             apvts.replaceState(juce::ValueTree::fromXml(*xmlState));
+            parameterVersion.fetch_add(1, std::memory_order_release);
+
+            // --- the feedback IR is stored as its path; a missing file leaves plain feedback but keeps the path
+            auto irPath = apvts.state.getProperty("FEEDBACKIR").toString();
+            juce::String errorMessage;
+
+            if (irPath.isEmpty() || ! juce::File::isAbsolutePath(irPath))
+            {
+                if (feedbackIRFile != juce::File())
+                    clearFeedbackImpulseResponse();
+            }
+            else if (juce::File(irPath) != feedbackIRFile && ! loadFeedbackImpulseResponse(juce::File(irPath), errorMessage))
+            {
+                feedbackIRFile = juce::File();
+                feedbackIRSource.setSize(0, 0);
+                feedbackIRSourceRate = 0.0;
+                postFeedbackImpulseResponse();
+            }
+        }
+    }
+}
+
+void JDelayAudioProcessor::parameterChanged(const juce::String&, float)
+{
+    // --- may be called on any thread, including the audio thread: only bump the version
+    parameterVersion.fetch_add(2, std::memory_order_release);
 }
 
 //==============================================================================
@@ -225,6 +570,23 @@ juce::AudioProcessorValueTreeState::ParameterLayout JDelayAudioProcessor::create
         juce::NormalisableRange<float>(0.0, 100.0, 0.01, 1.0),
         50.0));
 
+    // --- Ratio: right delay = RATIO % of DELAYTIME; Independent: DELAYTIME is the left delay, RIGHTDELAYTIME the right
+    layout.add(std::make_unique<juce::AudioParameterChoice>("DELAYMODE",
+        "Delay Mode",
+        juce::StringArray("Ratio", "Independent"),
+        0));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>("RIGHTDELAYTIME",
+        "Right Delay Time",
+        juce::NormalisableRange<float>(0.0, 2000.0, 0.01, 1.0),
+        125.0));
+
+    // --- Normal type: 0 = separate lines, 100 = PingPong; see AudioDelayParameters::crossFeedback_Pct
+    layout.add(std::make_unique<juce::AudioParameterFloat>("CROSSFEEDBACK",
+        "Cross Feedback",
+        juce::NormalisableRange<float>(0.0, 100.0, 0.01, 1.0),
+        0.0));
+
     layout.add(std::make_unique<juce::AudioParameterFloat>("WETLEVEL",
         "Wet Level",
         juce::NormalisableRange<float>(-60.0, 12.0, 0.01, 1.0),
@@ -232,35 +594,228 @@ juce::AudioProcessorValueTreeState::ParameterLayout JDelayAudioProcessor::create
 
     layout.add(std::make_unique<juce::AudioParameterChoice>("DELAYTYPE",
         "Delay Type",
-        juce::StringArray("Normal", "PingPong"),
+        juce::StringArray("Normal", "PingPong", "FDN", "Reverse", "Spectral", "Multiband", "BBD"),
         0));
 
+    layout.add(std::make_unique<juce::AudioParameterFloat>("DAMPING",
+        "Damping",
+        juce::NormalisableRange<float>(0.0, 95.0, 0.01, 1.0),
+        30.0));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>("DUCKTHRESHOLD",
+        "Duck Threshold",
+        juce::NormalisableRange<float>(-60.0, 0.0, 0.01, 1.0),
+        -30.0));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>("DUCKDEPTH",
+        "Duck Depth",
+        juce::NormalisableRange<float>(0.0, 40.0, 0.01, 1.0),
+        0.0));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>("DUCKATTACK",
+        "Duck Attack",
+        juce::NormalisableRange<float>(0.1, 200.0, 0.01, 0.5),
+        10.0));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>("DUCKRELEASE",
+        "Duck Release",
+        juce::NormalisableRange<float>(10.0, 2000.0, 0.01, 0.5),
+        250.0));
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>("DUCKKEY",
+        "Duck Key",
+        juce::StringArray("Input", "Sidechain"),
+        1));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>("PITCHSHIFT",
+        "Pitch Shift",
+        juce::NormalisableRange<float>(-12.0, 12.0, 0.01, 1.0),
+        0.0));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>("SPECTRALTILT",
+        "Spectral Tilt",
+        juce::NormalisableRange<float>(-100.0, 100.0, 0.01, 1.0),
+        0.0));
+
+    layout.add(std::make_unique<juce::AudioParameterInt>("MBBANDS",
+        "Multiband Bands",
+        2, 4,
+        3));
+
+    const float crossoverDefaults[3] { 250.0f, 2500.0f, 8000.0f };
+    for (int i = 0; i < 3; ++i)
+        layout.add(std::make_unique<juce::AudioParameterFloat>("MBCROSS" + juce::String(i + 1),
+            "Multiband Crossover " + juce::String(i + 1),
+            juce::NormalisableRange<float>(40.0, 16000.0, 0.01, 0.25),
+            crossoverDefaults[i]));
+
+    // --- band times are a % of DELAYTIME, so the bands follow the delay time and its smoothing
+    const float timeDefaults[4] { 100.0f, 75.0f, 50.0f, 25.0f };
+    const float feedbackDefaults[4] { 60.0f, 50.0f, 40.0f, 30.0f };
+    for (int i = 0; i < 4; ++i)
+    {
+        layout.add(std::make_unique<juce::AudioParameterFloat>("MBTIME" + juce::String(i + 1),
+            "Multiband Time " + juce::String(i + 1),
+            juce::NormalisableRange<float>(0.0, 200.0, 0.01, 1.0),
+            timeDefaults[i]));
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>("MBFEEDBACK" + juce::String(i + 1),
+            "Multiband Feedback " + juce::String(i + 1),
+            juce::NormalisableRange<float>(0.0, 100.0, 0.01, 1.0),
+            feedbackDefaults[i]));
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>("MBLEVEL" + juce::String(i + 1),
+            "Multiband Level " + juce::String(i + 1),
+            juce::NormalisableRange<float>(-60.0, 12.0, 0.01, 1.0),
+            0.0));
+    }
+
+    layout.add(std::make_unique<juce::AudioParameterBool>("ADAPTIVEQUALITY",
+        "Adaptive Quality",
+        false));
+
+    // --- holds the Normal and PingPong lines as loops; see AudioDelayParameters::freeze
+    layout.add(std::make_unique<juce::AudioParameterBool>("FREEZE",
+        "Freeze",
+        false));
+
+    // --- feedback chain: choice index = feedbackInsertType
+    for (int i = 0; i < FeedbackInsertGraphParameters::maxNumSlots; ++i)
+        layout.add(std::make_unique<juce::AudioParameterChoice>("FXSLOT" + juce::String(i + 1),
+            "Feedback Slot " + juce::String(i + 1),
+            juce::StringArray("Off", "Lowpass", "Highpass", "Saturator", "Modulation", "IR"),
+            0));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>("FXLOWPASS",
+        "Feedback Lowpass",
+        juce::NormalisableRange<float>(200.0, 20000.0, 0.01, 0.25),
+        8000.0));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>("FXHIGHPASS",
+        "Feedback Highpass",
+        juce::NormalisableRange<float>(20.0, 2000.0, 0.01, 0.25),
+        80.0));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>("FXDRIVE",
+        "Feedback Drive",
+        juce::NormalisableRange<float>(0.0, 24.0, 0.01, 1.0),
+        6.0));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>("FXMODRATE",
+        "Feedback Mod Rate",
+        juce::NormalisableRange<float>(0.05, 5.0, 0.01, 0.5),
+        0.6));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>("FXMODDEPTH",
+        "Feedback Mod Depth",
+        juce::NormalisableRange<float>(0.0, (float)FeedbackInsertGraph::maxModulationDepth_mSec, 0.01, 1.0),
+        1.0));
+
     return layout;
 }
 
-void JDelayAudioProcessor::updateParameters()
+bool JDelayAudioProcessor::pickUpParameterTargets()
 {
-    AudioDelayParameters audioDelayParams = stereoDelay.getParameters();
+    // --- common case: one atomic load and nothing changed
+    auto version = parameterVersion.load(std::memory_order_acquire);
+
+    if (version == pickedUpParameterVersion || (version & 1) != 0)
+        return false;
 
-    audioDelayParams.updateType = delayUpdateType::kLeftPlusRatio;
+    AudioDelayParameters targets = parameterTargets;
+
+    bool independent = delayModeParameter->load(std::memory_order_relaxed) > 0.5f;
+    targets.updateType = independent ? delayUpdateType::kLeftAndRight : delayUpdateType::kLeftPlusRatio;
+    targets.dryLevel_dB = dryLevelParameter->load(std::memory_order_relaxed);
+    targets.leftDelay_mSec = delayTimeParameter->load(std::memory_order_relaxed);
+    targets.rightDelay_mSec = rightDelayTimeParameter->load(std::memory_order_relaxed);
+    targets.feedback_Pct = feedbackParameter->load(std::memory_order_relaxed);
+    targets.crossFeedback_Pct = crossFeedbackParameter->load(std::memory_order_relaxed);
+    targets.delayRatio_Pct = ratioParameter->load(std::memory_order_relaxed);
+    targets.wetLevel_dB = wetLevelParameter->load(std::memory_order_relaxed);
+    auto delayType = (int)delayTypeParameter->load(std::memory_order_relaxed);
+    bool spectral = delayType == spectralDelayType;
+    targets.algorithm = spectral ? delayAlgorithm::kNormal
+                      : delayType == multibandDelayType ? delayAlgorithm::kMultiband
+                      : delayType == bbdDelayType ? delayAlgorithm::kBBD
+                      : convertIntToEnum(delayType, delayAlgorithm);
+    targets.fdnDamping_Pct = dampingParameter->load(std::memory_order_relaxed);
+    targets.duckThreshold_dB = duckThresholdParameter->load(std::memory_order_relaxed);
+    targets.duckDepth_dB = duckDepthParameter->load(std::memory_order_relaxed);
+    targets.duckAttack_mSec = duckAttackParameter->load(std::memory_order_relaxed);
+    targets.duckRelease_mSec = duckReleaseParameter->load(std::memory_order_relaxed);
+    bool keyFromSidechain = duckKeyParameter->load(std::memory_order_relaxed) > 0.5f;
+    targets.pitchShift_Semitones = pitchShiftParameter->load(std::memory_order_relaxed);
+    float tilt = spectralTiltParameter->load(std::memory_order_relaxed);
+    bool adaptive = adaptiveQualityParameter->load(std::memory_order_relaxed) > 0.5f;
+    targets.freeze = freezeParameter->load(std::memory_order_relaxed) > 0.5f;
+    targets.multibandNumBands = (int)multibandBandsParameter->load(std::memory_order_relaxed);
+    for (int i = 0; i < 3; ++i)
+        targets.multibandCrossover_Hz[i] = multibandCrossoverParameters[i]->load(std::memory_order_relaxed);
+    for (int i = 0; i < 4; ++i)
+    {
+        targets.multibandDelay_Pct[i] = multibandTimeParameters[i]->load(std::memory_order_relaxed);
+        targets.multibandFeedback_Pct[i] = multibandFeedbackParameters[i]->load(std::memory_order_relaxed);
+        targets.multibandLevel_dB[i] = multibandLevelParameters[i]->load(std::memory_order_relaxed);
+    }
 
-    audioDelayParams.dryLevel_dB = *apvts.getRawParameterValue("DRYLEVEL");
-    audioDelayParams.dryLevel_dB = dryLowpassParamSmoothing.processLowpassSmoothing(audioDelayParams.dryLevel_dB);
+    FeedbackInsertGraphParameters graph;
+    for (int i = 0; i < FeedbackInsertGraphParameters::maxNumSlots; ++i)
+        graph.slots[i] = convertIntToEnum((int)feedbackSlotParameters[i]->load(std::memory_order_relaxed), feedbackInsertType);
+    graph.lowpass_Hz = feedbackLowpassParameter->load(std::memory_order_relaxed);
+    graph.highpass_Hz = feedbackHighpassParameter->load(std::memory_order_relaxed);
+    graph.drive_dB = feedbackDriveParameter->load(std::memory_order_relaxed);
+    graph.modulationRate_Hz = feedbackModRateParameter->load(std::memory_order_relaxed);
+    graph.modulationDepth_mSec = feedbackModDepthParameter->load(std::memory_order_relaxed);
+
+    // --- a state restore started while we were reading: keep the old set, try again next block
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (parameterVersion.load(std::memory_order_relaxed) != version)
+        return false;
 
-    audioDelayParams.leftDelay_mSec = *apvts.getRawParameterValue("DELAYTIME");
-    audioDelayParams.leftDelay_mSec = delayTimeLowpassParamSmoothing.processLowpassSmoothing(audioDelayParams.leftDelay_mSec);
+    parameterTargets = targets;
+    duckKeyFromSidechain = keyFromSidechain;
+    spectralSelected = spectral;
+    spectralTilt_Pct = tilt;
+    adaptiveQuality = adaptive;
+    feedbackGraphTargets = graph;
+    pickedUpParameterVersion = version;
+    return true;
+}
 
-    audioDelayParams.feedback_Pct = *apvts.getRawParameterValue("FEEDBACK");
+const AudioDelayAutomation* JDelayAudioProcessor::updateParameters(int numSamples)
+{
+    // --- no new targets and every smoother settled: the delay's derived values are still current
+    if (! pickUpParameterTargets() && ! smoothersMoving)
+        return nullptr;
 
-    audioDelayParams.delayRatio_Pct = *apvts.getRawParameterValue("RATIO");
-    audioDelayParams.delayRatio_Pct = ratioLowpassParamSmoothing.processLowpassSmoothing(audioDelayParams.delayRatio_Pct);
+    AudioDelayParameters audioDelayParams = parameterTargets;
 
-    audioDelayParams.wetLevel_dB = *apvts.getRawParameterValue("WETLEVEL");
-    audioDelayParams.wetLevel_dB = wetLowpassParamSmoothing.processLowpassSmoothing(audioDelayParams.wetLevel_dB);
+    // --- run the smoothers over the whole block; a settled smoother gives a constant curve
+    bool dryLevelMoving = dryLowpassParamSmoothing.processLowpassSmoothing((float)parameterTargets.dryLevel_dB, dryLevelCurve.data(), numSamples);
+    bool delayTimeMoving = delayTimeLowpassParamSmoothing.processLowpassSmoothing((float)parameterTargets.leftDelay_mSec, delayTimeCurve.data(), numSamples);
+    bool ratioMoving = ratioLowpassParamSmoothing.processLowpassSmoothing((float)parameterTargets.delayRatio_Pct, ratioCurve.data(), numSamples);
+    bool rightDelayTimeMoving = rightDelayTimeLowpassParamSmoothing.processLowpassSmoothing((float)parameterTargets.rightDelay_mSec, rightDelayTimeCurve.data(), numSamples);
+    bool wetLevelMoving = wetLowpassParamSmoothing.processLowpassSmoothing((float)parameterTargets.wetLevel_dB, wetLevelCurve.data(), numSamples);
 
-    audioDelayParams.algorithm = convertIntToEnum((int)*apvts.getRawParameterValue("DELAYTYPE"), delayAlgorithm);
+    audioDelayParams.dryLevel_dB = dryLevelCurve[0];
+    audioDelayParams.leftDelay_mSec = delayTimeCurve[0];
+    audioDelayParams.delayRatio_Pct = ratioCurve[0];
+    audioDelayParams.rightDelay_mSec = rightDelayTimeCurve[0];
+    audioDelayParams.wetLevel_dB = wetLevelCurve[0];
 
     stereoDelay.setParameters(audioDelayParams);
+
+    // --- only moving parameters are passed per sample
+    automation.dryLevel_dB = dryLevelMoving ? dryLevelCurve.data() : nullptr;
+    automation.leftDelay_mSec = delayTimeMoving ? delayTimeCurve.data() : nullptr;
+    automation.delayRatio_Pct = ratioMoving ? ratioCurve.data() : nullptr;
+    automation.rightDelay_mSec = rightDelayTimeMoving ? rightDelayTimeCurve.data() : nullptr;
+    automation.wetLevel_dB = wetLevelMoving ? wetLevelCurve.data() : nullptr;
+
+    smoothersMoving = ! automation.isStatic();
+
+    return smoothersMoving ? &automation : nullptr;
 }
 
 //==============================================================================
@@ -8,13 +8,20 @@
 
 #pragma once
 
+#include "Convolution/FeedbackConvolver.h"
 #include "DSP/AudioDelay.h"
+#include "DSP/FeedbackInsertGraph.h"
 #include "DSP/LowpassParamSmoother.h"
+#include "DSP/QualityGovernor.h"
+#include "Spectral/SpectralDelay.h"
+#include "Stats/StatsPublisher.h"
 
 #include <JuceHeader.h>
 
 //==============================================================================
-class JDelayAudioProcessor : public juce::AudioProcessor
+class JDelayAudioProcessor : public juce::AudioProcessor,
+                             private juce::AudioProcessorValueTreeState::Listener,
+                             private juce::Timer
 {
 public:
     //==============================================================================
@@ -56,17 +63,125 @@ public:
 
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
 
+    /** convolve the feedback path of Normal and PingPong with an IR file (see FeedbackConvolver); message thread */
+    bool loadFeedbackImpulseResponse(const juce::File& file, juce::String& errorMessage);
+    /** back to plain feedback; message thread */
+    void clearFeedbackImpulseResponse();
+    /** the IR file in use, or juce::File() */
+    juce::File getFeedbackImpulseResponseFile() const { return feedbackIRFile; }
+
     juce::AudioProcessorValueTreeState apvts {*this, nullptr, "Parameters", createParameterLayout()};
 
 protected:
     AudioDelay stereoDelay;
-    void updateParameters();
+    SpectralDelay spectralDelay;
+    StatsPublisher statsPublisher;
+    const AudioDelayAutomation* updateParameters(int numSamples);
+    bool pickUpParameterTargets();
 
 private:
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+
+    // --- seqlock-style version of the parameter set: bumped by 2 on every change,
+    //     odd while a state restore is replacing all parameters
+    std::atomic<juce::uint32> parameterVersion { 0 };
+    juce::uint32 pickedUpParameterVersion = 1;	// audio thread: version of parameterTargets
+    AudioDelayParameters parameterTargets;		// audio thread: unsmoothed parameter values
+    bool smoothersMoving = true;				// audio thread: a smoother was still moving last block
+    bool duckKeyFromSidechain = true;			// audio thread: DUCKKEY of parameterTargets
+    bool spectralSelected = false;				// audio thread: DELAYTYPE of parameterTargets is Spectral
+    float spectralTilt_Pct = 0.0f;				// audio thread: SPECTRALTILT of parameterTargets
+    bool spectralActive = false;				// audio thread: spectralDelay is processing, its latency is reported
+    bool adaptiveQuality = false;				// audio thread: ADAPTIVEQUALITY of parameterTargets
+
+    // --- adaptive quality levels, in the order the governor steps down; each level keeps the savings of the ones before it
+    enum QualityLevel { fullQuality, integerDelayTimes, fewerFDNLines, noSampleScans, numQualityLevels };
+
+    QualityGovernor qualityGovernor;			// audio thread: picks the level from measured block times
+    int appliedQualityLevel = fullQuality;		// audio thread: level the DSP is set up for
+
+    int getActiveDelayType() const;
+    void applyQualityLevel(int level);
+
+    // --- feedback IR: the message thread builds it for the prepared rate and posts it; the audio thread swaps it
+    //     in at the start of a block and leaves the old one in the mailbox, to be released by the next post
+    void postFeedbackImpulseResponse();
+    void pickUpFeedbackImpulseResponse();
+
+    // --- message thread: rebuilds the IR when the shortest delay asks for another partition size
+    void timerCallback() override;
+
+    FeedbackConvolver feedbackConvolver_L, feedbackConvolver_R;
+    juce::File feedbackIRFile;						// message thread
+    juce::AudioBuffer<float> feedbackIRSource;		// message thread: the file's samples, rebuilt for every sample rate
+    double feedbackIRSourceRate = 0.0;				// message thread: 0 = no IR
+    double feedbackIRSampleRate = 0.0;				// message thread: rate the convolvers are prepared for; 0 = not prepared
+    int feedbackIRPartitionSize = 0;				// message thread: partition size of the posted IR
+    std::atomic<int> feedbackIRWantedPartitionSize { 0 };	// written by the audio thread: fits the shortest delay; 0 = not known yet
+    juce::SpinLock feedbackIRLock;
+    std::shared_ptr<const FeedbackImpulseResponse> feedbackIRMailbox;	// feedbackIRLock: posted, or retired by the audio thread
+    bool feedbackIRPosted = false;					// feedbackIRLock: the mailbox holds the IR (or none) to use next
+    std::shared_ptr<const FeedbackImpulseResponse> feedbackIR;		// audio thread: in use
+
+    // --- feedback insert graph: FXSLOT1 - 4 in order, with the IR convolvers in their slot or after the last one;
+    //     its block size follows the delay time
+    void updateFeedbackInserts();
+
+    FeedbackInsertGraph feedbackGraph_L, feedbackGraph_R;
+    FeedbackInsertGraphParameters feedbackGraphTargets;	// audio thread: FX parameters of parameterTargets
+
+    // --- DELAYTYPE choice handled by spectralDelay instead of stereoDelay
+    static constexpr int spectralDelayType = 4;
+    // --- DELAYTYPE choice for delayAlgorithm::kMultiband, added after Spectral so saved choices keep their meaning
+    static constexpr int multibandDelayType = 5;
+    // --- DELAYTYPE choice for delayAlgorithm::kBBD, added after Multiband
+    static constexpr int bbdDelayType = 6;
+
+    std::atomic<float>* dryLevelParameter = nullptr;
+    std::atomic<float>* delayTimeParameter = nullptr;
+    std::atomic<float>* feedbackParameter = nullptr;
+    std::atomic<float>* ratioParameter = nullptr;
+    std::atomic<float>* delayModeParameter = nullptr;
+    std::atomic<float>* rightDelayTimeParameter = nullptr;
+    std::atomic<float>* crossFeedbackParameter = nullptr;
+    std::atomic<float>* wetLevelParameter = nullptr;
+    std::atomic<float>* delayTypeParameter = nullptr;
+    std::atomic<float>* dampingParameter = nullptr;
+    std::atomic<float>* duckThresholdParameter = nullptr;
+    std::atomic<float>* duckDepthParameter = nullptr;
+    std::atomic<float>* duckAttackParameter = nullptr;
+    std::atomic<float>* duckReleaseParameter = nullptr;
+    std::atomic<float>* duckKeyParameter = nullptr;
+    std::atomic<float>* pitchShiftParameter = nullptr;
+    std::atomic<float>* spectralTiltParameter = nullptr;
+    std::atomic<float>* multibandBandsParameter = nullptr;
+    std::atomic<float>* adaptiveQualityParameter = nullptr;
+    std::atomic<float>* freezeParameter = nullptr;
+    std::atomic<float>* multibandCrossoverParameters[3] = {};
+    std::atomic<float>* multibandTimeParameters[4] = {};
+    std::atomic<float>* multibandFeedbackParameters[4] = {};
+    std::atomic<float>* multibandLevelParameters[4] = {};
+    std::atomic<float>* feedbackSlotParameters[FeedbackInsertGraphParameters::maxNumSlots] = {};
+    std::atomic<float>* feedbackLowpassParameter = nullptr;
+    std::atomic<float>* feedbackHighpassParameter = nullptr;
+    std::atomic<float>* feedbackDriveParameter = nullptr;
+    std::atomic<float>* feedbackModRateParameter = nullptr;
+    std::atomic<float>* feedbackModDepthParameter = nullptr;
+
     LowpassParamSmoother delayTimeLowpassParamSmoothing, 
                          ratioLowpassParamSmoothing,
+                         rightDelayTimeLowpassParamSmoothing,
                          dryLowpassParamSmoothing,
                          wetLowpassParamSmoothing;
 
+    // --- smoothed parameter curves for the current block
+    std::vector<float> delayTimeCurve,
+                       ratioCurve,
+                       rightDelayTimeCurve,
+                       dryLevelCurve,
+                       wetLevelCurve;
+
+    AudioDelayAutomation automation;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (JDelayAudioProcessor)
 };
\ No newline at end of file
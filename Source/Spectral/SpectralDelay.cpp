@@ -0,0 +1,251 @@
+// SpectralDelay.cpp
+
+#include "SpectralDelay.h"
+
+namespace
+{
+    /** one run of bins with the same delay; rows never overlap, so the loop vectorizes */
+    void updateBinRun(float* __restrict writeRe, float* __restrict writeIm,
+                      const float* __restrict readRe, const float* __restrict readIm,
+                      float* __restrict re, float* __restrict im,
+                      const float* __restrict feedback, int numBinsInRun)
+    {
+        for (int k = 0; k < numBinsInRun; ++k)
+        {
+            auto delayedRe = readRe[k];
+            auto delayedIm = readIm[k];
+
+            writeRe[k] = re[k] + feedback[k] * delayedRe;
+            writeIm[k] = im[k] + feedback[k] * delayedIm;
+
+            re[k] = delayedRe;
+            im[k] = delayedIm;
+        }
+    }
+}
+
+SpectralDelay::SpectralDelay()
+{
+    // --- periodic Hann: analysis * synthesis windows at 75% overlap sum to 1.5, folded into the synthesis window
+    analysisWindow.resize((size_t)fftSize);
+    synthesisWindow.resize((size_t)fftSize);
+
+    for (int i = 0; i < fftSize; ++i)
+    {
+        auto w = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * (float)i / (float)fftSize);
+        analysisWindow[(size_t)i] = w;
+        synthesisWindow[(size_t)i] = w / 1.5f;
+    }
+
+    fftBuffer.resize((size_t)(2 * fftSize));
+    frameRe.resize((size_t)rowStride);
+    frameIm.resize((size_t)rowStride);
+
+    binPosition.resize((size_t)numBins);
+    binFeedback.resize((size_t)numBins);
+    binRuns.resize((size_t)numBins);
+}
+
+void SpectralDelay::prepare(double newSampleRate, double maxDelay_mSec, int numChannels)
+{
+    sampleRate = newSampleRate;
+    numPreparedChannels = juce::jlimit(1, 2, numChannels);
+
+    // --- the longest delay the curves can reach, in whole frames
+    numSlots = (int)std::ceil(maxDelay_mSec * 0.001 * sampleRate / hopSize) + 1;
+
+    channelState.clear();
+    channelState.resize((size_t)numPreparedChannels);
+
+    for (auto& channel : channelState)
+    {
+        // --- zeroed allocations: untouched rows cost no memory until they are written
+        channel.input.calloc((size_t)fftSize);
+        channel.output.calloc((size_t)fftSize);
+        channel.historyRe.calloc((size_t)(numSlots * rowStride));
+        channel.historyIm.calloc((size_t)(numSlots * rowStride));
+    }
+
+    for (int k = 0; k < numBins; ++k)
+    {
+        auto frequency = juce::jmax(1.0, k * sampleRate / fftSize);
+        binPosition[(size_t)k] = (float)juce::jlimit(-1.0, 1.0, std::log10(frequency / 1000.0));
+    }
+
+    writeSlot = 0;
+    numRowsWritten = 0;
+    ringPosition = 0;
+    hopPosition = 0;
+    binCurvesNeedUpdate = true;
+
+    wetGain.reset(sampleRate, 0.02);
+    dryGain.reset(sampleRate, 0.02);
+    wetGain.setCurrentAndTargetValue(juce::Decibels::decibelsToGain(parameters.wetLevel_dB));
+    dryGain.setCurrentAndTargetValue(juce::Decibels::decibelsToGain(parameters.dryLevel_dB));
+}
+
+void SpectralDelay::reset()
+{
+    for (auto& channel : channelState)
+    {
+        juce::FloatVectorOperations::clear(channel.input.get(), fftSize);
+        juce::FloatVectorOperations::clear(channel.output.get(), fftSize);
+
+        // --- rows [0, numRowsWritten) are the only ones that can be non-zero
+        juce::FloatVectorOperations::clear(channel.historyRe.get(), numRowsWritten * rowStride);
+        juce::FloatVectorOperations::clear(channel.historyIm.get(), numRowsWritten * rowStride);
+    }
+
+    writeSlot = 0;
+    numRowsWritten = 0;
+    ringPosition = 0;
+    hopPosition = 0;
+
+    wetGain.setCurrentAndTargetValue(wetGain.getTargetValue());
+    dryGain.setCurrentAndTargetValue(dryGain.getTargetValue());
+}
+
+void SpectralDelay::setParameters(const Parameters& newParameters)
+{
+    if (newParameters.delay_mSec != parameters.delay_mSec || newParameters.feedback_Pct != parameters.feedback_Pct
+        || newParameters.damping_Pct != parameters.damping_Pct || newParameters.tilt_Pct != parameters.tilt_Pct)
+        binCurvesNeedUpdate = true;
+
+    parameters = newParameters;
+
+    wetGain.setTargetValue(juce::Decibels::decibelsToGain(parameters.wetLevel_dB));
+    dryGain.setTargetValue(juce::Decibels::decibelsToGain(parameters.dryLevel_dB));
+}
+
+void SpectralDelay::updateBinCurves()
+{
+    auto centreDelayFrames = parameters.delay_mSec * 0.001 * sampleRate / hopSize;
+    auto tilt = parameters.tilt_Pct / 100.0f;
+    auto feedback = juce::jlimit(0.0f, 1.0f, parameters.feedback_Pct / 100.0f);
+    auto damping = juce::jlimit(0.0f, 1.0f, parameters.damping_Pct / 100.0f);
+
+    numBinRuns = 0;
+
+    for (int k = 0; k < numBins; ++k)
+    {
+        auto position = binPosition[(size_t)k];
+
+        // --- tilt scales the delay by up to an octave either way; damping ramps up with frequency
+        auto delayFrames = juce::jlimit(1, numSlots - 1, juce::roundToInt(centreDelayFrames * std::exp2(tilt * position)));
+        binFeedback[(size_t)k] = feedback * (1.0f - damping * 0.5f * (position + 1.0f));
+
+        // --- neighbouring bins with the same delay share a run
+        if (numBinRuns > 0 && binRuns[(size_t)(numBinRuns - 1)].delayFrames == delayFrames)
+            binRuns[(size_t)(numBinRuns - 1)].endBin = k + 1;
+        else
+            binRuns[(size_t)numBinRuns++] = { k, k + 1, delayFrames };
+    }
+
+    binCurvesNeedUpdate = false;
+}
+
+void SpectralDelay::process(float* const* channels, int numChannels, int numSamples)
+{
+    numChannels = juce::jmin(numChannels, numPreparedChannels);
+
+    if (numChannels == 0)
+        return;
+
+    for (int start = 0; start < numSamples;)
+    {
+        // --- up to the next frame; a hop never straddles the end of the rings
+        auto n = juce::jmin(numSamples - start, hopSize - hopPosition);
+
+        auto wetStart = wetGain.getCurrentValue(), dryStart = dryGain.getCurrentValue();
+        auto wetEnd = wetGain.skip(n), dryEnd = dryGain.skip(n);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto& channel = channelState[(size_t)ch];
+            auto* samples = channels[ch] + start;
+            auto* input = channel.input.get() + ringPosition;
+            auto* output = channel.output.get() + ringPosition;
+
+            for (int i = 0; i < n; ++i)
+            {
+                // --- the input ring slot about to be overwritten holds the dry sample from fftSize ago
+                auto dry = input[i];
+                input[i] = samples[i];
+
+                auto t = (float)(i + 1) / (float)n;
+                auto wetLevel = wetStart + t * (wetEnd - wetStart);
+                auto dryLevel = dryStart + t * (dryEnd - dryStart);
+
+                samples[i] = dryLevel * dry + wetLevel * output[i];
+            }
+
+            juce::FloatVectorOperations::clear(output, n);
+        }
+
+        start += n;
+        hopPosition += n;
+        ringPosition = (ringPosition + n) & (fftSize - 1);
+
+        if (hopPosition == hopSize)
+        {
+            if (binCurvesNeedUpdate)
+                updateBinCurves();
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                processFrame(channelState[(size_t)ch]);
+
+            writeSlot = writeSlot + 1 == numSlots ? 0 : writeSlot + 1;
+            numRowsWritten = juce::jmin(numRowsWritten + 1, numSlots);
+            hopPosition = 0;
+        }
+    }
+}
+
+void SpectralDelay::processFrame(Channel& channel)
+{
+    auto* data = fftBuffer.data();
+
+    // --- analysis: the oldest sample is at the ring position
+    auto firstPart = fftSize - ringPosition;
+    juce::FloatVectorOperations::multiply(data, channel.input.get() + ringPosition, analysisWindow.data(), firstPart);
+    juce::FloatVectorOperations::multiply(data + firstPart, channel.input.get(), analysisWindow.data() + firstPart, ringPosition);
+
+    fft.performRealOnlyForwardTransform(data, true);
+
+    auto* re = frameRe.data();
+    auto* im = frameIm.data();
+    for (int k = 0; k < numBins; ++k)
+    {
+        re[k] = data[2 * k];
+        im[k] = data[2 * k + 1];
+    }
+
+    // --- per-bin delay lines: write input + feedback * delayed, output the delayed frame
+    auto* writeRe = channel.historyRe.get() + writeSlot * rowStride;
+    auto* writeIm = channel.historyIm.get() + writeSlot * rowStride;
+    const auto* feedback = binFeedback.data();
+
+    for (int r = 0; r < numBinRuns; ++r)
+    {
+        const auto& run = binRuns[(size_t)r];
+        auto readSlot = writeSlot >= run.delayFrames ? writeSlot - run.delayFrames : writeSlot + numSlots - run.delayFrames;
+        const auto* readRe = channel.historyRe.get() + readSlot * rowStride;
+        const auto* readIm = channel.historyIm.get() + readSlot * rowStride;
+
+        auto k = run.startBin;
+        updateBinRun(writeRe + k, writeIm + k, readRe + k, readIm + k, re + k, im + k, feedback + k, run.endBin - k);
+    }
+
+    for (int k = 0; k < numBins; ++k)
+    {
+        data[2 * k] = re[k];
+        data[2 * k + 1] = im[k];
+    }
+
+    // --- resynthesis, overlap-added into the next fftSize output samples
+    fft.performRealOnlyInverseTransform(data);
+
+    auto* output = channel.output.get();
+    juce::FloatVectorOperations::addWithMultiply(output + ringPosition, data, synthesisWindow.data(), firstPart);
+    juce::FloatVectorOperations::addWithMultiply(output, data + firstPart, synthesisWindow.data() + firstPart, ringPosition);
+}
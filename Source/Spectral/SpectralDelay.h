@@ -0,0 +1,112 @@
+// SpectralDelay.h
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+Spectral delay: every STFT bin has its own delay line of complex frames, with delay and feedback
+following per-band curves, so high frequencies can repeat later (or earlier) and decay faster
+than low ones. Used by JDelayAudioProcessor for the "Spectral" delay type; it lives outside
+Source/DSP because it uses juce::dsp::FFT.
+
+- Analysis and resynthesis use periodic Hann windows of fftSize samples, hopSize apart (75%
+  overlap), with overlap-add. Latency is fftSize samples; the dry signal is delayed to match, and
+  the processor reports it to the host while this mode is active.
+- The frame history is one ring of numSlots rows, stored as separate real and imaginary arrays
+  (structure of arrays), one padded row of bins per frame. Delays are whole frames.
+- Bins are grouped into runs with the same delay: a run reads one row, so the per-bin feedback
+  update is a contiguous loop over plain float arrays that the compiler vectorizes. Without tilt
+  all bins form one run.
+- The ring is allocated zeroed and reset() clears only the rows written since the last reset.
+
+Cost per channel and hop (256 samples): one forward and one inverse 1024-point real FFT and a few
+passes over 513 bins. Memory per channel: 4 kB per frame of maximum delay (about 1.5 MB for 2
+seconds at 48 kHz).
+*/
+class SpectralDelay
+{
+public:
+    struct Parameters
+    {
+        float delay_mSec = 250.0f;		// delay of the bins at the centre of the tilt (1 kHz)
+        float feedback_Pct = 50.0f;		// feedback of the lowest bins
+        float damping_Pct = 30.0f;		// feedback reduction towards the highest bins
+        float tilt_Pct = 0.0f;			// +100: 10 kHz repeats at twice and 100 Hz at half the delay; -100: the reverse
+        float wetLevel_dB = -3.0f;
+        float dryLevel_dB = -3.0f;
+    };
+
+    static constexpr int fftOrder = 10;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int hopSize = fftSize / 4;
+    static constexpr int numBins = fftSize / 2 + 1;
+
+    SpectralDelay();
+
+    /** allocate the frame rings; do NOT call from the realtime audio thread */
+    void prepare(double sampleRate, double maxDelay_mSec, int numChannels);
+
+    /** clear all history; realtime-safe */
+    void reset();
+
+    /** takes effect at the next frame; the levels are ramped */
+    void setParameters(const Parameters& newParameters);
+
+    /** process numSamples in place on numChannels (up to the prepared channel count) */
+    void process(float* const* channels, int numChannels, int numSamples);
+
+    /** bytes allocated for the input, output and frame rings */
+    size_t getMemoryBytes() const { return channelState.size() * (size_t)(2 * fftSize + 2 * numSlots * rowStride) * sizeof(float); }
+
+    /** delay added to the whole signal, dry included */
+    static int getLatencySamples() { return fftSize; }
+
+private:
+    struct BinRun
+    {
+        int startBin;
+        int endBin;
+        int delayFrames;
+    };
+
+    struct Channel
+    {
+        juce::HeapBlock<float> input;		// last fftSize input samples, ring
+        juce::HeapBlock<float> output;		// overlap-add accumulator, ring
+        juce::HeapBlock<float> historyRe;	// numSlots rows of rowStride bins
+        juce::HeapBlock<float> historyIm;
+    };
+
+    void updateBinCurves();
+    void processFrame(Channel& channel);
+
+    juce::dsp::FFT fft { fftOrder };
+
+    std::vector<float> analysisWindow, synthesisWindow;
+    std::vector<float> fftBuffer;			// 2 * fftSize, interleaved spectrum
+    std::vector<float> frameRe, frameIm;	// current frame, then its delayed output
+
+    std::vector<float> binPosition;			// log-frequency position of each bin, -1 (100 Hz) to +1 (10 kHz)
+    std::vector<float> binFeedback;
+    std::vector<BinRun> binRuns;
+    int numBinRuns = 0;
+
+    std::vector<Channel> channelState;
+    int numPreparedChannels = 0;
+
+    static constexpr int rowStride = (numBins + 15) & ~15;
+    int numSlots = 2;						// frames of history, longest delay + 1
+    int writeSlot = 0;
+    int numRowsWritten = 0;					// rows written since the last reset, up to numSlots
+    int ringPosition = 0;					// position in the input and output rings
+    int hopPosition = 0;					// samples since the last frame
+
+    double sampleRate = 44100.0;
+    Parameters parameters;
+    bool binCurvesNeedUpdate = true;
+
+    juce::SmoothedValue<float> wetGain, dryGain;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectralDelay)
+};
@@ -0,0 +1,128 @@
+// StatsPublisher.cpp
+
+#include "StatsPublisher.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    std::atomic<uint64_t> nextInstanceId { 1 };
+}
+
+StatsPublisher::StatsPublisher()
+{
+    segment = StatsSegment::open(true);
+    if (segment == nullptr)
+        return;
+
+    uint32_t pid = StatsSegment::currentProcessId();
+
+    // --- claim a free slot, or one left behind by a process that has gone away
+    for (auto& candidate : segment->slots)
+    {
+        uint32_t owner = candidate.ownerPid.load(std::memory_order_acquire);
+        if (owner != 0 && StatsSegment::isProcessAlive(owner))
+            continue;
+
+        if (candidate.ownerPid.compare_exchange_strong(owner, pid, std::memory_order_acq_rel))
+        {
+            slot = &candidate;
+            break;
+        }
+    }
+
+    if (slot == nullptr)
+    {
+        StatsSegment::close(segment);
+        segment = nullptr;
+        return;
+    }
+
+    // --- continue the previous owner's sequence so a reader mid-snapshot still sees a change
+    sequence = slot->sequence.load(std::memory_order_relaxed) | 1;
+    slot->sequence.store(sequence, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->instanceId.store(nextInstanceId.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+    slot->blocksProcessed.store(0, std::memory_order_relaxed);
+    slot->samplesProcessed.store(0, std::memory_order_relaxed);
+    slot->totalBlockTime_ns.store(0, std::memory_order_relaxed);
+    slot->maxBlockTime_ns.store(0, std::memory_order_relaxed);
+    slot->deadlineOverruns.store(0, std::memory_order_relaxed);
+    slot->denormalBlocks.store(0, std::memory_order_relaxed);
+    slot->nanBlocks.store(0, std::memory_order_relaxed);
+    slot->bufferMemoryBytes.store(0, std::memory_order_relaxed);
+    slot->algorithm.store(0, std::memory_order_relaxed);
+    slot->sampleRate_Hz.store(0, std::memory_order_relaxed);
+    slot->qualityLevel.store(0, std::memory_order_relaxed);
+
+    sequence++;
+    slot->sequence.store(sequence, std::memory_order_release);
+}
+
+StatsPublisher::~StatsPublisher()
+{
+    if (slot != nullptr)
+        slot->ownerPid.store(0, std::memory_order_release);
+
+    StatsSegment::close(segment);
+}
+
+void StatsPublisher::setConfiguration(double sampleRate, uint64_t bufferMemoryBytes)
+{
+    pendingSampleRate_Hz.store((uint32_t)std::lround(sampleRate), std::memory_order_relaxed);
+    pendingBufferMemoryBytes.store(bufferMemoryBytes, std::memory_order_relaxed);
+}
+
+void StatsPublisher::publishBlock(uint32_t numSamples, uint64_t blockTime_ns, uint64_t deadline_ns,
+    bool denormalDetected, bool nanDetected, uint32_t algorithm, uint32_t qualityLevel)
+{
+    if (slot == nullptr)
+        return;
+
+    blocksProcessed++;
+    samplesProcessed += numSamples;
+    totalBlockTime_ns += blockTime_ns;
+    if (blockTime_ns > maxBlockTime_ns) maxBlockTime_ns = blockTime_ns;
+    if (blockTime_ns > deadline_ns) deadlineOverruns++;
+    if (denormalDetected) denormalBlocks++;
+    if (nanDetected) nanBlocks++;
+
+    // --- odd while writing; the fence keeps the stores below after it
+    slot->sequence.store(++sequence, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->blocksProcessed.store(blocksProcessed, std::memory_order_relaxed);
+    slot->samplesProcessed.store(samplesProcessed, std::memory_order_relaxed);
+    slot->totalBlockTime_ns.store(totalBlockTime_ns, std::memory_order_relaxed);
+    slot->maxBlockTime_ns.store(maxBlockTime_ns, std::memory_order_relaxed);
+    slot->deadlineOverruns.store(deadlineOverruns, std::memory_order_relaxed);
+    slot->denormalBlocks.store(denormalBlocks, std::memory_order_relaxed);
+    slot->nanBlocks.store(nanBlocks, std::memory_order_relaxed);
+    slot->bufferMemoryBytes.store(pendingBufferMemoryBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    slot->algorithm.store(algorithm, std::memory_order_relaxed);
+    slot->sampleRate_Hz.store(pendingSampleRate_Hz.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    slot->qualityLevel.store(qualityLevel, std::memory_order_relaxed);
+
+    slot->sequence.store(++sequence, std::memory_order_release);
+}
+
+void StatsPublisher::scanSamples(const float* samples, int numSamples, bool& denormalDetected, bool& nanDetected)
+{
+    // --- branch-free flags on the bit patterns: float compares read denormals as zero under DAZ,
+    //     which processBlock() runs with. Denormal: exponent 0, mantissa not; NaN or infinity: exponent all ones
+    uint32_t denormal = 0, notFinite = 0;
+    for (int i = 0; i < numSamples; ++i)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, samples + i, sizeof(bits));
+
+        uint32_t exponent = bits & 0x7f800000u;
+        denormal |= (uint32_t)(exponent == 0) & (uint32_t)((bits & 0x007fffffu) != 0);
+        notFinite |= (uint32_t)(exponent == 0x7f800000u);
+    }
+
+    denormalDetected = denormalDetected || denormal != 0;
+    nanDetected = nanDetected || notFinite != 0;
+}
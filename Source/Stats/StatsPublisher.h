@@ -0,0 +1,59 @@
+// StatsPublisher.h
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "StatsSegment.h"
+
+/**
+Publishes the performance counters of one plugin instance into a slot of the shared StatsSegment,
+for Tools/JDelayStats and monitoring agents on headless hosts.
+
+- The constructor and destructor claim and release the slot; if shared memory is unavailable
+  the publisher stays inactive and every call is a cheap no-op.
+- setConfiguration() may be called from any thread; the values are handed to the audio thread
+  through atomics and written to the slot with the next block, so the slot keeps one writer.
+- publishBlock() is lock-free and allocation-free: a handful of relaxed stores inside the slot's
+  sequence counter.
+*/
+class StatsPublisher
+{
+public:
+    StatsPublisher();
+    ~StatsPublisher();
+
+    /** sample rate and delay line memory, published with the next block */
+    void setConfiguration(double sampleRate, uint64_t bufferMemoryBytes);
+
+    /** count one processed block; call from the audio thread only */
+    void publishBlock(uint32_t numSamples, uint64_t blockTime_ns, uint64_t deadline_ns,
+        bool denormalDetected, bool nanDetected, uint32_t algorithm, uint32_t qualityLevel);
+
+    bool isPublishing() const { return slot != nullptr; }
+
+    /** scan samples for NaN or infinite values and for denormals; tests the bit patterns, so it also works
+        with flush-to-zero / denormals-are-zero set, and vectorizes */
+    static void scanSamples(const float* samples, int numSamples, bool& denormalDetected, bool& nanDetected);
+
+private:
+    StatsSegment::Segment* segment = nullptr;
+    StatsSegment::Slot* slot = nullptr;
+
+    std::atomic<uint32_t> pendingSampleRate_Hz { 0 };
+    std::atomic<uint64_t> pendingBufferMemoryBytes { 0 };
+
+    // --- audio thread copies of the totals: the slot is only ever stored to
+    uint64_t blocksProcessed = 0;
+    uint64_t samplesProcessed = 0;
+    uint64_t totalBlockTime_ns = 0;
+    uint64_t maxBlockTime_ns = 0;
+    uint64_t deadlineOverruns = 0;
+    uint64_t denormalBlocks = 0;
+    uint64_t nanBlocks = 0;
+    uint32_t sequence = 0;
+
+    StatsPublisher(const StatsPublisher&) = delete;
+    StatsPublisher& operator=(const StatsPublisher&) = delete;
+};
@@ -0,0 +1,131 @@
+// StatsSegment.cpp
+
+#include "StatsSegment.h"
+
+#if defined(_WIN32)
+ #define JDELAY_HAS_POSIX_SHM 0
+#else
+ #define JDELAY_HAS_POSIX_SHM 1
+ #include <cerrno>
+ #include <fcntl.h>
+ #include <signal.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+#endif
+
+#include <cstdio>
+#include <thread>
+
+namespace StatsSegment
+{
+#if JDELAY_HAS_POSIX_SHM
+    Segment* open(bool create)
+    {
+        // --- one segment per user, private to that user
+        char name[64];
+        std::snprintf(name, sizeof(name), "%s-%u", segmentName, (unsigned int)geteuid());
+
+        int fd = shm_open(name, create ? (O_RDWR | O_CREAT) : O_RDWR, 0600);
+        if (fd < 0)
+            return nullptr;
+
+        // --- only trust a segment we own that nobody else can open; a new object is empty, growing
+        //     it zero-fills, never shrink one created by another version
+        struct stat status;
+        if (fstat(fd, &status) != 0 || status.st_uid != geteuid() || (status.st_mode & 077) != 0 ||
+            (status.st_size < (off_t)sizeof(Segment) && ftruncate(fd, sizeof(Segment)) != 0))
+        {
+            ::close(fd);
+            return nullptr;
+        }
+
+        void* memory = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+
+        if (memory == MAP_FAILED)
+            return nullptr;
+
+        auto* segment = static_cast<Segment*>(memory);
+        Header& header = segment->header;
+
+        // --- the first instance fills the header; the others wait for it
+        uint32_t expected = 0;
+        if (create && header.magic.compare_exchange_strong(expected, initializing, std::memory_order_acq_rel))
+        {
+            header.layoutVersion = layoutVersion;
+            header.numSlots = numSlots;
+            header.slotSize = (uint32_t)sizeof(Slot);
+            header.magic.store(magic, std::memory_order_release);
+        }
+
+        for (int i = 0; i < 1000 && header.magic.load(std::memory_order_acquire) == initializing; i++)
+            std::this_thread::yield();
+
+        if (header.magic.load(std::memory_order_acquire) != magic || header.layoutVersion != layoutVersion ||
+            header.numSlots != numSlots || header.slotSize != (uint32_t)sizeof(Slot))
+        {
+            munmap(memory, sizeof(Segment));
+            return nullptr;
+        }
+
+        return segment;
+    }
+
+    void close(Segment* segment)
+    {
+        if (segment != nullptr)
+            munmap(segment, sizeof(Segment));
+    }
+
+    bool isProcessAlive(uint32_t pid)
+    {
+        // --- EPERM: it exists but belongs to another user
+        return pid != 0 && (kill((pid_t)pid, 0) == 0 || errno == EPERM);
+    }
+
+    uint32_t currentProcessId()
+    {
+        return (uint32_t)getpid();
+    }
+#else
+    Segment* open(bool) { return nullptr; }
+    void close(Segment*) {}
+    bool isProcessAlive(uint32_t) { return false; }
+    uint32_t currentProcessId() { return 0; }
+#endif
+
+    bool snapshot(const Slot& slot, SlotSnapshot& result)
+    {
+        for (int attempt = 0; attempt < 1000; attempt++)
+        {
+            uint32_t before = slot.sequence.load(std::memory_order_acquire);
+            if ((before & 1) != 0)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            result.ownerPid = slot.ownerPid.load(std::memory_order_relaxed);
+            result.instanceId = slot.instanceId.load(std::memory_order_relaxed);
+            result.blocksProcessed = slot.blocksProcessed.load(std::memory_order_relaxed);
+            result.samplesProcessed = slot.samplesProcessed.load(std::memory_order_relaxed);
+            result.totalBlockTime_ns = slot.totalBlockTime_ns.load(std::memory_order_relaxed);
+            result.maxBlockTime_ns = slot.maxBlockTime_ns.load(std::memory_order_relaxed);
+            result.deadlineOverruns = slot.deadlineOverruns.load(std::memory_order_relaxed);
+            result.denormalBlocks = slot.denormalBlocks.load(std::memory_order_relaxed);
+            result.nanBlocks = slot.nanBlocks.load(std::memory_order_relaxed);
+            result.bufferMemoryBytes = slot.bufferMemoryBytes.load(std::memory_order_relaxed);
+            result.algorithm = slot.algorithm.load(std::memory_order_relaxed);
+            result.sampleRate_Hz = slot.sampleRate_Hz.load(std::memory_order_relaxed);
+            result.qualityLevel = slot.qualityLevel.load(std::memory_order_relaxed);
+
+            // --- the loads above must complete before the sequence is checked again
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == before)
+                return true;
+        }
+
+        return false;
+    }
+}
@@ -0,0 +1,102 @@
+// StatsSegment.h
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+Layout of the shared-memory segment where every JDelay instance of a user publishes its
+performance counters, and the code to map it. Used by the plugin (StatsPublisher) and by the
+Tools/JDelayStats reader; no JUCE, so the reader stays a small standalone binary.
+
+- One POSIX shared-memory object per user, segmentName followed by the effective user id, holds a
+  header and numSlots fixed-size slots. It is created with mode 0600, and a segment owned by
+  someone else or open to other users is refused, so no other user can read or change the counters.
+  Instances claim a free slot by compare-and-swapping their process id into it, and reclaim
+  slots of processes that no longer exist, so no registry or lock is needed.
+- Each slot has exactly one writer, the audio thread of its instance. Writes are relaxed atomic
+  stores bracketed by a sequence counter (odd while writing); readers retry until they see the
+  same even value before and after, so a snapshot is always consistent and the writer never waits.
+- All fields are lock-free atomics, which are address-free and therefore safe across processes.
+- Not available on Windows: mapping fails and the plugin simply does not publish.
+*/
+namespace StatsSegment
+{
+    constexpr const char* segmentName = "/jdelay-stats";
+    constexpr uint32_t magic = 0x4a444c53;			// "JDLS"
+    constexpr uint32_t initializing = 1;			// magic value while the creator fills the header
+    constexpr uint32_t layoutVersion = 2;			// bumped when Slot changes
+    constexpr uint32_t numSlots = 256;
+
+    /** counters of one instance; totals count since the slot was claimed */
+    struct Slot
+    {
+        std::atomic<uint32_t> ownerPid;				// 0 = free
+        std::atomic<uint32_t> sequence;				// odd while the owner writes
+        std::atomic<uint64_t> instanceId;			// serial number within the owning process
+        std::atomic<uint64_t> blocksProcessed;
+        std::atomic<uint64_t> samplesProcessed;
+        std::atomic<uint64_t> totalBlockTime_ns;
+        std::atomic<uint64_t> maxBlockTime_ns;
+        std::atomic<uint64_t> deadlineOverruns;		// blocks that took longer than their duration
+        std::atomic<uint64_t> denormalBlocks;		// blocks with a denormal input or output sample
+        std::atomic<uint64_t> nanBlocks;			// blocks with a NaN or infinite input or output sample
+        std::atomic<uint64_t> bufferMemoryBytes;	// delay line memory allocated by the instance
+        std::atomic<uint32_t> algorithm;			// DELAYTYPE choice index
+        std::atomic<uint32_t> sampleRate_Hz;
+        std::atomic<uint32_t> qualityLevel;			// adaptive quality level, 0 = full quality
+    };
+
+    struct Header
+    {
+        std::atomic<uint32_t> magic;
+        uint32_t layoutVersion;
+        uint32_t numSlots;
+        uint32_t slotSize;
+    };
+
+    struct Segment
+    {
+        Header header;
+        Slot slots[numSlots];
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+                  "shared-memory counters must be lock-free atomics");
+
+    /** plain copy of a slot, read by snapshot() */
+    struct SlotSnapshot
+    {
+        uint32_t ownerPid = 0;
+        uint64_t instanceId = 0;
+        uint64_t blocksProcessed = 0;
+        uint64_t samplesProcessed = 0;
+        uint64_t totalBlockTime_ns = 0;
+        uint64_t maxBlockTime_ns = 0;
+        uint64_t deadlineOverruns = 0;
+        uint64_t denormalBlocks = 0;
+        uint64_t nanBlocks = 0;
+        uint64_t bufferMemoryBytes = 0;
+        uint32_t algorithm = 0;
+        uint32_t sampleRate_Hz = 0;
+        uint32_t qualityLevel = 0;
+    };
+
+    /** map the segment, creating it if needed; nullptr when shared memory is unavailable or the
+        existing segment has another layout. Do NOT call from the realtime audio thread. */
+    Segment* open(bool create);
+
+    /** unmap a segment returned by open(); the shared object itself stays for the other instances */
+    void close(Segment* segment);
+
+    /** true if a process with this id still exists */
+    bool isProcessAlive(uint32_t pid);
+
+    /** id of the calling process */
+    uint32_t currentProcessId();
+
+    /** consistent copy of a slot; false if the owner kept writing for too long */
+    bool snapshot(const Slot& slot, SlotSnapshot& result);
+}
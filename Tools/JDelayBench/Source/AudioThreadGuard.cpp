@@ -0,0 +1,172 @@
+// AudioThreadGuard.cpp
+
+#include "AudioThreadGuard.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(__linux__) && defined(__GLIBC__)
+ #define JDELAY_INTERPOSE_LIBC 1
+ #include <dlfcn.h>
+ #include <pthread.h>
+#else
+ #define JDELAY_INTERPOSE_LIBC 0
+#endif
+
+namespace
+{
+    thread_local bool onAudioThread = false;
+
+    std::atomic<uint64_t> allocations { 0 };
+    std::atomic<uint64_t> deallocations { 0 };
+    std::atomic<uint64_t> locks { 0 };
+
+    inline void noteAllocation()
+    {
+        if (onAudioThread)
+            allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    inline void noteDeallocation()
+    {
+        if (onAudioThread)
+            deallocations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+namespace AudioThreadGuard
+{
+    ScopedAudioThread::ScopedAudioThread() : previous(onAudioThread) { onAudioThread = true; }
+    ScopedAudioThread::~ScopedAudioThread() { onAudioThread = previous; }
+
+    Counts getCounts()
+    {
+        Counts counts;
+        counts.allocations = allocations.load(std::memory_order_relaxed);
+        counts.deallocations = deallocations.load(std::memory_order_relaxed);
+        counts.locks = locks.load(std::memory_order_relaxed);
+        return counts;
+    }
+
+    bool detectsLocks() { return JDELAY_INTERPOSE_LIBC != 0; }
+}
+
+#if JDELAY_INTERPOSE_LIBC
+// --- definitions in the executable take precedence over libc's for every library in the process;
+//     glibc exports its own implementations under these names
+extern "C"
+{
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* memory, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+    void __libc_free(void* memory);
+
+    void* malloc(size_t size)
+    {
+        noteAllocation();
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size)
+    {
+        noteAllocation();
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* memory, size_t size)
+    {
+        noteAllocation();
+        return __libc_realloc(memory, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size)
+    {
+        noteAllocation();
+        return __libc_memalign(alignment, size);
+    }
+
+    void* memalign(size_t alignment, size_t size)
+    {
+        noteAllocation();
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** memory, size_t alignment, size_t size)
+    {
+        noteAllocation();
+        *memory = __libc_memalign(alignment, size);
+        return *memory != nullptr || size == 0 ? 0 : 12;	// ENOMEM
+    }
+
+    void free(void* memory)
+    {
+        if (memory != nullptr)
+            noteDeallocation();
+        __libc_free(memory);
+    }
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex)
+    {
+        // --- looked up on first use; dlsym may allocate, which only counts on an audio thread
+        using LockFunction = int (*)(pthread_mutex_t*);
+        static LockFunction next = reinterpret_cast<LockFunction>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+
+        if (onAudioThread)
+            locks.fetch_add(1, std::memory_order_relaxed);
+
+        return next(mutex);
+    }
+}
+
+namespace
+{
+    // --- resolve the lock before any audio thread runs
+    struct ResolveAtStartup
+    {
+        ResolveAtStartup()
+        {
+            pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+            pthread_mutex_lock(&mutex);
+            pthread_mutex_unlock(&mutex);
+        }
+    } resolveAtStartup;
+}
+#else
+// --- portable fallback: the global allocation functions
+void* operator new(std::size_t size)
+{
+    noteAllocation();
+    if (void* memory = std::malloc(size > 0 ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    noteAllocation();
+    return std::malloc(size > 0 ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void operator delete(void* memory) noexcept
+{
+    if (memory != nullptr)
+        noteDeallocation();
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept { operator delete(memory); }
+void operator delete(void* memory, std::size_t) noexcept { operator delete(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { operator delete(memory); }
+#endif
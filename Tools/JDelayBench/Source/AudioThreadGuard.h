@@ -0,0 +1,43 @@
+// AudioThreadGuard.h
+
+#pragma once
+
+#include <cstdint>
+
+/**
+Counts heap allocations and lock acquisitions made on threads marked as audio threads, so the
+stress test can flag every block that did something a realtime callback must not do, and the
+instance benchmark can count what each phase of opening a session allocates.
+
+- Linux (glibc): malloc, calloc, realloc, free, the aligned allocators and pthread_mutex_lock are
+  interposed for the whole process, so allocations inside JUCE and the standard library count
+  too, and so do std::mutex and juce::CriticalSection.
+- Elsewhere: only operator new and delete are replaced; locks are not detected.
+- Threads that are not marked pay one thread-local flag check per call.
+*/
+namespace AudioThreadGuard
+{
+    struct Counts
+    {
+        uint64_t allocations = 0;
+        uint64_t deallocations = 0;
+        uint64_t locks = 0;
+    };
+
+    /** marks the calling thread as an audio thread while in scope */
+    class ScopedAudioThread
+    {
+    public:
+        ScopedAudioThread();
+        ~ScopedAudioThread();
+
+    private:
+        bool previous;
+    };
+
+    /** events on audio threads since the start of the process */
+    Counts getCounts();
+
+    /** true if this build can see lock acquisitions */
+    bool detectsLocks();
+}
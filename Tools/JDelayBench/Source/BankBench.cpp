@@ -0,0 +1,110 @@
+// BankBench.cpp
+
+#include "BankBench.h"
+
+BankBench::BankBench(const Options& o) : options(o)
+{
+    // --- every lane reads the same two channels: one bank's worth of input, not 32 channels of noise
+    signal.setSize(2, (int)(options.seconds * options.sampleRate));
+
+    juce::Random random(1);
+    for (int ch = 0; ch < signal.getNumChannels(); ++ch)
+        for (int i = 0; i < signal.getNumSamples(); ++i)
+            signal.setSample(ch, i, random.nextFloat() - 0.5f);
+}
+
+template <uint32_t NumLanes>
+double BankBench::render(bool useBank, double delay_mSec)
+{
+    constexpr uint32_t numChannels = 2 * NumLanes;
+
+    auto bank = std::make_unique<AudioDelayBank<NumLanes>>();
+    std::vector<std::unique_ptr<AudioDelay>> delays;
+
+    bank->createDelayBuffers(options.sampleRate, 1000.0);
+
+    for (uint32_t lane = 0; lane < NumLanes; ++lane)
+    {
+        // --- slightly different delays per lane, as independent voices would have
+        AudioDelayParameters params;
+        params.algorithm = (lane & 1) ? delayAlgorithm::kPingPong : delayAlgorithm::kNormal;
+        params.updateType = delayUpdateType::kLeftPlusRatio;
+        params.leftDelay_mSec = delay_mSec * (1.0 + 0.01 * lane);
+        params.delayRatio_Pct = 61.8;
+        params.feedback_Pct = 50.0;
+
+        bank->setParameters(lane, params);
+
+        delays.push_back(std::make_unique<AudioDelay>());
+        delays.back()->reset(options.sampleRate);
+        delays.back()->createDelayBuffers(options.sampleRate, 1000.0);
+        delays.back()->setParameters(params);
+    }
+
+    juce::AudioBuffer<float> buffer((int)numChannels, options.blockSize);
+    double seconds = 0.0;
+
+    for (int start = 0; start < signal.getNumSamples(); start += options.blockSize)
+    {
+        auto numSamples = juce::jmin(options.blockSize, signal.getNumSamples() - start);
+        for (int ch = 0; ch < (int)numChannels; ++ch)
+            buffer.copyFrom(ch, 0, signal, ch & 1, start, numSamples);
+
+        auto* channels = buffer.getArrayOfWritePointers();
+        auto startTicks = juce::Time::getHighResolutionTicks();
+
+        if (useBank)
+        {
+            bank->processAudioBlock(channels, channels, (uint32_t)numSamples);
+        }
+        else
+        {
+            for (uint32_t lane = 0; lane < NumLanes; ++lane)
+                delays[lane]->processAudioBlock(channels + 2 * lane, channels + 2 * lane, 2, 2, (uint32_t)numSamples);
+        }
+
+        seconds += juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    }
+
+    return seconds;
+}
+
+template <uint32_t NumLanes>
+void BankBench::runLanes()
+{
+    for (double delay_mSec : { 0.5, 250.0 })
+    {
+        // --- warm up once so both measurements start with hot caches
+        render<NumLanes>(true, delay_mSec);
+
+        auto separateSeconds = render<NumLanes>(false, delay_mSec);
+        auto bankSeconds = render<NumLanes>(true, delay_mSec);
+
+        auto perCore = [&](double seconds) { return juce::String((int)(NumLanes * options.seconds / seconds)); };
+
+        auto name = juce::String((int)NumLanes) + " lanes, " + juce::String(delay_mSec) + " ms";
+        std::cout << name.paddedRight(' ', 24)
+                  << perCore(separateSeconds).paddedLeft(' ', 14)
+                  << perCore(bankSeconds).paddedLeft(' ', 14)
+                  << (juce::String(separateSeconds / bankSeconds, 2) + "x").paddedLeft(' ', 14) << "\n";
+    }
+}
+
+bool BankBench::run()
+{
+    std::cout << "Rendering " << options.seconds << " s of stereo noise per delay at " << options.sampleRate << " Hz, "
+              << options.blockSize << " samples per block, " << DSPKernels::getVariantName(DSPKernels::getActiveVariant())
+              << " kernels\n"
+              << "Stereo delays per core in realtime:\n\n";
+
+    std::cout << juce::String("Case").paddedRight(' ', 24)
+              << juce::String("AudioDelay").paddedLeft(' ', 14)
+              << juce::String("bank").paddedLeft(' ', 14)
+              << juce::String("speedup").paddedLeft(' ', 14) << "\n";
+
+    runLanes<4>();
+    runLanes<8>();
+    runLanes<16>();
+
+    return true;
+}
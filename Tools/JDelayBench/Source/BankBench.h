@@ -0,0 +1,41 @@
+// BankBench.h
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "../../../Source/DSP/AudioDelay.h"
+#include "../../../Source/DSP/AudioDelayBank.h"
+
+/**
+Throughput of AudioDelayBank against the same delays as separate AudioDelay objects: renders
+stereo noise through 4, 8 and 16 lanes with short delays (lane kernel) and long delays (segment
+path), half of the lanes ping-pong, and reports how many stereo delays one core could run in
+realtime each way.
+*/
+class BankBench
+{
+public:
+    struct Options
+    {
+        double seconds = 20.0;
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+    };
+
+    explicit BankBench(const Options& options);
+
+    /** run every case and print the report */
+    bool run();
+
+private:
+    /** seconds of processing for the whole signal, through a bank or through separate delays */
+    template <uint32_t NumLanes>
+    double render(bool useBank, double delay_mSec);
+
+    template <uint32_t NumLanes>
+    void runLanes();
+
+    Options options;
+    juce::AudioBuffer<float> signal;
+};
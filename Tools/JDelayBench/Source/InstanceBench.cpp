@@ -0,0 +1,184 @@
+// InstanceBench.cpp
+
+#include "InstanceBench.h"
+
+#include "AudioThreadGuard.h"
+
+#if ! JUCE_WINDOWS
+ #include <sys/resource.h>
+#endif
+
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter();
+
+namespace
+{
+    /** peak resident set size of the process in kB; 0 where unknown */
+    juce::uint64 getPeakResident_kB()
+    {
+       #if JUCE_WINDOWS
+        return 0;
+       #else
+        rusage usage {};
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+            return 0;
+
+       #if JUCE_MAC
+        return (juce::uint64)usage.ru_maxrss / 1024;	// bytes on macOS
+       #else
+        return (juce::uint64)usage.ru_maxrss;			// kB on Linux
+       #endif
+       #endif
+    }
+}
+
+InstanceBench::InstanceBench(const Options& o) : options(o)
+{
+}
+
+template <typename Function>
+void InstanceBench::runPhase(const juce::String& name, Function&& perInstance)
+{
+    PhaseResult result;
+    result.name = name;
+
+    auto countsBefore = AudioThreadGuard::getCounts();
+    auto phaseStartTicks = juce::Time::getHighResolutionTicks();
+
+    for (int i = 0; i < options.numInstances; ++i)
+    {
+        auto startTicks = juce::Time::getHighResolutionTicks();
+        {
+            // --- marks this thread so the guard counts what the plugin allocates
+            AudioThreadGuard::ScopedAudioThread counting;
+            perInstance(i);
+        }
+        auto elapsed_us = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1.0e6;
+        result.slowest_us = juce::jmax(result.slowest_us, elapsed_us);
+    }
+
+    result.total_ms = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - phaseStartTicks) * 1.0e3;
+    result.allocations = AudioThreadGuard::getCounts().allocations - countsBefore.allocations;
+    result.peakResident_kB = getPeakResident_kB();
+
+    results.add(result);
+}
+
+juce::MemoryBlock InstanceBench::createSessionState()
+{
+    // --- a saved session: every parameter away from its default
+    std::unique_ptr<juce::AudioProcessor> processor(createPluginFilter());
+    juce::Random random(options.seed);
+
+    for (auto* parameter : processor->getParameters())
+        parameter->setValueNotifyingHost(random.nextFloat());
+
+    juce::MemoryBlock state;
+    processor->getStateInformation(state);
+    return state;
+}
+
+bool InstanceBench::run()
+{
+    auto state = createSessionState();
+
+    if (state.isEmpty())
+    {
+        std::cerr << "The plugin did not save a state" << std::endl;
+        return false;
+    }
+
+    std::cout << "Opening a session with " << options.numInstances << " instances at " << options.sampleRate
+              << " Hz, " << options.blockSize << " samples per block\n\n";
+
+    std::vector<std::unique_ptr<juce::AudioProcessor>> instances((size_t)options.numInstances);
+    juce::AudioBuffer<float> input(2, options.blockSize), buffer(2, options.blockSize);
+    juce::MidiBuffer midi;
+    juce::Random random(options.seed);
+
+    for (int ch = 0; ch < input.getNumChannels(); ++ch)
+        for (int n = 0; n < input.getNumSamples(); ++n)
+            input.setSample(ch, n, random.nextFloat() * 2.0f - 1.0f);
+
+    runPhase("construct", [&](int i)
+    {
+        instances[(size_t)i].reset(createPluginFilter());
+    });
+
+    runPhase("prepareToPlay", [&](int i)
+    {
+        instances[(size_t)i]->setRateAndBufferSizeDetails(options.sampleRate, options.blockSize);
+        instances[(size_t)i]->prepareToPlay(options.sampleRate, options.blockSize);
+    });
+
+    runPhase("setStateInformation", [&](int i)
+    {
+        instances[(size_t)i]->setStateInformation(state.getData(), (int)state.getSize());
+    });
+
+    runPhase("first block", [&](int i)
+    {
+        buffer.makeCopyOf(input, true);
+        instances[(size_t)i]->processBlock(buffer, midi);
+    });
+
+    if (options.withEditor)
+    {
+        runPhase("open/close editor", [&](int i)
+        {
+            std::unique_ptr<juce::AudioProcessorEditor> editor(instances[(size_t)i]->createEditorIfNeeded());
+        });
+    }
+
+    openSessionMemory = DelayMemoryArena::getInstance().getStatistics();
+
+    runPhase("destroy", [&](int i)
+    {
+        instances[(size_t)i]->releaseResources();
+        instances[(size_t)i].reset();
+    });
+
+    report();
+    return true;
+}
+
+void InstanceBench::report()
+{
+    std::cout << juce::String("Phase").paddedRight(' ', 22)
+              << juce::String("total ms").paddedLeft(' ', 12)
+              << juce::String("avg us").paddedLeft(' ', 12)
+              << juce::String("max us").paddedLeft(' ', 12)
+              << juce::String("allocs").paddedLeft(' ', 12)
+              << juce::String("allocs/inst").paddedLeft(' ', 13)
+              << juce::String("peak RSS MB").paddedLeft(' ', 13) << "\n";
+
+    double sessionTotal_ms = 0.0;
+
+    for (const auto& r : results)
+    {
+        auto peakResident = r.peakResident_kB > 0 ? juce::String((double)r.peakResident_kB / 1024.0, 1) : juce::String("n/a");
+
+        std::cout << r.name.paddedRight(' ', 22)
+                  << juce::String(r.total_ms, 2).paddedLeft(' ', 12)
+                  << juce::String(r.total_ms * 1.0e3 / options.numInstances, 1).paddedLeft(' ', 12)
+                  << juce::String(r.slowest_us, 1).paddedLeft(' ', 12)
+                  << juce::String((juce::int64)r.allocations).paddedLeft(' ', 12)
+                  << juce::String((double)r.allocations / options.numInstances, 1).paddedLeft(' ', 13)
+                  << peakResident.paddedLeft(' ', 13) << "\n";
+
+        if (r.name != "destroy")
+            sessionTotal_ms += r.total_ms;
+    }
+
+    std::cout << "\nSession open (all phases before destroy): " << juce::String(sessionTotal_ms, 1) << " ms\n";
+
+    // --- delay memory of the open session, and what the destroyed instances left for recycling
+    auto closedSessionMemory = DelayMemoryArena::getInstance().getStatistics();
+    auto toMB = [](size_t numBytes) { return juce::String((double)numBytes / (1024.0 * 1024.0), 1) + " MB"; };
+    const char* modeNames[] = { "none", "transparent", "explicit" };
+
+    std::cout << "Delay memory: " << toMB(openSessionMemory.inUseBytes) << " in "
+              << (int)openSessionMemory.numAllocations << " buffers, "
+              << toMB(openSessionMemory.reservedBytes) << " reserved in " << (int)openSessionMemory.numRegions << " regions, "
+              << toMB(openSessionMemory.hugePageBytes) << " on huge pages (" << modeNames[(int)openSessionMemory.mode] << ")\n"
+              << "After destroy: " << toMB(closedSessionMemory.freeListBytes) << " on the free lists for the next session\n";
+}
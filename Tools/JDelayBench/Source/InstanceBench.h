@@ -0,0 +1,61 @@
+// InstanceBench.h
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "../../../Source/DSP/DelayMemoryArena.h"
+
+/**
+Session-load benchmark: creates N instances of the plugin in one process and walks all of them
+through each phase of opening a project before moving to the next phase, as a host does:
+
+- construct (createPluginFilter: parameter layout and APVTS)
+- prepareToPlay
+- setStateInformation with a saved session state
+- first processBlock
+- open and close the editor (optional: needs a display)
+- destroy
+
+Each phase reports its wall time (total, average and slowest instance), the heap allocations made
+during the phase and the peak resident set size of the process after it. The DelayMemoryArena's usage
+of the open session (buffers, regions, huge pages) closes the report.
+*/
+class InstanceBench
+{
+public:
+    struct Options
+    {
+        int numInstances = 100;
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+        bool withEditor = false;
+        juce::int64 seed = 1;
+    };
+
+    explicit InstanceBench(const Options& options);
+
+    /** run all phases and print the report; returns false if the plugin could not be created */
+    bool run();
+
+private:
+    struct PhaseResult
+    {
+        juce::String name;
+        double total_ms = 0.0;
+        double slowest_us = 0.0;
+        juce::uint64 allocations = 0;
+        juce::uint64 peakResident_kB = 0;
+    };
+
+    /** times perInstance(i) for every instance, counting allocations on this thread */
+    template <typename Function>
+    void runPhase(const juce::String& name, Function&& perInstance);
+
+    juce::MemoryBlock createSessionState();
+    void report();
+
+    Options options;
+    juce::Array<PhaseResult> results;
+    DelayMemoryStatistics openSessionMemory;
+};
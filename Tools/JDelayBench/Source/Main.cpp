@@ -0,0 +1,106 @@
+// Main.cpp
+
+#include <JuceHeader.h>
+
+#include "BankBench.h"
+#include "InstanceBench.h"
+#include "RenderQualityBench.h"
+#include "StressTest.h"
+
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "Usage: JDelayBench --stress [options]\n"
+                     "       JDelayBench --instances=<n> [options]\n"
+                     "       JDelayBench --render-quality [options]\n"
+                     "       JDelayBench --bank [options]\n"
+                     "\n"
+                     "  --stress            drive the plugin with hostile automation and report block time\n"
+                     "                      percentiles and every allocation or lock on the audio thread\n"
+                     "  --instances=<n>     open a session of n instances and report the time, allocations\n"
+                     "                      and peak memory of each phase\n"
+                     "  --render-quality    compare the cost of a realtime and an offline (render quality) bounce\n"
+                     "  --bank              compare the throughput of AudioDelayBank and separate AudioDelays\n"
+                     "\n"
+                     "Stress options:\n"
+                     "  --phases=<n>        prepareToPlay cycles, each with a new rate, block size and layout (default: 20)\n"
+                     "  --blocks=<n>        blocks per phase (default: 2000)\n"
+                     "  --max-block=<n>     largest block size announced to prepareToPlay (default: 2048)\n"
+                     "\n"
+                     "Instance, render quality and bank options:\n"
+                     "  --rate=<Hz>         sample rate (default: 48000)\n"
+                     "  --block=<n>         block size (default: 512)\n"
+                     "  --editor            also open and close every editor (needs a display)\n"
+                     "  --seconds=<n>       length of the rendered signal (default: 20)\n"
+                     "\n"
+                     "  --seed=<n>          random seed, to reproduce a run (default: 1)\n";
+    }
+
+    int getIntOption(const juce::ArgumentList& args, const juce::String& option, int defaultValue)
+    {
+        return args.containsOption(option) ? juce::jmax(1, args.getValueForOption(option).getIntValue()) : defaultValue;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ArgumentList args(argc, argv);
+
+    if (args.size() == 0 || args.containsOption("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    // --- the processor's parameter state needs a message thread: this one
+    juce::ScopedJuceInitialiser_GUI libraryInitialiser;
+
+    auto seed = args.containsOption("--seed") ? args.getValueForOption("--seed").getLargeIntValue() : (juce::int64)1;
+
+    if (args.containsOption("--stress"))
+    {
+        StressTest::Options options;
+        options.numPhases = getIntOption(args, "--phases", options.numPhases);
+        options.blocksPerPhase = getIntOption(args, "--blocks", options.blocksPerPhase);
+        options.maxBlockSize = getIntOption(args, "--max-block", options.maxBlockSize);
+        options.seed = seed;
+
+        return StressTest(options).run() ? 0 : 1;
+    }
+
+    if (args.containsOption("--instances"))
+    {
+        InstanceBench::Options options;
+        options.numInstances = getIntOption(args, "--instances", options.numInstances);
+        options.sampleRate = (double)getIntOption(args, "--rate", (int)options.sampleRate);
+        options.blockSize = getIntOption(args, "--block", options.blockSize);
+        options.withEditor = args.containsOption("--editor");
+        options.seed = seed;
+
+        return InstanceBench(options).run() ? 0 : 1;
+    }
+
+    if (args.containsOption("--render-quality"))
+    {
+        RenderQualityBench::Options options;
+        options.seconds = (double)getIntOption(args, "--seconds", (int)options.seconds);
+        options.sampleRate = (double)getIntOption(args, "--rate", (int)options.sampleRate);
+        options.blockSize = getIntOption(args, "--block", options.blockSize);
+
+        return RenderQualityBench(options).run() ? 0 : 1;
+    }
+
+    if (args.containsOption("--bank"))
+    {
+        BankBench::Options options;
+        options.seconds = (double)getIntOption(args, "--seconds", (int)options.seconds);
+        options.sampleRate = (double)getIntOption(args, "--rate", (int)options.sampleRate);
+        options.blockSize = getIntOption(args, "--block", options.blockSize);
+
+        return BankBench(options).run() ? 0 : 1;
+    }
+
+    printUsage();
+    return 1;
+}
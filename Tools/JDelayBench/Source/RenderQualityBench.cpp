@@ -0,0 +1,111 @@
+// RenderQualityBench.cpp
+
+#include "RenderQualityBench.h"
+
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter();
+
+namespace
+{
+    juce::RangedAudioParameter* findParameter(juce::AudioProcessor& processor, const juce::String& parameterID)
+    {
+        for (auto* parameter : processor.getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+                if (ranged->getParameterID() == parameterID)
+                    return ranged;
+
+        return nullptr;
+    }
+}
+
+RenderQualityBench::RenderQualityBench(const Options& o) : options(o)
+{
+    signal.setSize(2, (int)(options.seconds * options.sampleRate));
+
+    juce::Random random(1);
+    for (int ch = 0; ch < signal.getNumChannels(); ++ch)
+        for (int i = 0; i < signal.getNumSamples(); ++i)
+            signal.setSample(ch, i, random.nextFloat() - 0.5f);
+}
+
+double RenderQualityBench::render(bool nonRealtime, int delayType, bool sweepDelayTime)
+{
+    std::unique_ptr<juce::AudioProcessor> processor(createPluginFilter());
+
+    auto* delayTypeParameter = findParameter(*processor, "DELAYTYPE");
+    auto* delayTimeParameter = findParameter(*processor, "DELAYTIME");
+    auto* feedbackParameter = findParameter(*processor, "FEEDBACK");
+
+    if (delayTypeParameter == nullptr || delayTimeParameter == nullptr || feedbackParameter == nullptr)
+        return 0.0;
+
+    delayTypeParameter->setValueNotifyingHost(delayTypeParameter->convertTo0to1((float)delayType));
+    delayTimeParameter->setValueNotifyingHost(delayTimeParameter->convertTo0to1(333.3f));
+    feedbackParameter->setValueNotifyingHost(feedbackParameter->convertTo0to1(60.0f));
+
+    processor->setNonRealtime(nonRealtime);
+    processor->setRateAndBufferSizeDetails(options.sampleRate, options.blockSize);
+    processor->prepareToPlay(options.sampleRate, options.blockSize);
+
+    juce::AudioBuffer<float> buffer(2, options.blockSize);
+    juce::MidiBuffer midi;
+    double seconds = 0.0;
+
+    for (int start = 0, block = 0; start < signal.getNumSamples(); start += options.blockSize, ++block)
+    {
+        auto numSamples = juce::jmin(options.blockSize, signal.getNumSamples() - start);
+        buffer.setSize(2, numSamples, false, false, true);
+        for (int ch = 0; ch < 2; ++ch)
+            buffer.copyFrom(ch, 0, signal, ch, start, numSamples);
+
+        // --- a slow back-and-forth sweep keeps the smoothed delay time moving: fractional reads on every sample
+        if (sweepDelayTime)
+            delayTimeParameter->setValueNotifyingHost(delayTimeParameter->convertTo0to1(
+                (float)(300.0 + 50.0 * std::sin(block * 0.05))));
+
+        auto startTicks = juce::Time::getHighResolutionTicks();
+        processor->processBlock(buffer, midi);
+        seconds += juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    }
+
+    processor->releaseResources();
+    return seconds;
+}
+
+bool RenderQualityBench::run()
+{
+    std::cout << "Rendering " << options.seconds << " s of stereo noise at " << options.sampleRate << " Hz, "
+              << options.blockSize << " samples per block\n\n";
+
+    std::cout << juce::String("Case").paddedRight(' ', 28)
+              << juce::String("realtime x").paddedLeft(' ', 14)
+              << juce::String("render x").paddedLeft(' ', 14)
+              << juce::String("extra cost").paddedLeft(' ', 14) << "\n";
+
+    const struct { const char* name; int delayType; } delayTypes[] = { { "Normal", 0 }, { "PingPong", 1 } };
+
+    for (auto& type : delayTypes)
+    {
+        for (bool sweep : { false, true })
+        {
+            // --- warm up once so both measurements start with hot caches
+            render(false, type.delayType, sweep);
+
+            auto realtimeSeconds = render(false, type.delayType, sweep);
+            auto renderSeconds = render(true, type.delayType, sweep);
+
+            if (realtimeSeconds <= 0.0 || renderSeconds <= 0.0)
+            {
+                std::cerr << "The plugin's parameters were not found" << std::endl;
+                return false;
+            }
+
+            auto name = juce::String(type.name) + (sweep ? ", swept delay" : ", static delay");
+            std::cout << name.paddedRight(' ', 28)
+                      << juce::String(options.seconds / realtimeSeconds, 1).paddedLeft(' ', 14)
+                      << juce::String(options.seconds / renderSeconds, 1).paddedLeft(' ', 14)
+                      << (juce::String(100.0 * (renderSeconds / realtimeSeconds - 1.0), 1) + "%").paddedLeft(' ', 14) << "\n";
+        }
+    }
+
+    return true;
+}
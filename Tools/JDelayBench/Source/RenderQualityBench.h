@@ -0,0 +1,34 @@
+// RenderQualityBench.h
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+Cost of the render quality profile: renders the same audio through the plugin once as a realtime
+host would and once flagged non-realtime (setNonRealtime), for the delay types that use it, with
+the delay time held still and with it swept every block, and reports the realtime factor of each
+and the extra cost of render quality.
+*/
+class RenderQualityBench
+{
+public:
+    struct Options
+    {
+        double seconds = 20.0;
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+    };
+
+    explicit RenderQualityBench(const Options& options);
+
+    /** run every case and print the report */
+    bool run();
+
+private:
+    /** seconds of processing for the whole signal */
+    double render(bool nonRealtime, int delayType, bool sweepDelayTime);
+
+    Options options;
+    juce::AudioBuffer<float> signal;
+};
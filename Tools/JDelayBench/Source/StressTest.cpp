@@ -0,0 +1,409 @@
+// StressTest.cpp
+
+#include "StressTest.h"
+
+#include "AudioThreadGuard.h"
+#include "../../../Source/Stats/StatsPublisher.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter();
+
+namespace
+{
+    const double sampleRates[] = { 44100.0, 48000.0, 88200.0, 96000.0, 192000.0 };
+
+    enum class Automation { kRandomJump, kMinMaxToggle, kSweep, kHold };
+
+    enum class Signal { kNoise, kSilence, kSquare, kDenormal };
+
+    /** the stats scan runs inside processBlock(), with FTZ/DAZ set: it must still see a denormal among
+        zeros and normals, a NaN and an infinity, and nothing in a clean buffer */
+    bool checkStatsScan()
+    {
+        juce::ScopedNoDenormals noDenormals;
+
+        auto scan = [](const float* samples, int numSamples, bool expectDenormal, bool expectNonFinite)
+        {
+            bool denormal = false, nonFinite = false;
+            StatsPublisher::scanSamples(samples, numSamples, denormal, nonFinite);
+            return denormal == expectDenormal && nonFinite == expectNonFinite;
+        };
+
+        float samples[64] = {};
+        samples[10] = 0.5f;
+        samples[11] = -std::numeric_limits<float>::max();
+        samples[12] = std::numeric_limits<float>::min();
+        bool passed = scan(samples, 64, false, false);
+
+        // --- the smallest denormal, stored as bits: any arithmetic would flush it
+        const uint32_t smallestDenormal = 0x80000001u;
+        std::memcpy(&samples[37], &smallestDenormal, sizeof(float));
+        passed = passed && scan(samples, 64, true, false);
+
+        samples[37] = 0.0f;
+        samples[50] = std::numeric_limits<float>::quiet_NaN();
+        passed = passed && scan(samples, 64, false, true);
+
+        samples[50] = std::numeric_limits<float>::infinity();
+        passed = passed && scan(samples, 64, false, true);
+
+        return passed;
+    }
+
+    double percentile(const std::vector<double>& sorted, double fraction)
+    {
+        if (sorted.empty())
+            return 0.0;
+
+        auto index = (size_t)std::ceil(fraction * (double)sorted.size());
+        return sorted[juce::jlimit((size_t)0, sorted.size() - 1, index > 0 ? index - 1 : 0)];
+    }
+
+    void fillInput(juce::AudioBuffer<float>& buffer, int numChannels, int numSamples, Signal signal, juce::Random& random, int& squarePhase)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* samples = buffer.getWritePointer(ch);
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                switch (signal)
+                {
+                    case Signal::kNoise:	samples[i] = random.nextFloat() * 2.0f - 1.0f; break;
+                    case Signal::kSilence:	samples[i] = 0.0f; break;
+                    case Signal::kSquare:	samples[i] = ((squarePhase + i) / 64) % 2 == 0 ? 1.0f : -1.0f; break;
+                    case Signal::kDenormal:	samples[i] = (i % 2 == 0 ? 1.0f : -1.0f) * 1.0e-40f; break;
+                }
+            }
+        }
+
+        squarePhase += numSamples;
+    }
+
+    bool hasNonFiniteSample(const juce::AudioBuffer<float>& buffer, int numChannels, int numSamples)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* samples = buffer.getReadPointer(ch);
+
+            for (int i = 0; i < numSamples; ++i)
+                if (! std::isfinite(samples[i]))
+                    return true;
+        }
+
+        return false;
+    }
+}
+
+StressTest::StressTest(const Options& o) : options(o)
+{
+}
+
+StressTest::Phase StressTest::createPhase(juce::Random& random, juce::AudioProcessor& processor)
+{
+    Phase phase;
+    phase.sampleRate = sampleRates[random.nextInt((int)std::size(sampleRates))];
+    phase.maxBlockSize = random.nextInt({ juce::jmin(16, options.maxBlockSize), options.maxBlockSize + 1 });
+
+    // --- mono, stereo, or stereo with the sidechain connected
+    auto channelSet = juce::AudioChannelSet::stereo();
+    phase.layout = processor.getBusesLayout();
+    phase.layoutName = "stereo";
+
+    switch (random.nextInt(3))
+    {
+        case 0:
+            channelSet = juce::AudioChannelSet::mono();
+            phase.layoutName = "mono";
+            break;
+
+        case 2:
+            if (phase.layout.inputBuses.size() > 1)
+            {
+                phase.layout.inputBuses.getReference(1) = juce::AudioChannelSet::stereo();
+                phase.layoutName = "stereo+sidechain";
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    phase.layout.inputBuses.getReference(0) = channelSet;
+    phase.layout.outputBuses.getReference(0) = channelSet;
+
+    if (phase.layout.inputBuses.size() > 1 && phase.layoutName != "stereo+sidechain")
+        phase.layout.inputBuses.getReference(1) = juce::AudioChannelSet::disabled();
+
+    return phase;
+}
+
+bool StressTest::run()
+{
+    if (! checkStatsScan())
+    {
+        std::cout << "FAILED: the stats scan misses denormal or non-finite samples with FTZ/DAZ set" << std::endl;
+        return false;
+    }
+
+    std::unique_ptr<juce::AudioProcessor> processor(createPluginFilter());
+
+    for (auto* parameter : processor->getParameters())
+        parameters.push_back(parameter);
+
+    records.clear();
+    records.reserve((size_t)(options.numPhases * options.blocksPerPhase));
+
+    juce::Random random(options.seed);
+    std::vector<juce::MemoryBlock> savedStates;
+    int numStateRestores = 0;
+
+    for (int phaseIndex = 0; phaseIndex < options.numPhases; ++phaseIndex)
+    {
+        auto phase = createPhase(random, *processor);
+
+        // --- the host reconfigures on the message thread, with the audio thread stopped
+        processor->releaseResources();
+        processor->setBusesLayout(phase.layout);
+        processor->setRateAndBufferSizeDetails(phase.sampleRate, phase.maxBlockSize);
+        processor->prepareToPlay(phase.sampleRate, phase.maxBlockSize);
+
+        std::cout << "Phase " << (phaseIndex + 1) << "/" << options.numPhases << ": "
+                  << phase.sampleRate << " Hz, up to " << phase.maxBlockSize << " samples, "
+                  << phase.layoutName << std::endl;
+
+        std::atomic<bool> audioThreadDone { false };
+        auto audioSeed = random.nextInt64();
+
+        std::thread audioThread([&]
+        {
+            runAudioThread(*processor, phase, phaseIndex, audioSeed);
+            audioThreadDone.store(true);
+        });
+
+        // --- meanwhile the message thread keeps the UI timers running and restores sessions
+        while (! audioThreadDone.load())
+        {
+            juce::MessageManager::getInstance()->runDispatchLoopUntil(random.nextInt({ 1, 20 }));
+
+            if (random.nextInt(4) == 0)
+            {
+                juce::MemoryBlock state;
+                processor->getStateInformation(state);
+
+                if (savedStates.size() < 16)
+                    savedStates.push_back(state);
+                else
+                    savedStates[(size_t)random.nextInt((int)savedStates.size())] = state;
+            }
+            else if (! savedStates.empty())
+            {
+                auto& state = savedStates[(size_t)random.nextInt((int)savedStates.size())];
+                processor->setStateInformation(state.getData(), (int)state.getSize());
+                ++numStateRestores;
+            }
+        }
+
+        audioThread.join();
+    }
+
+    processor->releaseResources();
+    report(numStateRestores);
+
+    for (const auto& record : records)
+        if (record.allocations > 0 || record.locks > 0 || record.nonFinite)
+            return false;
+
+    return true;
+}
+
+void StressTest::runAudioThread(juce::AudioProcessor& processor, const Phase& phase, int phaseIndex, juce::int64 seed)
+{
+    juce::Random random(seed);
+
+    auto numInputChannels = processor.getTotalNumInputChannels();
+    auto numOutputChannels = processor.getMainBusNumOutputChannels();
+    auto longestBlock = phase.maxBlockSize * 3;
+
+    // --- everything the loop needs is allocated here, outside the guarded region
+    juce::AudioBuffer<float> buffer(juce::jmax(numInputChannels, numOutputChannels), longestBlock);
+    juce::MidiBuffer midi;
+
+    std::vector<Automation> automation(parameters.size());
+    std::vector<float> sweepPosition(parameters.size()), sweepIncrement(parameters.size());
+
+    for (size_t p = 0; p < parameters.size(); ++p)
+    {
+        automation[p] = (Automation)random.nextInt(4);
+        sweepPosition[p] = random.nextFloat();
+        sweepIncrement[p] = 0.001f + random.nextFloat() * 0.2f;
+    }
+
+    auto signal = Signal::kNoise;
+    int squarePhase = 0;
+
+    for (int block = 0; block < options.blocksPerPhase; ++block)
+    {
+        // --- block size: mostly within the announced maximum, sometimes a single sample or more than announced
+        int numSamples;
+        switch (random.nextInt(20))
+        {
+            case 0:		numSamples = 1; break;
+            case 1:		numSamples = random.nextInt({ phase.maxBlockSize + 1, longestBlock + 1 }); break;
+            case 2:		numSamples = phase.maxBlockSize; break;
+            default:	numSamples = random.nextInt({ 1, phase.maxBlockSize + 1 }); break;
+        }
+
+        if (random.nextInt(50) == 0)
+            signal = (Signal)random.nextInt(4);
+
+        fillInput(buffer, buffer.getNumChannels(), numSamples, signal, random, squarePhase);
+
+        // --- host automation lands between blocks, the way wrappers deliver it
+        for (size_t p = 0; p < parameters.size(); ++p)
+        {
+            if (random.nextInt(200) == 0)
+                automation[p] = (Automation)random.nextInt(4);
+
+            float value;
+            switch (automation[p])
+            {
+                case Automation::kRandomJump:	value = random.nextFloat(); break;
+                case Automation::kMinMaxToggle:	value = block % 2 == 0 ? 0.0f : 1.0f; break;
+                case Automation::kSweep:
+                    sweepPosition[p] += sweepIncrement[p];
+                    if (sweepPosition[p] > 1.0f)
+                        sweepPosition[p] -= 1.0f;
+                    value = sweepPosition[p];
+                    break;
+                default:						continue;
+            }
+
+            parameters[p]->setValueNotifyingHost(value);
+        }
+
+        juce::AudioBuffer<float> blockBuffer(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), numSamples);
+
+        BlockRecord record;
+        auto countsBefore = AudioThreadGuard::getCounts();
+        auto startTicks = juce::Time::getHighResolutionTicks();
+        {
+            AudioThreadGuard::ScopedAudioThread audioThread;
+            processor.processBlock(blockBuffer, midi);
+        }
+        auto elapsedTicks = juce::Time::getHighResolutionTicks() - startTicks;
+        auto countsAfter = AudioThreadGuard::getCounts();
+
+        record.time_us = juce::Time::highResolutionTicksToSeconds(elapsedTicks) * 1.0e6;
+        record.duration_us = numSamples * 1.0e6 / phase.sampleRate;
+        record.phase = phaseIndex;
+        record.numSamples = numSamples;
+        record.sampleRate = phase.sampleRate;
+        record.firstAfterPrepare = block == 0;
+        record.allocations = countsAfter.allocations - countsBefore.allocations;
+        record.locks = countsAfter.locks - countsBefore.locks;
+        record.nonFinite = hasNonFiniteSample(buffer, numOutputChannels, numSamples);
+
+        // --- reserved for every block in run(): never reallocates here
+        records.push_back(record);
+    }
+}
+
+void StressTest::report(int numStateRestores)
+{
+    std::vector<double> times, loads;
+    times.reserve(records.size());
+    loads.reserve(records.size());
+
+    for (const auto& record : records)
+    {
+        times.push_back(record.time_us);
+        loads.push_back(100.0 * record.time_us / record.duration_us);
+    }
+
+    std::sort(times.begin(), times.end());
+    std::sort(loads.begin(), loads.end());
+
+    std::cout << "\n" << records.size() << " blocks in " << options.numPhases << " phases, "
+              << numStateRestores << " state restores, seed " << options.seed << "\n\n";
+
+    auto printRow = [](const char* name, const std::vector<double>& sorted)
+    {
+        std::cout << juce::String(name).paddedRight(' ', 22)
+                  << "p50 " << juce::String(percentile(sorted, 0.5), 2).paddedLeft(' ', 10)
+                  << "   p99 " << juce::String(percentile(sorted, 0.99), 2).paddedLeft(' ', 10)
+                  << "   p99.9 " << juce::String(percentile(sorted, 0.999), 2).paddedLeft(' ', 10)
+                  << "   max " << juce::String(sorted.empty() ? 0.0 : sorted.back(), 2).paddedLeft(' ', 10) << "\n";
+    };
+
+    printRow("Block time (us)", times);
+    printRow("Load (% of block)", loads);
+
+    // --- histogram in powers of two microseconds
+    std::cout << "\nBlock time histogram:\n";
+    int histogram[24] = {};
+
+    for (auto time : times)
+        ++histogram[juce::jlimit(0, 23, (int)std::floor(std::log2(juce::jmax(1.0, time))) + 1)];
+
+    for (int bucket = 0; bucket < 24; ++bucket)
+    {
+        if (histogram[bucket] == 0)
+            continue;
+
+        auto label = bucket == 0 ? juce::String("< 1 us")
+                                 : juce::String(1 << (bucket - 1)) + " - " + juce::String(1 << bucket) + " us";
+
+        std::cout << "  " << label.paddedRight(' ', 20) << juce::String(histogram[bucket]).paddedLeft(' ', 8) << "  "
+                  << juce::String::repeatedString("#", juce::jmax(1, (int)(50.0 * histogram[bucket] / (double)times.size()))) << "\n";
+    }
+
+    // --- the worst blocks with enough context to reproduce them
+    std::vector<const BlockRecord*> worst;
+    for (const auto& record : records)
+        worst.push_back(&record);
+
+    auto numWorst = juce::jmin((size_t)5, worst.size());
+    std::partial_sort(worst.begin(), worst.begin() + (std::ptrdiff_t)numWorst, worst.end(),
+                      [](auto* a, auto* b) { return a->time_us / a->duration_us > b->time_us / b->duration_us; });
+
+    std::cout << "\nHighest load blocks:\n";
+    for (size_t i = 0; i < numWorst; ++i)
+    {
+        auto* r = worst[i];
+        std::cout << "  phase " << (r->phase + 1) << ", " << r->numSamples << " samples at " << r->sampleRate << " Hz: "
+                  << juce::String(r->time_us, 1) << " us (" << juce::String(100.0 * r->time_us / r->duration_us, 1) << "%)"
+                  << (r->firstAfterPrepare ? ", first block after prepareToPlay" : "") << "\n";
+    }
+
+    // --- realtime rule violations
+    size_t allocationBlocks = 0, lockBlocks = 0, nonFiniteBlocks = 0, numListed = 0;
+
+    std::cout << "\nAudio thread violations:\n";
+    for (const auto& r : records)
+    {
+        if (r.allocations == 0 && r.locks == 0 && ! r.nonFinite)
+            continue;
+
+        allocationBlocks += r.allocations > 0 ? 1 : 0;
+        lockBlocks += r.locks > 0 ? 1 : 0;
+        nonFiniteBlocks += r.nonFinite ? 1 : 0;
+
+        if (numListed++ < 20)
+            std::cout << "  phase " << (r.phase + 1) << ", " << r.numSamples << " samples: "
+                      << r.allocations << " allocations, " << r.locks << " locks"
+                      << (r.nonFinite ? ", NaN/Inf output" : "")
+                      << (r.firstAfterPrepare ? " (first block after prepareToPlay)" : "") << "\n";
+    }
+
+    std::cout << "  " << allocationBlocks << " blocks allocated, "
+              << lockBlocks << " blocks took a lock" << (AudioThreadGuard::detectsLocks() ? "" : " (not detected on this platform)") << ", "
+              << nonFiniteBlocks << " blocks produced NaN/Inf\n";
+
+    std::cout << (allocationBlocks + lockBlocks + nonFiniteBlocks == 0 ? "\nPASS\n" : "\nFAIL\n");
+}
@@ -0,0 +1,73 @@
+// StressTest.h
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+Worst-case execution time and jitter stress test for JDelayAudioProcessor, driven through the
+juce::AudioProcessor interface the way a plugin wrapper drives it.
+
+Every phase picks a sample rate, a maximum block size and a bus layout (mono, stereo, stereo with
+sidechain), prepares the processor and runs an audio thread that:
+
+- sends randomized block sizes, including single samples and blocks larger than announced
+- moves every parameter every block: random jumps, min/max toggles and fast sweeps, so the
+  delay type, band counts and crossovers change constantly
+- feeds noise, silence, full-scale square waves and denormal input
+
+Meanwhile the main thread acts as the message thread: it runs the message loop and restores
+earlier states through setStateInformation() at random moments.
+
+Only processBlock() is timed and guarded. The report has percentiles and a histogram of the
+block times, the worst blocks with their context, and every block that allocated, took a lock
+(Linux) or produced a NaN or infinite sample; any of those fails the run. Before the first phase,
+the stats scan (StatsPublisher::scanSamples()) must find denormal and non-finite samples with
+FTZ/DAZ set, as in processBlock().
+*/
+class StressTest
+{
+public:
+    struct Options
+    {
+        int numPhases = 20;
+        int blocksPerPhase = 2000;
+        int maxBlockSize = 2048;
+        juce::int64 seed = 1;
+    };
+
+    explicit StressTest(const Options& options);
+
+    /** run all phases and print the report; returns false if any block violated the realtime rules */
+    bool run();
+
+private:
+    struct BlockRecord
+    {
+        double time_us;
+        double duration_us;		// audio duration of the block: the deadline
+        int phase;
+        int numSamples;
+        double sampleRate;
+        bool firstAfterPrepare;
+        juce::uint64 allocations;
+        juce::uint64 locks;
+        bool nonFinite;
+    };
+
+    struct Phase
+    {
+        double sampleRate;
+        int maxBlockSize;
+        juce::AudioProcessor::BusesLayout layout;
+        juce::String layoutName;
+    };
+
+    Phase createPhase(juce::Random& random, juce::AudioProcessor& processor);
+    void runAudioThread(juce::AudioProcessor& processor, const Phase& phase, int phaseIndex, juce::int64 seed);
+    void report(int numStateRestores);
+
+    Options options;
+    std::vector<BlockRecord> records;
+    std::vector<juce::AudioProcessorParameter*> parameters;
+};
@@ -0,0 +1,398 @@
+// JDelayCore.cpp
+
+#include "JDelayCore.h"
+
+#include <cstring>
+#include <memory>
+#include <new>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+ #include <xmmintrin.h>
+ #define JDELAY_HAS_MXCSR 1
+#else
+ #define JDELAY_HAS_MXCSR 0
+#endif
+
+#include "../../../Source/DSP/AudioDelay.h"
+#include "../../../Source/DSP/AudioDelayBank.h"
+#include "../../../Source/DSP/DelayMemoryArena.h"
+
+struct jdelay_instance
+{
+    AudioDelay delay;
+    AudioDelayParameters parameters;
+    double sampleRate = 0.0;
+    bool prepared = false;
+};
+
+struct jdelay_bank
+{
+    // --- exactly one of them, by lane count
+    std::unique_ptr<AudioDelayBank<4>> bank4;
+    std::unique_ptr<AudioDelayBank<8>> bank8;
+    std::unique_ptr<AudioDelayBank<16>> bank16;
+    uint32_t numLanes = 0;
+    bool prepared = false;
+};
+
+namespace
+{
+    /** flush denormals to zero while processing, like juce::ScopedNoDenormals in the plugin:
+        feedback tails decaying into the denormal range are very slow on x86 otherwise */
+    struct ScopedNoDenormals
+    {
+#if JDELAY_HAS_MXCSR
+        ScopedNoDenormals() : previous(_mm_getcsr()) { _mm_setcsr(previous | 0x8040); }	// FTZ | DAZ
+        ~ScopedNoDenormals() { _mm_setcsr(previous); }
+
+        unsigned int previous;
+#endif
+    };
+
+    AudioDelayParameters toAudioDelayParameters(const jdelay_parameters& p)
+    {
+        AudioDelayParameters params;
+
+        int32_t algorithm = p.algorithm;
+        if (algorithm < JDELAY_ALGORITHM_NORMAL || algorithm > JDELAY_ALGORITHM_BBD)
+            algorithm = JDELAY_ALGORITHM_NORMAL;
+
+        params.algorithm = convertIntToEnum(algorithm, delayAlgorithm);
+        params.wetLevel_dB = p.wet_level_db;
+        params.dryLevel_dB = p.dry_level_db;
+        params.feedback_Pct = p.feedback_pct;
+
+        params.updateType = p.use_delay_ratio ? delayUpdateType::kLeftPlusRatio : delayUpdateType::kLeftAndRight;
+        params.leftDelay_mSec = p.left_delay_ms;
+        params.rightDelay_mSec = p.right_delay_ms;
+        params.delayRatio_Pct = p.delay_ratio_pct;
+
+        params.fdnDamping_Pct = p.fdn_damping_pct;
+
+        params.duckThreshold_dB = p.duck_threshold_db;
+        params.duckDepth_dB = p.duck_depth_db;
+        params.duckAttack_mSec = p.duck_attack_ms;
+        params.duckRelease_mSec = p.duck_release_ms;
+
+        params.pitchShift_Semitones = p.pitch_shift_semitones;
+
+        params.freeze = p.freeze != 0;
+
+        params.crossFeedback_Pct = p.cross_feedback_pct;
+
+        params.multibandNumBands = p.multiband_num_bands;
+        for (int i = 0; i < 3; i++)
+            params.multibandCrossover_Hz[i] = p.multiband_crossover_hz[i];
+        for (int i = 0; i < 4; i++)
+        {
+            params.multibandDelay_Pct[i] = p.multiband_delay_pct[i];
+            params.multibandFeedback_Pct[i] = p.multiband_feedback_pct[i];
+            params.multibandLevel_dB[i] = p.multiband_level_db[i];
+        }
+
+        return params;
+    }
+
+    /** call function with the bank's AudioDelayBank, whatever its lane count */
+    template <typename Function>
+    int32_t withBank(jdelay_bank* bank, Function&& function)
+    {
+        if (bank->bank4) return function(*bank->bank4);
+        if (bank->bank8) return function(*bank->bank8);
+        return function(*bank->bank16);
+    }
+
+    /** a caller built against an older header passes a shorter struct: missing fields keep their defaults */
+    jdelay_parameters completeParameters(const jdelay_parameters* parameters)
+    {
+        jdelay_parameters p;
+        jdelay_parameters_init(&p);
+        std::memcpy(&p, parameters, parameters->struct_size < sizeof(p) ? parameters->struct_size : sizeof(p));
+        return p;
+    }
+
+    int32_t processBlock(jdelay_instance* instance,
+                         const float* const* inputs, uint32_t numInputChannels,
+                         float* const* outputs, uint32_t numOutputChannels,
+                         const float* const* sidechain, uint32_t numSidechainChannels,
+                         bool keyFromSidechain, uint32_t numSamples)
+    {
+        if (instance == nullptr || inputs == nullptr || outputs == nullptr)
+            return JDELAY_ERROR_INVALID_ARGUMENT;
+
+        if (!instance->prepared)
+            return JDELAY_ERROR_NOT_PREPARED;
+
+        if (numSamples == 0)
+            return JDELAY_OK;
+
+        ScopedNoDenormals noDenormals;
+
+        instance->delay.enableAuxInput(keyFromSidechain);
+
+        if (!instance->delay.processAudioBlock(inputs, outputs, numInputChannels, numOutputChannels, numSamples,
+                                               nullptr, sidechain, sidechain != nullptr ? numSidechainChannels : 0))
+            return JDELAY_ERROR_INVALID_ARGUMENT;
+
+        return JDELAY_OK;
+    }
+}
+
+extern "C"
+{
+
+int32_t jdelay_get_api_version(void)
+{
+    return JDELAY_API_VERSION;
+}
+
+void jdelay_parameters_init(jdelay_parameters* parameters)
+{
+    if (parameters == nullptr)
+        return;
+
+    std::memset(parameters, 0, sizeof(jdelay_parameters));
+    parameters->struct_size = (uint32_t)sizeof(jdelay_parameters);
+
+    // --- same defaults as the plugin's parameter layout
+    parameters->algorithm = JDELAY_ALGORITHM_NORMAL;
+    parameters->wet_level_db = -3.0;
+    parameters->dry_level_db = -3.0;
+    parameters->feedback_pct = 50.0;
+
+    parameters->left_delay_ms = 250.0;
+    parameters->right_delay_ms = 125.0;
+    parameters->use_delay_ratio = 1;
+    parameters->delay_ratio_pct = 50.0;
+
+    parameters->fdn_damping_pct = 30.0;
+
+    parameters->duck_threshold_db = -30.0;
+    parameters->duck_depth_db = 0.0;
+    parameters->duck_attack_ms = 10.0;
+    parameters->duck_release_ms = 250.0;
+
+    parameters->pitch_shift_semitones = 0.0;
+
+    parameters->interpolate = 1;
+
+    // --- the defaults of AudioDelayParameters, same as the plugin's
+    AudioDelayParameters defaults;
+    parameters->multiband_num_bands = defaults.multibandNumBands;
+    for (int i = 0; i < 3; i++)
+        parameters->multiband_crossover_hz[i] = defaults.multibandCrossover_Hz[i];
+    for (int i = 0; i < 4; i++)
+    {
+        parameters->multiband_delay_pct[i] = defaults.multibandDelay_Pct[i];
+        parameters->multiband_feedback_pct[i] = defaults.multibandFeedback_Pct[i];
+        parameters->multiband_level_db[i] = defaults.multibandLevel_dB[i];
+    }
+
+    parameters->render_quality = 0;
+    parameters->freeze = 0;
+    parameters->cross_feedback_pct = 0.0;
+}
+
+jdelay_instance* jdelay_create(void)
+{
+    return new (std::nothrow) jdelay_instance();
+}
+
+void jdelay_destroy(jdelay_instance* instance)
+{
+    delete instance;
+}
+
+int32_t jdelay_prepare(jdelay_instance* instance, double sample_rate, double max_delay_ms)
+{
+    if (instance == nullptr || !(sample_rate > 0.0) || !(max_delay_ms > 0.0))
+        return JDELAY_ERROR_INVALID_ARGUMENT;
+
+    instance->prepared = false;
+
+    try
+    {
+        instance->delay.createDelayBuffers(sample_rate, max_delay_ms);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return JDELAY_ERROR_OUT_OF_MEMORY;
+    }
+
+    // --- the delay in samples depends on the sample rate: apply the parameters again
+    instance->delay.setParameters(instance->parameters);
+    instance->sampleRate = sample_rate;
+    instance->prepared = true;
+
+    return JDELAY_OK;
+}
+
+int32_t jdelay_reset(jdelay_instance* instance)
+{
+    if (instance == nullptr)
+        return JDELAY_ERROR_INVALID_ARGUMENT;
+
+    if (!instance->prepared)
+        return JDELAY_ERROR_NOT_PREPARED;
+
+    // --- same sample rate: flushes the lines without reallocating
+    instance->delay.reset(instance->sampleRate);
+    return JDELAY_OK;
+}
+
+int32_t jdelay_set_parameters(jdelay_instance* instance, const jdelay_parameters* parameters)
+{
+    if (instance == nullptr || parameters == nullptr || parameters->struct_size == 0)
+        return JDELAY_ERROR_INVALID_ARGUMENT;
+
+    jdelay_parameters p = completeParameters(parameters);
+
+    instance->parameters = toAudioDelayParameters(p);
+    instance->delay.setInterpolate(p.interpolate != 0);
+    instance->delay.setRenderQuality(p.render_quality != 0);
+
+    if (instance->prepared)
+        instance->delay.setParameters(instance->parameters);
+
+    return JDELAY_OK;
+}
+
+int32_t jdelay_process_block(jdelay_instance* instance,
+                             const float* const* inputs, uint32_t num_input_channels,
+                             float* const* outputs, uint32_t num_output_channels,
+                             uint32_t num_samples)
+{
+    return processBlock(instance, inputs, num_input_channels, outputs, num_output_channels,
+                        nullptr, 0, false, num_samples);
+}
+
+int32_t jdelay_process_block_sidechain(jdelay_instance* instance,
+                                       const float* const* inputs, uint32_t num_input_channels,
+                                       float* const* outputs, uint32_t num_output_channels,
+                                       const float* const* sidechain, uint32_t num_sidechain_channels,
+                                       uint32_t num_samples)
+{
+    return processBlock(instance, inputs, num_input_channels, outputs, num_output_channels,
+                        sidechain, num_sidechain_channels, true, num_samples);
+}
+
+double jdelay_get_tail_ms(jdelay_instance* instance)
+{
+    if (instance == nullptr || !instance->prepared)
+        return 0.0;
+
+    return instance->delay.getTailLength_mSec();
+}
+
+jdelay_bank* jdelay_bank_create(uint32_t num_lanes)
+{
+    if (num_lanes != 4 && num_lanes != 8 && num_lanes != 16)
+        return nullptr;
+
+    std::unique_ptr<jdelay_bank> bank(new (std::nothrow) jdelay_bank());
+    if (bank == nullptr)
+        return nullptr;
+
+    // --- the banks carry their scratch buffers: too large for the caller's stack, allocate them here
+    bank->bank4.reset(num_lanes == 4 ? new (std::nothrow) AudioDelayBank<4>() : nullptr);
+    bank->bank8.reset(num_lanes == 8 ? new (std::nothrow) AudioDelayBank<8>() : nullptr);
+    bank->bank16.reset(num_lanes == 16 ? new (std::nothrow) AudioDelayBank<16>() : nullptr);
+    if (!bank->bank4 && !bank->bank8 && !bank->bank16)
+        return nullptr;
+
+    bank->numLanes = num_lanes;
+    return bank.release();
+}
+
+void jdelay_bank_destroy(jdelay_bank* bank)
+{
+    delete bank;
+}
+
+uint32_t jdelay_bank_get_num_lanes(jdelay_bank* bank)
+{
+    return bank != nullptr ? bank->numLanes : 0;
+}
+
+int32_t jdelay_bank_prepare(jdelay_bank* bank, double sample_rate, double max_delay_ms)
+{
+    if (bank == nullptr || !(sample_rate > 0.0) || !(max_delay_ms > 0.0))
+        return JDELAY_ERROR_INVALID_ARGUMENT;
+
+    bank->prepared = false;
+
+    try
+    {
+        // --- the lanes keep their parameters; delays in samples are derived again for the new rate
+        withBank(bank, [&](auto& delays) { delays.createDelayBuffers(sample_rate, max_delay_ms); return JDELAY_OK; });
+    }
+    catch (const std::bad_alloc&)
+    {
+        return JDELAY_ERROR_OUT_OF_MEMORY;
+    }
+
+    bank->prepared = true;
+    return JDELAY_OK;
+}
+
+int32_t jdelay_bank_reset(jdelay_bank* bank)
+{
+    if (bank == nullptr)
+        return JDELAY_ERROR_INVALID_ARGUMENT;
+
+    if (!bank->prepared)
+        return JDELAY_ERROR_NOT_PREPARED;
+
+    return withBank(bank, [](auto& delays) { delays.reset(); return JDELAY_OK; });
+}
+
+int32_t jdelay_bank_set_parameters(jdelay_bank* bank, uint32_t lane, const jdelay_parameters* parameters)
+{
+    if (bank == nullptr || parameters == nullptr || parameters->struct_size == 0 || lane >= bank->numLanes)
+        return JDELAY_ERROR_INVALID_ARGUMENT;
+
+    jdelay_parameters p = completeParameters(parameters);
+    if (p.interpolate == 0 || p.render_quality != 0 || p.freeze != 0)
+        return JDELAY_ERROR_INVALID_ARGUMENT;
+
+    AudioDelayParameters params = toAudioDelayParameters(p);
+    return withBank(bank, [&](auto& delays) { return delays.setParameters(lane, params) ? JDELAY_OK : JDELAY_ERROR_INVALID_ARGUMENT; });
+}
+
+int32_t jdelay_bank_process_block(jdelay_bank* bank, const float* const* inputs, float* const* outputs,
+                                  uint32_t num_samples)
+{
+    if (bank == nullptr || inputs == nullptr || outputs == nullptr)
+        return JDELAY_ERROR_INVALID_ARGUMENT;
+
+    if (!bank->prepared)
+        return JDELAY_ERROR_NOT_PREPARED;
+
+    ScopedNoDenormals noDenormals;
+
+    return withBank(bank, [&](auto& delays) { delays.processAudioBlock(inputs, outputs, num_samples); return JDELAY_OK; });
+}
+
+int32_t jdelay_get_memory_statistics(jdelay_memory_statistics* statistics)
+{
+    if (statistics == nullptr || statistics->struct_size == 0)
+        return JDELAY_ERROR_INVALID_ARGUMENT;
+
+    auto arena = DelayMemoryArena::getInstance().getStatistics();
+
+    jdelay_memory_statistics s;
+    std::memset(&s, 0, sizeof(s));
+    s.struct_size = statistics->struct_size;
+    s.huge_pages = (int32_t)arena.mode;
+    s.reserved_bytes = arena.reservedBytes;
+    s.huge_page_bytes = arena.hugePageBytes;
+    s.in_use_bytes = arena.inUseBytes;
+    s.free_list_bytes = arena.freeListBytes;
+    s.num_buffers = arena.numAllocations;
+    s.num_recycled = arena.numRecycled;
+
+    std::memcpy(statistics, &s, statistics->struct_size < sizeof(s) ? statistics->struct_size : sizeof(s));
+    return JDELAY_OK;
+}
+
+}
@@ -0,0 +1,196 @@
+/* JDelayCore.h
+
+   C interface to the JDelay DSP core (Source/DSP), for hosts that embed the delay without JUCE:
+   game audio engines, web servers rendering previews, other languages through their FFI.
+
+   - Build the shared object with Tools/JDelayCore/JDelayCore.jucer or the static library with
+     Tools/JDelayCore/JDelayCoreStatic.jucer. Neither links JUCE.
+   - Only the functions below are exported. Structs are passed by pointer and carry their size,
+     so fields can be appended without breaking binaries built against an older header.
+   - One instance is not thread-safe: call jdelay_set_parameters() and jdelay_process_block()
+     from the same thread, or serialize them. Instances are independent of each other.
+   - jdelay_create() and jdelay_prepare() allocate; everything else is realtime-safe.
+*/
+
+#ifndef JDELAYCORE_H_INCLUDED
+#define JDELAYCORE_H_INCLUDED
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+ #if defined(JDELAY_CORE_BUILD_DLL)
+  #define JDELAY_API __declspec(dllexport)
+ #elif defined(JDELAY_CORE_DLL)
+  #define JDELAY_API __declspec(dllimport)
+ #else
+  #define JDELAY_API
+ #endif
+#elif defined(__GNUC__) || defined(__clang__)
+ #define JDELAY_API __attribute__((visibility("default")))
+#else
+ #define JDELAY_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** bumped when a function changes; adding functions or appending struct fields keeps the version */
+#define JDELAY_API_VERSION 1
+
+/** return codes */
+#define JDELAY_OK 0
+#define JDELAY_ERROR_INVALID_ARGUMENT -1
+#define JDELAY_ERROR_OUT_OF_MEMORY -2
+#define JDELAY_ERROR_NOT_PREPARED -3
+
+/** delay algorithms; the first four match the plugin's DELAYTYPE choice, multiband and BBD are its choices 5 and 6 */
+#define JDELAY_ALGORITHM_NORMAL 0
+#define JDELAY_ALGORITHM_PINGPONG 1
+#define JDELAY_ALGORITHM_FDN 2
+#define JDELAY_ALGORITHM_REVERSE 3
+#define JDELAY_ALGORITHM_MULTIBAND 4
+#define JDELAY_ALGORITHM_BBD 5
+
+typedef struct jdelay_instance jdelay_instance;
+typedef struct jdelay_bank jdelay_bank;
+
+/** delay parameters; fill with jdelay_parameters_init() and then change what you need */
+typedef struct jdelay_parameters
+{
+    uint32_t struct_size;           /* sizeof(jdelay_parameters), set by jdelay_parameters_init() */
+
+    int32_t algorithm;              /* JDELAY_ALGORITHM_* */
+    double wet_level_db;            /* wet output level */
+    double dry_level_db;            /* dry output level */
+    double feedback_pct;            /* feedback, 0 to 100 */
+
+    double left_delay_ms;           /* left delay time */
+    double right_delay_ms;          /* right delay time; ignored when use_delay_ratio is set */
+    int32_t use_delay_ratio;        /* nonzero: right delay = delay_ratio_pct * left delay */
+    double delay_ratio_pct;         /* right delay as a % of the left delay */
+
+    double fdn_damping_pct;         /* high frequency damping of the FDN lines */
+
+    double duck_threshold_db;       /* key level where wet ducking starts */
+    double duck_depth_db;           /* maximum wet gain reduction; 0 = ducking off */
+    double duck_attack_ms;          /* ducking envelope attack time */
+    double duck_release_ms;         /* ducking envelope release time */
+
+    double pitch_shift_semitones;   /* pitch shift of the repeats, -12 to 12 (normal and ping-pong) */
+
+    int32_t interpolate;            /* nonzero: fractional delay interpolation */
+
+    int32_t multiband_num_bands;            /* JDELAY_ALGORITHM_MULTIBAND: 2 to 4 bands */
+    double multiband_crossover_hz[3];       /* band edges, ascending; the first num_bands - 1 are used */
+    double multiband_delay_pct[4];          /* band delay as a % of the channel's delay time */
+    double multiband_feedback_pct[4];       /* band feedback, 0 to 100 */
+    double multiband_level_db[4];           /* band output level */
+
+    int32_t render_quality;         /* nonzero: Hermite interpolation for offline rendering (normal and ping-pong);
+                                       switching while running crossfades over 20 ms */
+
+    int32_t freeze;                 /* nonzero: hold the repeats as an endless loop, input and feedback off
+                                       (normal and ping-pong); switching it off carries on from the loop */
+
+    double cross_feedback_pct;      /* normal: % of each line's input written into the other line; 0 = separate
+                                       lines, 100 = the ping-pong routing; use_delay_ratio = 0 for independent times */
+} jdelay_parameters;
+
+/** delay memory of the whole process (all instances and banks), see jdelay_get_memory_statistics() */
+typedef struct jdelay_memory_statistics
+{
+    uint32_t struct_size;           /* sizeof(jdelay_memory_statistics), set by the caller */
+
+    int32_t huge_pages;             /* 0 ordinary pages, 1 transparent huge pages, 2 explicit huge pages */
+    uint64_t reserved_bytes;        /* address space mapped for delay memory */
+    uint64_t huge_page_bytes;       /* part of reserved_bytes on huge pages */
+    uint64_t in_use_bytes;          /* held by prepared instances and banks */
+    uint64_t free_list_bytes;       /* released, waiting to be reused by the next prepare */
+    uint32_t num_buffers;           /* delay buffers in use */
+    uint32_t num_recycled;          /* allocations served from released memory so far */
+} jdelay_memory_statistics;
+
+/** JDELAY_API_VERSION of the loaded library */
+JDELAY_API int32_t jdelay_get_api_version(void);
+
+/** set every field to the plugin's defaults */
+JDELAY_API void jdelay_parameters_init(jdelay_parameters* parameters);
+
+/** create an instance; returns NULL when out of memory */
+JDELAY_API jdelay_instance* jdelay_create(void);
+
+/** destroy an instance; NULL is ignored */
+JDELAY_API void jdelay_destroy(jdelay_instance* instance);
+
+/** allocate the delay lines for a sample rate and the longest delay time, and clear all state;
+    must be called before processing and whenever the sample rate changes */
+JDELAY_API int32_t jdelay_prepare(jdelay_instance* instance, double sample_rate, double max_delay_ms);
+
+/** clear the delay lines without reallocating */
+JDELAY_API int32_t jdelay_reset(jdelay_instance* instance);
+
+/** apply new parameters; they take effect at the next processed sample */
+JDELAY_API int32_t jdelay_set_parameters(jdelay_instance* instance, const jdelay_parameters* parameters);
+
+/** process one block of non-interleaved float audio; inputs and outputs may be the same buffers.
+    One channel is processed as mono, two or more as stereo (extra channels are left alone). */
+JDELAY_API int32_t jdelay_process_block(jdelay_instance* instance,
+                                        const float* const* inputs, uint32_t num_input_channels,
+                                        float* const* outputs, uint32_t num_output_channels,
+                                        uint32_t num_samples);
+
+/** same as jdelay_process_block(), with the ducking keyed from a sidechain (one or two channels)
+    instead of the input; a NULL sidechain is a silent key */
+JDELAY_API int32_t jdelay_process_block_sidechain(jdelay_instance* instance,
+                                                  const float* const* inputs, uint32_t num_input_channels,
+                                                  float* const* outputs, uint32_t num_output_channels,
+                                                  const float* const* sidechain, uint32_t num_sidechain_channels,
+                                                  uint32_t num_samples);
+
+/** length of the echo tail after the input stops, in mSec, for the current parameters */
+JDELAY_API double jdelay_get_tail_ms(jdelay_instance* instance);
+
+/* Banks: 4, 8 or 16 stereo delays processed together (AudioDelayBank), for hosts running many
+   delays at once. Each lane sounds exactly like an instance with the same parameters, but a lane
+   only runs the normal and ping-pong algorithms with interpolation on: no ducking, no pitch shift,
+   no render quality, no freeze, no cross feedback. Parameters set during a block take effect with
+   the next block.
+   The same threading and allocation rules as for instances apply. */
+
+/** create a bank of num_lanes (4, 8 or 16) delays; returns NULL for other lane counts or when out of memory */
+JDELAY_API jdelay_bank* jdelay_bank_create(uint32_t num_lanes);
+
+/** destroy a bank; NULL is ignored */
+JDELAY_API void jdelay_bank_destroy(jdelay_bank* bank);
+
+/** number of lanes of a bank */
+JDELAY_API uint32_t jdelay_bank_get_num_lanes(jdelay_bank* bank);
+
+/** allocate the delay lines of every lane, like jdelay_prepare() */
+JDELAY_API int32_t jdelay_bank_prepare(jdelay_bank* bank, double sample_rate, double max_delay_ms);
+
+/** clear the delay lines of every lane without reallocating */
+JDELAY_API int32_t jdelay_bank_reset(jdelay_bank* bank);
+
+/** apply new parameters to one lane; JDELAY_ERROR_INVALID_ARGUMENT (and no change) for parameters
+    a lane cannot run */
+JDELAY_API int32_t jdelay_bank_set_parameters(jdelay_bank* bank, uint32_t lane, const jdelay_parameters* parameters);
+
+/** process one block of every lane: 2 * num_lanes non-interleaved channels, left and right of lane 0,
+    then of lane 1, ...; inputs and outputs may be the same buffers */
+JDELAY_API int32_t jdelay_bank_process_block(jdelay_bank* bank, const float* const* inputs, float* const* outputs,
+                                             uint32_t num_samples);
+
+/* Delay memory: every instance and bank in the process shares one arena, on huge pages where the system
+   provides them (JDELAY_HUGE_PAGES=off in the environment disables them). Destroyed instances leave their
+   memory to the next jdelay_prepare() instead of returning it to the system. */
+
+/** fill the first statistics->struct_size bytes of statistics; takes a lock, so not for the audio thread */
+JDELAY_API int32_t jdelay_get_memory_statistics(jdelay_memory_statistics* statistics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JDELAYCORE_H_INCLUDED */
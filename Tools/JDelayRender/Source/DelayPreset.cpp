@@ -0,0 +1,145 @@
+// DelayPreset.cpp
+
+#include "DelayPreset.h"
+
+namespace
+{
+    /** MBTIME1 - MBTIME4 and friends: the trailing number is a band (or crossover) from 1 to count */
+    bool isBandIndex(int index, int count) { return index >= 1 && index <= count; }
+}
+
+AudioDelayParameters DelayPreset::createDefaultParameters() const
+{
+    // --- keep in sync with JDelayAudioProcessor::createParameterLayout()
+    AudioDelayParameters defaults;
+
+    defaults.updateType = delayUpdateType::kLeftPlusRatio;
+    defaults.dryLevel_dB = -3.0;
+    defaults.leftDelay_mSec = 250.0;
+    defaults.rightDelay_mSec = 125.0;
+    defaults.feedback_Pct = 50.0;
+    defaults.crossFeedback_Pct = 0.0;
+    defaults.delayRatio_Pct = 50.0;
+    defaults.wetLevel_dB = -3.0;
+    defaults.algorithm = delayAlgorithm::kNormal;
+    defaults.fdnDamping_Pct = 30.0;
+    defaults.duckThreshold_dB = -30.0;
+    defaults.duckDepth_dB = 0.0;
+    defaults.duckAttack_mSec = 10.0;
+    defaults.duckRelease_mSec = 250.0;
+    defaults.pitchShift_Semitones = 0.0;
+
+    return defaults;
+}
+
+bool DelayPreset::loadFromFile(const juce::File& presetFile, juce::String& errorMessage)
+{
+    if (! presetFile.existsAsFile())
+    {
+        errorMessage = "Preset file not found: " + presetFile.getFullPathName();
+        return false;
+    }
+
+    std::unique_ptr<juce::XmlElement> xml(juce::XmlDocument::parse(presetFile));
+
+    if (xml == nullptr)
+    {
+        errorMessage = "Preset file is not valid XML: " + presetFile.getFullPathName();
+        return false;
+    }
+
+    parameters = createDefaultParameters();
+    feedbackInserts = FeedbackInsertGraphParameters();
+    name = presetFile.getFileNameWithoutExtension();
+
+    for (auto* param : xml->getChildWithTagNameIterator("PARAM"))
+    {
+        auto parameterID = param->getStringAttribute("id");
+
+        if (! setParameter(parameterID, param->getDoubleAttribute("value")))
+        {
+            errorMessage = "Unknown or unsupported parameter in preset: " + parameterID + " = " + param->getStringAttribute("value");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool DelayPreset::setParameter(const juce::String& parameterID, double value)
+{
+    if (parameterID == "DRYLEVEL")
+        parameters.dryLevel_dB = value;
+    else if (parameterID == "DELAYTIME")
+        parameters.leftDelay_mSec = value;
+    else if (parameterID == "FEEDBACK")
+        parameters.feedback_Pct = value;
+    else if (parameterID == "RATIO")
+        parameters.delayRatio_Pct = value;
+    else if (parameterID == "DELAYMODE")
+        parameters.updateType = (int)value == 1 ? delayUpdateType::kLeftAndRight : delayUpdateType::kLeftPlusRatio;
+    else if (parameterID == "RIGHTDELAYTIME")
+        parameters.rightDelay_mSec = value;
+    else if (parameterID == "CROSSFEEDBACK")
+        parameters.crossFeedback_Pct = value;
+    else if (parameterID == "WETLEVEL")
+        parameters.wetLevel_dB = value;
+    else if (parameterID == "DELAYTYPE")
+    {
+        // --- the plugin's Spectral type (4) runs outside the DSP core and can't be rendered here;
+        //     Multiband (5) and BBD (6) were added after it
+        if ((int)value == 5)
+            parameters.algorithm = delayAlgorithm::kMultiband;
+        else if ((int)value == 6)
+            parameters.algorithm = delayAlgorithm::kBBD;
+        else if ((int)value > (int)delayAlgorithm::kReverse)
+            return false;
+        else
+            parameters.algorithm = convertIntToEnum((int)value, delayAlgorithm);
+    }
+    else if (parameterID == "DAMPING")
+        parameters.fdnDamping_Pct = value;
+    else if (parameterID == "DUCKTHRESHOLD")
+        parameters.duckThreshold_dB = value;
+    else if (parameterID == "DUCKDEPTH")
+        parameters.duckDepth_dB = value;
+    else if (parameterID == "DUCKATTACK")
+        parameters.duckAttack_mSec = value;
+    else if (parameterID == "DUCKRELEASE")
+        parameters.duckRelease_mSec = value;
+    else if (parameterID == "PITCHSHIFT")
+        parameters.pitchShift_Semitones = value;
+    else if (parameterID == "DUCKKEY")
+        ;   // --- offline renders have no sidechain: ducking is always keyed from the input
+    else if (parameterID == "SPECTRALTILT")
+        ;   // --- only used by the Spectral type
+    else if (parameterID == "FREEZE")
+        ;   // --- a freeze holds what was playing live; renders start from empty lines and would only hold silence
+    else if (parameterID == "MBBANDS")
+        parameters.multibandNumBands = (int)value;
+    else if (parameterID.startsWith("MBCROSS") && isBandIndex(parameterID.getTrailingIntValue(), 3))
+        parameters.multibandCrossover_Hz[parameterID.getTrailingIntValue() - 1] = value;
+    else if (parameterID.startsWith("MBTIME") && isBandIndex(parameterID.getTrailingIntValue(), 4))
+        parameters.multibandDelay_Pct[parameterID.getTrailingIntValue() - 1] = value;
+    else if (parameterID.startsWith("MBFEEDBACK") && isBandIndex(parameterID.getTrailingIntValue(), 4))
+        parameters.multibandFeedback_Pct[parameterID.getTrailingIntValue() - 1] = value;
+    else if (parameterID.startsWith("MBLEVEL") && isBandIndex(parameterID.getTrailingIntValue(), 4))
+        parameters.multibandLevel_dB[parameterID.getTrailingIntValue() - 1] = value;
+    else if (parameterID.startsWith("FXSLOT") && isBandIndex(parameterID.getTrailingIntValue(), FeedbackInsertGraphParameters::maxNumSlots)
+             && (int)value >= 0 && (int)value <= (int)feedbackInsertType::kProcessor)
+        feedbackInserts.slots[parameterID.getTrailingIntValue() - 1] = convertIntToEnum((int)value, feedbackInsertType);
+    else if (parameterID == "FXLOWPASS")
+        feedbackInserts.lowpass_Hz = value;
+    else if (parameterID == "FXHIGHPASS")
+        feedbackInserts.highpass_Hz = value;
+    else if (parameterID == "FXDRIVE")
+        feedbackInserts.drive_dB = value;
+    else if (parameterID == "FXMODRATE")
+        feedbackInserts.modulationRate_Hz = value;
+    else if (parameterID == "FXMODDEPTH")
+        feedbackInserts.modulationDepth_mSec = value;
+    else
+        return false;
+
+    return true;
+}
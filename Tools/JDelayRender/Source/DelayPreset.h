@@ -0,0 +1,36 @@
+// DelayPreset.h
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "../../../Source/DSP/AudioDelayParameters.h"
+#include "../../../Source/DSP/FeedbackInsertGraph.h"
+
+/**
+Loads AudioDelayParameters and the feedback chain (FeedbackInsertGraphParameters) from a preset file.
+
+The preset file uses the same XML layout the plugin writes in getStateInformation():
+a root element holding one <PARAM id="..." value="..."/> child per parameter.
+Parameters missing from the file keep the plugin's default values.
+*/
+class DelayPreset
+{
+public:
+    /** load a preset file; returns false and fills errorMessage if the file can't be parsed */
+    bool loadFromFile(const juce::File& presetFile, juce::String& errorMessage);
+
+    /** set a single parameter by its plugin ID, e.g. "DELAYTIME" */
+    bool setParameter(const juce::String& parameterID, double value);
+
+    AudioDelayParameters getParameters() const { return parameters; }
+    FeedbackInsertGraphParameters getFeedbackInserts() const { return feedbackInserts; }
+    juce::String getName() const { return name; }
+
+private:
+    AudioDelayParameters createDefaultParameters() const;
+
+    AudioDelayParameters parameters = createDefaultParameters();
+    FeedbackInsertGraphParameters feedbackInserts;
+    juce::String name = "Default";
+};
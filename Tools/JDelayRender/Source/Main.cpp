@@ -0,0 +1,179 @@
+// Main.cpp
+
+#include <JuceHeader.h>
+
+#include "DelayPreset.h"
+#include "RegressionCheck.h"
+#include "RenderJob.h"
+
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "Usage: JDelayRender --preset=<file> [options] <audio files or folders...>\n"
+                     "       JDelayRender --verify\n"
+                     "\n"
+                     "Options:\n"
+                     "  --preset=<file>     preset XML (same layout as the plugin state)\n"
+                     "  --output=<folder>   where rendered files go (default: next to each input)\n"
+                     "  --threads=<n>       worker threads (default: number of CPUs)\n"
+                     "  --max-tail=<sec>    longest tail rendered after the input ends (default: 30)\n"
+                     "  --feedback-ir=<file> convolve every repeat with the first 100 ms of an impulse response\n"
+                     "  --verify            compare every DSP processing path against the reference path\n";
+    }
+
+    juce::Array<juce::File> collectInputFiles(const juce::ArgumentList& args, const juce::String& wildcard)
+    {
+        juce::Array<juce::File> files;
+
+        for (auto& arg : args.arguments)
+        {
+            if (arg.isOption())
+                continue;
+
+            auto file = arg.resolveAsFile();
+
+            if (file.isDirectory())
+                files.addArray(file.findChildFiles(juce::File::findFiles, true, wildcard));
+            else
+                files.add(file);
+        }
+
+        return files;
+    }
+
+    juce::File getOutputFileFor(const juce::File& inputFile, const juce::File& outputFolder)
+    {
+        auto folder = outputFolder == juce::File() ? inputFile.getParentDirectory() : outputFolder;
+        return folder.getChildFile(inputFile.getFileNameWithoutExtension() + "_jdelay.wav");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ArgumentList args(argc, argv);
+
+    if (args.size() == 0 || args.containsOption("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    if (args.containsOption("--verify"))
+        return RegressionCheck().run() ? 0 : 1;
+
+    DelayPreset preset;
+
+    if (args.containsOption("--preset"))
+    {
+        juce::String errorMessage;
+
+        if (! preset.loadFromFile(args.getFileForOption("--preset"), errorMessage))
+        {
+            std::cerr << errorMessage << std::endl;
+            return 1;
+        }
+    }
+
+    juce::File outputFolder;
+
+    if (args.containsOption("--output"))
+    {
+        outputFolder = args.getFileForOption("--output");
+
+        if (! outputFolder.createDirectory())
+        {
+            std::cerr << "Can't create output folder " << outputFolder.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    auto numThreads = juce::jmax(1, args.containsOption("--threads") ? args.getValueForOption("--threads").getIntValue()
+                                                                     : juce::SystemStats::getNumCpus());
+    auto maxTail_mSec = args.containsOption("--max-tail") ? args.getValueForOption("--max-tail").getDoubleValue() * 1000.0
+                                                          : 30000.0;
+
+    juce::AudioBuffer<float> feedbackIR;
+    double feedbackIRSampleRate = 0.0;
+
+    if (args.containsOption("--feedback-ir"))
+    {
+        juce::String errorMessage;
+
+        if (! FeedbackImpulseResponse::loadFile(args.getFileForOption("--feedback-ir"), feedbackIR, feedbackIRSampleRate, errorMessage))
+        {
+            std::cerr << errorMessage << std::endl;
+            return 1;
+        }
+    }
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    auto inputFiles = collectInputFiles(args, formatManager.getWildcardForAllFormats());
+
+    if (inputFiles.isEmpty())
+    {
+        std::cerr << "No input files" << std::endl;
+        return 1;
+    }
+
+    // --- queue the largest files first so the last jobs to finish are short ones
+    std::sort(inputFiles.begin(), inputFiles.end(),
+              [](const juce::File& a, const juce::File& b) { return a.getSize() > b.getSize(); });
+
+    juce::OwnedArray<RenderJob> jobs;
+
+    for (auto& inputFile : inputFiles)
+        jobs.add(new RenderJob(inputFile, getOutputFileFor(inputFile, outputFolder), preset.getParameters(),
+                               preset.getFeedbackInserts(), maxTail_mSec,
+                               feedbackIRSampleRate > 0.0 ? &feedbackIR : nullptr, feedbackIRSampleRate));
+
+    std::cout << "Rendering " << jobs.size() << " file(s) with preset '" << preset.getName()
+              << "' on " << numThreads << " thread(s)" << std::endl;
+
+    auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    {
+        juce::ThreadPool pool(numThreads);
+
+        for (auto* job : jobs)
+            pool.addJob(job, false);
+
+        while (pool.getNumJobs() > 0)
+            juce::Thread::sleep(10);
+    }
+
+    auto wallSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+    // --- report
+    int numFailed = 0;
+    double totalAudioSeconds = 0.0;
+
+    for (auto* job : jobs)
+    {
+        if (! job->succeeded())
+        {
+            ++numFailed;
+            std::cerr << "FAILED " << job->getInputFile().getFullPathName() << ": " << job->getErrorMessage() << std::endl;
+            continue;
+        }
+
+        totalAudioSeconds += job->getAudioSeconds();
+
+        auto realtimeFactor = job->getProcessingSeconds() > 0.0 ? job->getAudioSeconds() / job->getProcessingSeconds() : 0.0;
+        std::cout << job->getOutputFile().getFullPathName() << "  "
+                  << juce::String(job->getAudioSeconds(), 2) << " s audio, "
+                  << juce::String(realtimeFactor, 1) << "x realtime" << std::endl;
+    }
+
+    auto aggregateFactor = wallSeconds > 0.0 ? totalAudioSeconds / wallSeconds : 0.0;
+
+    std::cout << "\n"
+              << jobs.size() - numFailed << " rendered, " << numFailed << " failed\n"
+              << juce::String(totalAudioSeconds, 1) << " s of audio in " << juce::String(wallSeconds, 2) << " s\n"
+              << "Realtime factor: " << juce::String(aggregateFactor, 1) << "x total, "
+              << juce::String(aggregateFactor / numThreads, 1) << "x per core" << std::endl;
+
+    return numFailed == 0 ? 0 : 1;
+}
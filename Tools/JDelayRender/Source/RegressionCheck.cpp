@@ -0,0 +1,741 @@
+// RegressionCheck.cpp
+
+#include "RegressionCheck.h"
+
+RegressionCheck::RegressionCheck()
+{
+    createAutomationPatterns();
+    createRenderPaths();
+}
+
+void RegressionCheck::createTestSignals(int numChannels)
+{
+    testSignals.clear();
+
+    // --- impulses every 100 mSec, alternating polarity, right channel offset so L/R differ
+    auto* impulses = testSignals.add(new TestSignal{ "impulses", juce::AudioBuffer<float>(numChannels, signalLength) });
+    impulses->audio.clear();
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int i = ch * 37, n = 0; i < signalLength; i += 4800, ++n)
+            impulses->audio.setSample(ch, i, (n & 1) ? -1.0f : 1.0f);
+
+    // --- exponential sine sweep 20 Hz - 20 kHz at -6 dB
+    auto* sweep = testSignals.add(new TestSignal{ "sweep", juce::AudioBuffer<float>(numChannels, signalLength) });
+    auto sweepRate = std::log(20000.0 / 20.0);
+    for (int i = 0; i < signalLength; ++i)
+    {
+        auto t = (double)i / sampleRate;
+        auto duration = (double)signalLength / sampleRate;
+        auto phase = juce::MathConstants<double>::twoPi * 20.0 * duration / sweepRate * (std::exp(t * sweepRate / duration) - 1.0);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            sweep->audio.setSample(ch, i, (float)(0.5 * std::sin(phase + ch * 0.5)));
+    }
+
+    // --- seeded white noise at -6 dB, independent per channel
+    auto* noise = testSignals.add(new TestSignal{ "noise", juce::AudioBuffer<float>(numChannels, signalLength) });
+    juce::Random random(0x4a44656c);
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int i = 0; i < signalLength; ++i)
+            noise->audio.setSample(ch, i, random.nextFloat() - 0.5f);
+}
+
+void RegressionCheck::createAutomationPatterns()
+{
+    // --- values are rounded to float, like the plugin's parameters
+    automationPatterns.push_back({ "static", [](AudioDelayParameters&, int, double) {} });
+
+    automationPatterns.push_back({ "delay ramp", [](AudioDelayParameters& p, int i, double fs)
+    {
+        // --- 10 mSec to 510 mSec over one second: fractional delays on every sample
+        p.leftDelay_mSec = (float)(10.0 + 500.0 * i / fs);
+    } });
+
+    automationPatterns.push_back({ "delay steps", [](AudioDelayParameters& p, int i, double)
+    {
+        // --- hard jumps every 1000 samples, including very short delays
+        static const double steps[] = { 250.0, 1.5, 700.25, 33.3, 1999.0, 0.0 };
+        p.leftDelay_mSec = (float)steps[(i / 1000) % 6];
+    } });
+
+    automationPatterns.push_back({ "fast modulation", [](AudioDelayParameters& p, int i, double fs)
+    {
+        auto t = i / fs;
+        p.wetLevel_dB = (float)(-20.0 + 20.0 * std::sin(juce::MathConstants<double>::twoPi * 7.0 * t));
+        p.dryLevel_dB = (float)(-10.0 + 10.0 * std::cos(juce::MathConstants<double>::twoPi * 3.0 * t));
+        p.feedback_Pct = (float)(50.0 + 45.0 * std::sin(juce::MathConstants<double>::twoPi * 0.5 * t));
+        p.delayRatio_Pct = (float)(50.0 + 50.0 * std::sin(juce::MathConstants<double>::twoPi * 2.0 * t));
+    } });
+
+    automationPatterns.push_back({ "ducked", [](AudioDelayParameters& p, int, double)
+    {
+        // --- wet ducking keyed from the input, fast enough to move within every block
+        p.duckThreshold_dB = -30.0;
+        p.duckDepth_dB = 24.0;
+        p.duckAttack_mSec = 2.0;
+        p.duckRelease_mSec = 50.0;
+    } });
+
+    automationPatterns.push_back({ "sidechain ducked", [](AudioDelayParameters& p, int, double)
+    {
+        // --- the same ducking, keyed from the aux input
+        p.duckThreshold_dB = -30.0;
+        p.duckDepth_dB = 24.0;
+        p.duckAttack_mSec = 2.0;
+        p.duckRelease_mSec = 50.0;
+    },
+    [](int channel, int i)
+    {
+        // --- 75 mSec bursts every 150 mSec, the right channel's 25 mSec later, so the key moves within blocks
+        return ((i + channel * 1200) / 3600) % 2 == 0 ? 0.5f * (float)std::sin(0.03 * i) : 0.0f;
+    } });
+
+    automationPatterns.push_back({ "shimmer", [](AudioDelayParameters& p, int, double)
+    {
+        // --- an octave up on the read side; with feedback every repeat is shifted again
+        p.pitchShift_Semitones = 12.0;
+    } });
+
+    automationPatterns.push_back({ "freeze", [](AudioDelayParameters& p, int i, double)
+    {
+        // --- held for the middle half; on and off at block starts of renderBlocks(), which sets it per block
+        p.freeze = i >= 36 * 333 && i < 108 * 333;
+    } });
+
+    automationPatterns.push_back({ "wide stereo", [](AudioDelayParameters& p, int i, double fs)
+    {
+        // --- independent times, the right one gliding; cross feedback steps from separate lines to
+        //     ping-pong at block starts of renderBlocks(), which sets it per block
+        p.updateType = delayUpdateType::kLeftAndRight;
+        p.rightDelay_mSec = (float)(40.0 + 300.0 * i / fs);
+        p.crossFeedback_Pct = 25.0 * ((i / (36 * 333)) % 5);
+    } });
+}
+
+void RegressionCheck::createRenderPaths()
+{
+    renderPaths.push_back({ "reference (re-run)", 0.0, &RegressionCheck::renderReference });
+
+    // --- a flushed delay must sound exactly like a new one: only the written part of the lines is cleared
+    renderPaths.push_back({ "reference after flush", 0.0,
+                            [](AudioDelay& delay, const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output,
+                               const AudioDelayParameters& base, const AutomationPattern& automation, double fs)
+                            {
+                                renderReference(delay, input, output, base, automation, fs);
+                                delay.createDelayBuffers(fs, 2000.0);
+                                renderReference(delay, input, output, base, automation, fs);
+                            } });
+
+    // --- the block path once per instruction set variant this CPU can run
+    for (auto variant : { isaVariant::kGeneric, isaVariant::kSSE2, isaVariant::kAVX2, isaVariant::kAVX512 })
+    {
+        if (! DSPKernels::isSupported(variant))
+            continue;
+
+        renderPaths.push_back({ juce::String("block kernels (") + DSPKernels::getVariantName(variant) + ")", 0.0,
+                                [variant](AudioDelay& delay, const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output,
+                                          const AudioDelayParameters& base, const AutomationPattern& automation, double fs)
+                                {
+                                    DSPKernels::forceVariant(variant);
+                                    renderBlocks(delay, input, output, base, automation, fs);
+                                } });
+    }
+}
+
+void RegressionCheck::prepareDelay(AudioDelay& delay, double fs, Interpolation interpolation)
+{
+    delay.createDelayBuffers(fs, 2000.0);
+    delay.setInterpolate(interpolation != Interpolation::kInteger);
+    delay.setRenderQuality(interpolation == Interpolation::kRenderQuality);
+}
+
+const char* RegressionCheck::getInterpolationName(Interpolation interpolation)
+{
+    switch (interpolation)
+    {
+        case Interpolation::kInteger: return "integer";
+        case Interpolation::kRenderQuality: return "render quality";
+        default: return "interpolated";
+    }
+}
+
+void RegressionCheck::renderReference(AudioDelay& delay, const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output,
+                                      const AudioDelayParameters& base, const AutomationPattern& automation, double fs)
+{
+    auto numChannels = (uint32_t)input.getNumChannels();
+    delay.enableAuxInput(automation.sidechainKey != nullptr);
+
+    for (int i = 0; i < input.getNumSamples(); ++i)
+    {
+        AudioDelayParameters params = base;
+        automation.apply(params, i, fs);
+        delay.setParameters(params);
+
+        // --- a stereo key goes in as the larger magnitude of its two channels
+        if (automation.sidechainKey)
+            delay.processAuxInputAudioSample(std::fmax(std::abs(automation.sidechainKey(0, i)), std::abs(automation.sidechainKey(1, i))));
+
+        float inputFrame[2]{ input.getSample(0, i), input.getSample((int)numChannels - 1, i) };
+        float outputFrame[2];
+
+        delay.processAudioFrame(inputFrame, outputFrame, numChannels, numChannels);
+
+        for (uint32_t ch = 0; ch < numChannels; ++ch)
+            output.setSample((int)ch, i, outputFrame[ch]);
+    }
+}
+
+void RegressionCheck::renderBlocks(AudioDelay& delay, const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output,
+                                   const AudioDelayParameters& base, const AutomationPattern& automation, double fs)
+{
+    // --- an odd block size so blocks don't line up with the automation steps
+    constexpr int blockSize = 333;
+    auto numChannels = (uint32_t)input.getNumChannels();
+    delay.enableAuxInput(automation.sidechainKey != nullptr);
+
+    output.makeCopyOf(input);
+
+    std::vector<AudioDelayParameters> blockParameters((size_t)blockSize);
+    float curves[6][blockSize];
+    float keys[2][blockSize];
+
+    for (int start = 0; start < input.getNumSamples(); start += blockSize)
+    {
+        auto numSamples = juce::jmin(blockSize, input.getNumSamples() - start);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            blockParameters[(size_t)i] = base;
+            automation.apply(blockParameters[(size_t)i], start + i, fs);
+
+            curves[0][i] = (float)blockParameters[(size_t)i].leftDelay_mSec;
+            curves[1][i] = (float)blockParameters[(size_t)i].rightDelay_mSec;
+            curves[2][i] = (float)blockParameters[(size_t)i].delayRatio_Pct;
+            curves[3][i] = (float)blockParameters[(size_t)i].feedback_Pct;
+            curves[4][i] = (float)blockParameters[(size_t)i].wetLevel_dB;
+            curves[5][i] = (float)blockParameters[(size_t)i].dryLevel_dB;
+
+            if (automation.sidechainKey)
+                for (int ch = 0; ch < 2; ++ch)
+                    keys[ch][i] = automation.sidechainKey(ch, start + i);
+        }
+
+        // --- only pass curves for parameters that actually move within this block
+        auto curveIfMoving = [&](int c) -> const float*
+        {
+            for (int i = 1; i < numSamples; ++i)
+                if (curves[c][i] != curves[c][0])
+                    return curves[c];
+            return nullptr;
+        };
+
+        AudioDelayAutomation blockAutomation;
+        blockAutomation.leftDelay_mSec = curveIfMoving(0);
+        blockAutomation.rightDelay_mSec = curveIfMoving(1);
+        blockAutomation.delayRatio_Pct = curveIfMoving(2);
+        blockAutomation.feedback_Pct = curveIfMoving(3);
+        blockAutomation.wetLevel_dB = curveIfMoving(4);
+        blockAutomation.dryLevel_dB = curveIfMoving(5);
+
+        delay.setParameters(blockParameters[0]);
+
+        float* channels[2]{ output.getWritePointer(0, start), output.getWritePointer((int)numChannels - 1, start) };
+        const float* sidechain[2]{ keys[0], keys[1] };
+        delay.processAudioBlock(channels, channels, numChannels, numChannels, (uint32_t)numSamples,
+                                blockAutomation.isStatic() ? nullptr : &blockAutomation,
+                                automation.sidechainKey ? sidechain : nullptr, automation.sidechainKey ? 2 : 0);
+    }
+}
+
+bool RegressionCheck::run()
+{
+    const delayAlgorithm algorithms[] = { delayAlgorithm::kNormal, delayAlgorithm::kPingPong, delayAlgorithm::kFDN,
+                                          delayAlgorithm::kReverse, delayAlgorithm::kMultiband, delayAlgorithm::kBBD };
+    const char* algorithmNames[] = { "normal", "pingpong", "fdn", "reverse", "multiband", "bbd" };
+
+    auto activeVariant = DSPKernels::getActiveVariant();
+
+    int numCases = 0, numFailures = 0;
+    std::vector<double> worstError(renderPaths.size(), 0.0);
+
+    for (int numChannels = 1; numChannels <= 2; ++numChannels)
+    {
+        createTestSignals(numChannels);
+
+        for (int a = 0; a < (int)std::size(algorithms); ++a)
+        {
+            for (auto interpolation : { Interpolation::kLinear, Interpolation::kInteger, Interpolation::kRenderQuality })
+            {
+                for (auto& automation : automationPatterns)
+                {
+                    AudioDelayParameters base;
+                    base.algorithm = algorithms[a];
+                    base.updateType = delayUpdateType::kLeftPlusRatio;
+                    base.leftDelay_mSec = 123.45;
+                    base.delayRatio_Pct = 61.8;
+                    base.feedback_Pct = 70.0;
+                    base.wetLevel_dB = -3.0;
+                    base.dryLevel_dB = -3.0;
+                    base.fdnDamping_Pct = 30.0;
+
+                    for (auto* signal : testSignals)
+                    {
+                        juce::AudioBuffer<float> reference(numChannels, signalLength);
+                        AudioDelay referenceDelay;
+                        prepareDelay(referenceDelay, sampleRate, interpolation);
+                        renderReference(referenceDelay, signal->audio, reference, base, automation, sampleRate);
+
+                        for (size_t p = 0; p < renderPaths.size(); ++p)
+                        {
+                            auto& path = renderPaths[p];
+
+                            juce::AudioBuffer<float> output(numChannels, signalLength);
+                            AudioDelay delay;
+                            prepareDelay(delay, sampleRate, interpolation);
+                            path.render(delay, signal->audio, output, base, automation, sampleRate);
+
+                            double maxError = getMaxError(output, reference);
+
+                            worstError[p] = juce::jmax(worstError[p], maxError);
+                            ++numCases;
+
+                            if (maxError > path.maxAbsError)
+                            {
+                                ++numFailures;
+                                std::cout << "FAIL " << path.name << ": " << signal->name << ", " << algorithmNames[a] << ", "
+                                          << (numChannels == 1 ? "mono" : "stereo") << ", "
+                                          << getInterpolationName(interpolation) << ", " << automation.name
+                                          << "  max error " << maxError << " > bound " << path.maxAbsError << std::endl;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    numFailures += checkRenderQualitySwitch(numCases);
+    numFailures += checkFeedbackInserts(numCases);
+    numFailures += checkFDNLineCounts(numCases);
+    numFailures += checkSpectralBlocks(numCases);
+    numFailures += checkDelayBank<4>(numCases);
+    numFailures += checkDelayBank<8>(numCases);
+    numFailures += checkDelayBank<16>(numCases);
+
+    DSPKernels::forceVariant(activeVariant);
+
+    std::cout << "\n";
+    for (size_t p = 0; p < renderPaths.size(); ++p)
+        std::cout << renderPaths[p].name << ": worst error " << worstError[p] << " (bound " << renderPaths[p].maxAbsError << ")" << std::endl;
+
+    std::cout << numCases - numFailures << "/" << numCases << " cases within bounds" << std::endl;
+
+    return numFailures == 0;
+}
+
+int RegressionCheck::checkRenderQualitySwitch(int& numCases)
+{
+    // --- on for the middle part: a crossfade in, a stretch of Hermite reads, a crossfade out
+    constexpr int switchOn = 10000, switchOff = 30000;
+
+    int numFailures = 0;
+
+    for (int numChannels = 1; numChannels <= 2; ++numChannels)
+    {
+        createTestSignals(numChannels);
+
+        for (auto algorithm : { delayAlgorithm::kNormal, delayAlgorithm::kPingPong })
+        {
+            for (auto& automation : automationPatterns)
+            {
+                AudioDelayParameters base;
+                base.algorithm = algorithm;
+                base.updateType = delayUpdateType::kLeftPlusRatio;
+                base.leftDelay_mSec = 123.45;
+                base.delayRatio_Pct = 61.8;
+                base.feedback_Pct = 70.0;
+
+                for (auto* signal : testSignals)
+                {
+                    AudioDelay referenceDelay, delay;
+                    prepareDelay(referenceDelay, sampleRate, Interpolation::kLinear);
+                    prepareDelay(delay, sampleRate, Interpolation::kLinear);
+
+                    auto maxError = renderInParts(referenceDelay, delay, signal->audio, base, automation, { 0, switchOn, switchOff, signalLength },
+                                                  [](AudioDelay& d, int part) { d.setRenderQuality(part == 1); });
+
+                    ++numCases;
+
+                    if (maxError > 0.0)
+                    {
+                        ++numFailures;
+                        std::cout << "FAIL render quality switch: " << signal->name << ", "
+                                  << (algorithm == delayAlgorithm::kNormal ? "normal" : "pingpong") << ", "
+                                  << (numChannels == 1 ? "mono" : "stereo") << ", " << automation.name
+                                  << "  max error " << maxError << std::endl;
+                    }
+                }
+            }
+        }
+    }
+
+    return numFailures;
+}
+
+int RegressionCheck::checkFeedbackInserts(int& numCases)
+{
+    // --- a seeded decaying noise IR, 50 mSec, a little quieter each pass so the loop stays stable
+    juce::AudioBuffer<float> irSource(2, 2400);
+    juce::Random random(0x46424952);
+    for (int ch = 0; ch < 2; ++ch)
+        for (int i = 0; i < irSource.getNumSamples(); ++i)
+            irSource.setSample(ch, i, 0.1f * std::exp(-(float)i / 480.0f) * (random.nextFloat() - 0.5f));
+
+    // --- every node type, the IR convolution after the last one
+    FeedbackInsertGraphParameters graphParameters;
+    graphParameters.slots[0] = feedbackInsertType::kHighpass;
+    graphParameters.slots[1] = feedbackInsertType::kSaturator;
+    graphParameters.slots[2] = feedbackInsertType::kModulation;
+    graphParameters.slots[3] = feedbackInsertType::kLowpass;
+
+    int numFailures = 0;
+
+    for (int numChannels = 1; numChannels <= 2; ++numChannels)
+    {
+        createTestSignals(numChannels);
+
+        for (auto algorithm : { delayAlgorithm::kNormal, delayAlgorithm::kPingPong })
+        {
+            for (bool convolve : { false, true })
+            {
+                for (auto& automation : automationPatterns)
+                {
+                    AudioDelayParameters base;
+                    base.algorithm = algorithm;
+                    base.updateType = delayUpdateType::kLeftPlusRatio;
+                    base.leftDelay_mSec = 123.45;
+                    base.delayRatio_Pct = 61.8;
+                    base.feedback_Pct = 70.0;
+
+                    for (auto* signal : testSignals)
+                    {
+                        juce::AudioBuffer<float> reference(numChannels, signalLength), output(numChannels, signalLength);
+                        AudioDelay referenceDelay, delay;
+                        FeedbackInsertGraph graphs[2][2];
+                        FeedbackConvolver convolvers[2][2];
+                        std::shared_ptr<const FeedbackImpulseResponse> ir;
+
+                        // --- each delay gets its own pair of graphs, set up as the plugin does
+                        AudioDelay* delays[2]{ &referenceDelay, &delay };
+                        for (int d = 0; d < 2; ++d)
+                        {
+                            prepareDelay(*delays[d], sampleRate, Interpolation::kLinear);
+                            delays[d]->setParameters(base);
+                            auto minimumDelay = delays[d]->getMinimumDelayInSamples();
+
+                            if (convolve && ir == nullptr)
+                                ir = FeedbackImpulseResponse::get(irSource, sampleRate, sampleRate, FeedbackConvolver::getPartitionSize(minimumDelay));
+
+                            for (int ch = 0; ch < 2; ++ch)
+                            {
+                                graphs[d][ch].prepare(sampleRate, ch == 0 ? 0.0 : kPi / 2.0);
+                                graphs[d][ch].setParameters(graphParameters);
+
+                                if (convolve)
+                                {
+                                    convolvers[d][ch].prepare(sampleRate);
+                                    convolvers[d][ch].setImpulseResponse(ir.get(), ch);
+                                    graphs[d][ch].setProcessor(&convolvers[d][ch]);
+                                }
+
+                                graphs[d][ch].updateBlockSize(minimumDelay);
+                            }
+
+                            delays[d]->setFeedbackInserts(&graphs[d][0], &graphs[d][1]);
+                        }
+
+                        renderReference(referenceDelay, signal->audio, reference, base, automation, sampleRate);
+                        renderBlocks(delay, signal->audio, output, base, automation, sampleRate);
+
+                        auto maxError = getMaxError(output, reference);
+
+                        ++numCases;
+
+                        if (maxError > 0.0)
+                        {
+                            ++numFailures;
+                            std::cout << "FAIL feedback inserts" << (convolve ? " + IR: " : ": ") << signal->name << ", "
+                                      << (algorithm == delayAlgorithm::kNormal ? "normal" : "pingpong") << ", "
+                                      << (numChannels == 1 ? "mono" : "stereo") << ", " << automation.name
+                                      << "  max error " << maxError << std::endl;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return numFailures;
+}
+
+int RegressionCheck::checkFDNLineCounts(int& numCases)
+{
+    // --- 4 and 16 lines throughout, then 8 -> 16 -> 4 -> 8 with a switch every quarter second
+    const std::vector<std::vector<int>> lineCounts{ { 4, 4, 4, 4 }, { 16, 16, 16, 16 }, { 8, 16, 4, 8 } };
+    const std::vector<int> parts{ 0, 12000, 24000, 36000, signalLength };
+
+    int numFailures = 0;
+
+    for (int numChannels = 1; numChannels <= 2; ++numChannels)
+    {
+        createTestSignals(numChannels);
+
+        for (auto& numLines : lineCounts)
+        {
+            for (auto& automation : automationPatterns)
+            {
+                AudioDelayParameters base;
+                base.algorithm = delayAlgorithm::kFDN;
+                base.updateType = delayUpdateType::kLeftPlusRatio;
+                base.leftDelay_mSec = 123.45;
+                base.delayRatio_Pct = 61.8;
+                base.feedback_Pct = 70.0;
+                base.fdnDamping_Pct = 30.0;
+
+                for (auto* signal : testSignals)
+                {
+                    AudioDelay referenceDelay, delay;
+                    prepareDelay(referenceDelay, sampleRate, Interpolation::kLinear);
+                    prepareDelay(delay, sampleRate, Interpolation::kLinear);
+
+                    auto maxError = renderInParts(referenceDelay, delay, signal->audio, base, automation, parts,
+                                                  [&numLines](AudioDelay& d, int part) { d.setFDNNumLines(numLines[(size_t)part]); });
+
+                    ++numCases;
+
+                    if (maxError > 0.0)
+                    {
+                        ++numFailures;
+                        std::cout << "FAIL fdn lines " << numLines[0] << "/" << numLines[1] << "/" << numLines[2] << "/" << numLines[3] << ": "
+                                  << signal->name << ", " << (numChannels == 1 ? "mono" : "stereo") << ", " << automation.name
+                                  << "  max error " << maxError << std::endl;
+                    }
+                }
+            }
+        }
+    }
+
+    return numFailures;
+}
+
+int RegressionCheck::checkSpectralBlocks(int& numCases)
+{
+    constexpr int blockSize = 333;
+
+    // --- delay, tilt and feedback change at the part boundaries; the levels stay put, their ramps
+    // --- follow the calls and only come out the same for any split while static
+    const int parts[] = { 0, 9000, 21000, 33000, signalLength };
+    SpectralDelay::Parameters settings[4];
+    settings[1].delay_mSec = 180.0f;
+    settings[1].tilt_Pct = 60.0f;
+    settings[2].delay_mSec = 410.0f;
+    settings[2].tilt_Pct = -80.0f;
+    settings[2].feedback_Pct = 85.0f;
+    settings[3].feedback_Pct = 20.0f;
+    settings[3].damping_Pct = 70.0f;
+
+    int numFailures = 0;
+
+    for (int numChannels = 1; numChannels <= 2; ++numChannels)
+    {
+        createTestSignals(numChannels);
+
+        for (auto* signal : testSignals)
+        {
+            juce::AudioBuffer<float> reference(signal->audio), output(signal->audio);
+            SpectralDelay referenceDelay, delay;
+
+            // --- parameters first, so prepare() starts the levels at their targets
+            for (auto* d : { &referenceDelay, &delay })
+            {
+                d->setParameters(settings[0]);
+                d->prepare(sampleRate, 1000.0, numChannels);
+            }
+
+            for (int part = 0; part < 4; ++part)
+            {
+                referenceDelay.setParameters(settings[part]);
+                delay.setParameters(settings[part]);
+
+                // --- the reference one sample per call, the path under test in odd-sized blocks
+                for (int i = parts[part]; i < parts[part + 1]; ++i)
+                {
+                    float* channels[2]{ reference.getWritePointer(0, i), reference.getWritePointer(numChannels - 1, i) };
+                    referenceDelay.process(channels, numChannels, 1);
+                }
+
+                for (int start = parts[part]; start < parts[part + 1]; start += blockSize)
+                {
+                    float* channels[2]{ output.getWritePointer(0, start), output.getWritePointer(numChannels - 1, start) };
+                    delay.process(channels, numChannels, juce::jmin(blockSize, parts[part + 1] - start));
+                }
+            }
+
+            auto maxError = getMaxError(output, reference);
+
+            ++numCases;
+
+            if (maxError > 0.0)
+            {
+                ++numFailures;
+                std::cout << "FAIL spectral blocks: " << signal->name << ", " << (numChannels == 1 ? "mono" : "stereo")
+                          << "  max error " << maxError << std::endl;
+            }
+        }
+    }
+
+    return numFailures;
+}
+
+double RegressionCheck::renderInParts(AudioDelay& referenceDelay, AudioDelay& delay, const juce::AudioBuffer<float>& signal,
+                                      const AudioDelayParameters& base, const AutomationPattern& automation, const std::vector<int>& parts,
+                                      const std::function<void(AudioDelay&, int part)>& beforePart)
+{
+    auto numChannels = signal.getNumChannels();
+    juce::AudioBuffer<float> reference(numChannels, signal.getNumSamples()), output(numChannels, signal.getNumSamples());
+
+    for (size_t part = 0; part + 1 < parts.size(); ++part)
+    {
+        beforePart(referenceDelay, (int)part);
+        beforePart(delay, (int)part);
+
+        // --- the automation and key carry on where the last part stopped
+        auto start = parts[part], length = parts[part + 1] - parts[part];
+        AutomationPattern shifted{ automation.name, [&automation, start](AudioDelayParameters& p, int i, double fs) { automation.apply(p, start + i, fs); } };
+        if (automation.sidechainKey)
+            shifted.sidechainKey = [&automation, start](int channel, int i) { return automation.sidechainKey(channel, start + i); };
+
+        juce::AudioBuffer<float> input(numChannels, length), referencePart(numChannels, length), blockPart(numChannels, length);
+        for (int ch = 0; ch < numChannels; ++ch)
+            input.copyFrom(ch, 0, signal, ch, start, length);
+
+        renderReference(referenceDelay, input, referencePart, base, shifted, sampleRate);
+        renderBlocks(delay, input, blockPart, base, shifted, sampleRate);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            reference.copyFrom(ch, start, referencePart, ch, 0, length);
+            output.copyFrom(ch, start, blockPart, ch, 0, length);
+        }
+    }
+
+    return getMaxError(output, reference);
+}
+
+double RegressionCheck::getMaxError(const juce::AudioBuffer<float>& output, const juce::AudioBuffer<float>& reference)
+{
+    double maxError = 0.0;
+    for (int ch = 0; ch < reference.getNumChannels(); ++ch)
+        for (int i = 0; i < reference.getNumSamples(); ++i)
+            maxError = juce::jmax(maxError, (double)std::abs(output.getSample(ch, i) - reference.getSample(ch, i)));
+
+    return maxError;
+}
+
+template <uint32_t NumLanes>
+int RegressionCheck::checkDelayBank(int& numCases)
+{
+    constexpr int numChannels = 2 * (int)NumLanes;
+
+    int numFailures = 0;
+
+    for (auto variant : { isaVariant::kGeneric, isaVariant::kSSE2, isaVariant::kAVX2, isaVariant::kAVX512 })
+    {
+        if (! DSPKernels::isSupported(variant))
+            continue;
+
+        DSPKernels::forceVariant(variant);
+
+        // --- long delays take the segment path, short ones the lane kernel; mixed banks switch between them
+        enum { longDelays, shortDelays, mixedDelays };
+        const char* delayNames[] = { "long", "short", "mixed" };
+
+        for (int delays = longDelays; delays <= mixedDelays; ++delays)
+        {
+            juce::Random random(0x42616e6b + (int)NumLanes);
+
+            juce::AudioBuffer<float> input(numChannels, signalLength), reference(numChannels, signalLength);
+            for (int ch = 0; ch < numChannels; ++ch)
+                for (int i = 0; i < signalLength; ++i)
+                    input.setSample(ch, i, random.nextFloat() - 0.5f);
+
+            juce::AudioBuffer<float> output(input);
+
+            auto bank = std::make_unique<AudioDelayBank<NumLanes>>();
+            bank->createDelayBuffers(sampleRate, 2000.0);
+
+            std::vector<std::unique_ptr<AudioDelay>> lanes;
+            for (uint32_t lane = 0; lane < NumLanes; ++lane)
+            {
+                lanes.push_back(std::make_unique<AudioDelay>());
+                prepareDelay(*lanes.back(), sampleRate, Interpolation::kLinear);
+            }
+
+            // --- new parameters for every lane at every block, blocks of random length
+            for (int start = 0; start < signalLength; )
+            {
+                auto numSamples = juce::jmin(1 + random.nextInt(700), signalLength - start);
+
+                for (uint32_t lane = 0; lane < NumLanes; ++lane)
+                {
+                    bool shortDelay = delays == shortDelays || (delays == mixedDelays && random.nextBool());
+
+                    AudioDelayParameters params;
+                    params.algorithm = random.nextBool() ? delayAlgorithm::kNormal : delayAlgorithm::kPingPong;
+                    params.updateType = random.nextBool() ? delayUpdateType::kLeftPlusRatio : delayUpdateType::kLeftAndRight;
+                    params.leftDelay_mSec = shortDelay ? random.nextDouble() * 2.0 : 5.0 + random.nextDouble() * 1995.0;
+                    params.rightDelay_mSec = shortDelay ? random.nextDouble() * 2.0 : 5.0 + random.nextDouble() * 1995.0;
+                    params.delayRatio_Pct = shortDelay ? random.nextDouble() * 100.0 : 50.0 + random.nextDouble() * 50.0;
+                    params.feedback_Pct = random.nextDouble() * 99.0;
+                    // --- now and then the -3 dB default, which AudioDelay never recomputes
+                    params.wetLevel_dB = random.nextInt(4) == 0 ? -3.0 : -random.nextDouble() * 20.0;
+                    params.dryLevel_dB = random.nextInt(4) == 0 ? -3.0 : -random.nextDouble() * 20.0;
+
+                    bank->setParameters(lane, params);
+
+                    for (int i = start; i < start + numSamples; ++i)
+                    {
+                        lanes[lane]->setParameters(params);
+
+                        float inputFrame[2]{ input.getSample(2 * (int)lane, i), input.getSample(2 * (int)lane + 1, i) };
+                        float outputFrame[2];
+                        lanes[lane]->processAudioFrame(inputFrame, outputFrame, 2, 2);
+
+                        reference.setSample(2 * (int)lane, i, outputFrame[0]);
+                        reference.setSample(2 * (int)lane + 1, i, outputFrame[1]);
+                    }
+                }
+
+                float* channels[numChannels];
+                for (int ch = 0; ch < numChannels; ++ch)
+                    channels[ch] = output.getWritePointer(ch, start);
+
+                bank->processAudioBlock(channels, channels, (uint32_t)numSamples);
+                start += numSamples;
+            }
+
+            auto maxError = getMaxError(output, reference);
+
+            ++numCases;
+
+            if (maxError > 0.0)
+            {
+                ++numFailures;
+                std::cout << "FAIL delay bank (" << DSPKernels::getVariantName(variant) << "): " << (int)NumLanes
+                          << " lanes, " << delayNames[delays] << " delays  max error " << maxError << std::endl;
+            }
+        }
+    }
+
+    return numFailures;
+}
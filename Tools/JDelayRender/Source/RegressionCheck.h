@@ -0,0 +1,142 @@
+// RegressionCheck.h
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "../../../Source/Convolution/FeedbackConvolver.h"
+#include "../../../Source/DSP/AudioDelay.h"
+#include "../../../Source/DSP/AudioDelayBank.h"
+#include "../../../Source/DSP/FeedbackInsertGraph.h"
+#include "../../../Source/Spectral/SpectralDelay.h"
+
+/**
+Deterministic equivalence check for the AudioDelay processing paths.
+
+The per-sample AudioDelay::processAudioFrame() path, with setParameters() called before every
+sample the way JDelayAudioProcessor drives it, is the reference. Every other processing path is
+registered as a RenderPath with a documented error bound, and is rendered against the reference
+for every combination of:
+
+- test signal: unit impulse train, logarithmic sine sweep, seeded white noise
+- algorithm: every delayAlgorithm
+- interpolation: linear, off (integer delays), render quality (Hermite)
+- channel layout: mono and stereo
+- automation: static, delay-time ramp, delay-time steps, fast gain/feedback/ratio modulation,
+  wet ducking keyed from the input, wet ducking keyed from a sidechain (the aux input),
+  octave-up pitch shifting, freeze held for the middle half, independent left/right delay times
+  with stepped cross feedback
+
+Error bounds (max absolute sample difference, full scale = 1.0):
+
+| Path                      | Bound | Why                                                    |
+|---------------------------|-------|--------------------------------------------------------|
+| reference (re-run)        | 0     | determinism: a second run must be bit-identical        |
+| reference after flush     | 0     | flushing clears everything a previous run wrote        |
+| block kernels (each ISA)  | 0     | same arithmetic in the same order, no FMA contraction  |
+
+Bound 0 for the block kernels relies on every file that includes the DSP headers being compiled
+without FMA contraction, on every platform: the exporters of all projects that build them set
+-ffp-contract=off (GCC, Clang, Xcode) and /fp:precise (MSVC). A new exporter or project must do the same.
+
+Paths that change the arithmetic by design (e.g. float storage, different interpolators) must
+state their bound here and justify it; a path without a bound is expected to be bit-exact.
+
+Switching render quality on and off while running crossfades between the linear and Hermite
+reads; the block path must match the reference through both crossfades exactly, checked
+separately because the switch is not a parameter. So are, against the reference with bound 0:
+
+- feedback inserts (kNormal, kPingPong): a graph of every node type, and the same graph running
+  the feedback IR convolution, one pair of processors per delay
+- kFDN with 4 and 16 lines, and with the line count switched mid-stream (8, 16, 4, 8)
+- SpectralDelay, which has no per-sample path: one sample per call is the reference for blocks of
+  333, with the delay, tilt and feedback changed mid-stream. The levels stay put: their ramps are
+  interpolated per call, so a level change is only the same for the same split
+
+AudioDelayBank is checked the same way, separately because it runs many delays at once: 4, 8 and
+16 lanes of seeded noise with new random kNormal / kPingPong parameters per lane and per block,
+long delays (segment path), short ones (lane kernel) and a mix, against one reference AudioDelay
+per lane, on every instruction set variant. The bound is 0.
+*/
+class RegressionCheck
+{
+public:
+    /** per-sample parameter automation applied on top of a base parameter set */
+    struct AutomationPattern
+    {
+        juce::String name;
+        std::function<void(AudioDelayParameters&, int sampleIndex, double sampleRate)> apply;
+        std::function<float(int channel, int sampleIndex)> sidechainKey = nullptr;	///< ducking key fed through the aux input; nullptr = keyed from the input
+    };
+
+    /** a processing path under test: renders input to output with the given automation */
+    struct RenderPath
+    {
+        juce::String name;
+        double maxAbsError;
+        std::function<void(AudioDelay&, const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output,
+                           const AudioDelayParameters& base, const AutomationPattern& automation, double sampleRate)> render;
+    };
+
+    RegressionCheck();
+
+    /** run every case for every registered path; prints a report and returns true if all paths are within bounds */
+    bool run();
+
+    /** the reference path every other path is compared against */
+    static void renderReference(AudioDelay& delay, const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output,
+                                const AudioDelayParameters& base, const AutomationPattern& automation, double sampleRate);
+
+private:
+    struct TestSignal
+    {
+        juce::String name;
+        juce::AudioBuffer<float> audio;
+    };
+
+    void createTestSignals(int numChannels);
+    void createAutomationPatterns();
+    void createRenderPaths();
+
+    /** render quality switched on and off mid-stream, block path against the reference; returns the number of failures */
+    int checkRenderQualitySwitch(int& numCases);
+
+    /** kNormal and kPingPong through feedback insert graphs, with and without the IR convolution; returns the number of failures */
+    int checkFeedbackInserts(int& numCases);
+
+    /** kFDN with 4 and 16 lines and with line count switches; returns the number of failures */
+    int checkFDNLineCounts(int& numCases);
+
+    /** SpectralDelay in blocks against one sample at a time; returns the number of failures */
+    int checkSpectralBlocks(int& numCases);
+
+    /** render signal through the reference and the block path in parts, calling beforePart() on both delays
+        before each part; returns the largest difference */
+    static double renderInParts(AudioDelay& referenceDelay, AudioDelay& delay, const juce::AudioBuffer<float>& signal,
+                                const AudioDelayParameters& base, const AutomationPattern& automation, const std::vector<int>& parts,
+                                const std::function<void(AudioDelay&, int part)>& beforePart);
+
+    /** largest absolute sample difference */
+    static double getMaxError(const juce::AudioBuffer<float>& output, const juce::AudioBuffer<float>& reference);
+
+    /** AudioDelayBank against one reference AudioDelay per lane; returns the number of failures */
+    template <uint32_t NumLanes>
+    int checkDelayBank(int& numCases);
+
+    /** AudioDelay::processAudioBlock() with per-block automation curves */
+    static void renderBlocks(AudioDelay& delay, const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output,
+                             const AudioDelayParameters& base, const AutomationPattern& automation, double sampleRate);
+
+    /** how the delay lines are read */
+    enum class Interpolation { kLinear, kInteger, kRenderQuality };
+
+    static void prepareDelay(AudioDelay& delay, double sampleRate, Interpolation interpolation);
+    static const char* getInterpolationName(Interpolation interpolation);
+
+    static constexpr double sampleRate = 48000.0;
+    static constexpr int signalLength = 48000;
+
+    juce::OwnedArray<TestSignal> testSignals;
+    std::vector<AutomationPattern> automationPatterns;
+    std::vector<RenderPath> renderPaths;
+};
@@ -0,0 +1,157 @@
+// RenderJob.cpp
+
+#include "RenderJob.h"
+
+RenderJob::RenderJob(const juce::File& _inputFile, const juce::File& _outputFile,
+                     const AudioDelayParameters& _parameters, const FeedbackInsertGraphParameters& _feedbackInserts,
+                     double _maxTail_mSec,
+                     const juce::AudioBuffer<float>* _feedbackIR, double _feedbackIRSampleRate)
+    : juce::ThreadPoolJob(_inputFile.getFileName()),
+      inputFile(_inputFile),
+      outputFile(_outputFile),
+      parameters(_parameters),
+      feedbackInserts(_feedbackInserts),
+      maxTail_mSec(_maxTail_mSec),
+      feedbackIR(_feedbackIR),
+      feedbackIRSampleRate(_feedbackIRSampleRate)
+{
+}
+
+std::unique_ptr<juce::AudioFormatReader> RenderJob::createReader(juce::AudioFormatManager& formatManager)
+{
+    // --- prefer a memory-mapped reader so the OS pages the file in as we stream through it
+    if (auto* format = formatManager.findFormatForFileExtension(inputFile.getFileExtension()))
+    {
+        std::unique_ptr<juce::MemoryMappedAudioFormatReader> mappedReader(format->createMemoryMappedReader(inputFile));
+
+        if (mappedReader != nullptr && mappedReader->mapEntireFile())
+            return mappedReader;
+    }
+
+    // --- compressed formats can't be mapped; fall back to a streaming reader
+    return std::unique_ptr<juce::AudioFormatReader>(formatManager.createReaderFor(inputFile));
+}
+
+juce::ThreadPoolJob::JobStatus RenderJob::runJob()
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    auto reader = createReader(formatManager);
+
+    if (reader == nullptr)
+    {
+        errorMessage = "Unsupported or unreadable audio file";
+        return jobHasFinished;
+    }
+
+    if (reader->numChannels == 0 || reader->numChannels > 2)
+    {
+        errorMessage = "Only mono and stereo files are supported";
+        return jobHasFinished;
+    }
+
+    outputFile.deleteFile();
+    auto outputStream = std::make_unique<juce::FileOutputStream>(outputFile);
+
+    if (outputStream->failedToOpen())
+    {
+        errorMessage = "Can't write " + outputFile.getFullPathName();
+        return jobHasFinished;
+    }
+
+    int bitsPerSample = reader->usesFloatingPointData ? 32 : juce::jlimit(16, 24, (int)reader->bitsPerSample);
+
+    juce::WavAudioFormat wavFormat;
+    std::unique_ptr<juce::AudioFormatWriter> writer(wavFormat.createWriterFor(outputStream.get(),
+                                                                              reader->sampleRate,
+                                                                              reader->numChannels,
+                                                                              bitsPerSample,
+                                                                              {}, 0));
+    if (writer == nullptr)
+    {
+        errorMessage = "Can't create a WAV writer for " + outputFile.getFullPathName();
+        return jobHasFinished;
+    }
+
+    // --- the writer owns the stream now
+    outputStream.release();
+
+    auto startTime = juce::Time::getMillisecondCounterHiRes();
+    render(*reader, *writer);
+    processingSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+    return jobHasFinished;
+}
+
+void RenderJob::render(juce::AudioFormatReader& reader, juce::AudioFormatWriter& writer)
+{
+    AudioDelay delay;
+    delay.createDelayBuffers(reader.sampleRate, 2000.0);
+    delay.setRenderQuality(true);
+    delay.setParameters(parameters);
+
+    // --- the preset's delays are static: convolution partitions as long as the shorter one allows,
+    //     the insert graph's blocks from what is left
+    FeedbackConvolver feedbackConvolver_L, feedbackConvolver_R;
+    FeedbackInsertGraph feedbackGraph_L, feedbackGraph_R;
+    std::shared_ptr<const FeedbackImpulseResponse> ir;
+
+    feedbackGraph_L.prepare(reader.sampleRate);
+    feedbackGraph_R.prepare(reader.sampleRate, kPi / 2.0);
+    feedbackGraph_L.setParameters(feedbackInserts);
+    feedbackGraph_R.setParameters(feedbackInserts);
+
+    if (feedbackIR != nullptr)
+    {
+        auto partitionSize = FeedbackConvolver::getPartitionSize(delay.getMinimumDelayInSamples());
+        ir = FeedbackImpulseResponse::get(*feedbackIR, feedbackIRSampleRate, reader.sampleRate, partitionSize);
+
+        feedbackConvolver_L.prepare(reader.sampleRate);
+        feedbackConvolver_R.prepare(reader.sampleRate);
+        feedbackConvolver_L.setImpulseResponse(ir.get(), 0);
+        feedbackConvolver_R.setImpulseResponse(ir.get(), 1);
+        feedbackGraph_L.setProcessor(&feedbackConvolver_L);
+        feedbackGraph_R.setProcessor(&feedbackConvolver_R);
+    }
+
+    feedbackGraph_L.updateBlockSize(delay.getMinimumDelayInSamples());
+    feedbackGraph_R.updateBlockSize(delay.getMinimumDelayInSamples());
+
+    if (feedbackGraph_L.isActive())
+        delay.setFeedbackInserts(&feedbackGraph_L, &feedbackGraph_R);
+
+    auto numChannels = (uint32_t)reader.numChannels;
+    auto inputLength = reader.lengthInSamples;
+    auto tailLength = (juce::int64)(delay.getTailLength_mSec(-96.0, maxTail_mSec) * reader.sampleRate / 1000.0);
+    auto totalLength = inputLength + tailLength;
+
+    juce::AudioBuffer<float> buffer((int)numChannels, blockSize);
+
+    for (juce::int64 position = 0; position < totalLength; position += blockSize)
+    {
+        if (shouldExit())
+        {
+            errorMessage = "Cancelled";
+            return;
+        }
+
+        auto numSamples = (int)juce::jmin((juce::int64)blockSize, totalLength - position);
+
+        // --- past the end of the file the reader pads with silence, which renders the tail
+        buffer.clear();
+        if (position < inputLength)
+            reader.read(&buffer, 0, numSamples, position, true, true);
+
+        float* channels[2]{ buffer.getWritePointer(0), buffer.getWritePointer((int)numChannels - 1) };
+        delay.processAudioBlock(channels, channels, numChannels, numChannels, (uint32_t)numSamples);
+
+        if (! writer.writeFromAudioSampleBuffer(buffer, 0, numSamples))
+        {
+            errorMessage = "Write failed for " + outputFile.getFullPathName();
+            return;
+        }
+    }
+
+    audioSeconds = (double)totalLength / reader.sampleRate;
+}
@@ -0,0 +1,56 @@
+// RenderJob.h
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "../../../Source/Convolution/FeedbackConvolver.h"
+#include "../../../Source/DSP/AudioDelay.h"
+#include "../../../Source/DSP/FeedbackInsertGraph.h"
+
+/**
+Renders one audio file through its own AudioDelay instance, including the echo tail.
+
+Jobs are independent of each other (one delay, one reader and one writer each), so any
+number of them can run concurrently on a juce::ThreadPool. With a feedback IR, jobs at the same
+sample rate and partition size share its spectra.
+*/
+class RenderJob : public juce::ThreadPoolJob
+{
+public:
+    /** feedbackInserts: the feedback chain (see FeedbackInsertGraph); feedbackIR: convolved into the feedback path
+        (see FeedbackConvolver), nullptr for none; must outlive the job */
+    RenderJob(const juce::File& inputFile, const juce::File& outputFile,
+              const AudioDelayParameters& parameters, const FeedbackInsertGraphParameters& feedbackInserts, double maxTail_mSec,
+              const juce::AudioBuffer<float>* feedbackIR = nullptr, double feedbackIRSampleRate = 0.0);
+
+    JobStatus runJob() override;
+
+    /** results, valid once the job has finished */
+    bool succeeded() const { return errorMessage.isEmpty(); }
+    juce::String getErrorMessage() const { return errorMessage; }
+    double getAudioSeconds() const { return audioSeconds; }
+    double getProcessingSeconds() const { return processingSeconds; }
+
+    const juce::File& getInputFile() const { return inputFile; }
+    const juce::File& getOutputFile() const { return outputFile; }
+
+private:
+    std::unique_ptr<juce::AudioFormatReader> createReader(juce::AudioFormatManager& formatManager);
+    void render(juce::AudioFormatReader& reader, juce::AudioFormatWriter& writer);
+
+    static constexpr int blockSize = 4096;
+
+    juce::File inputFile, outputFile;
+    AudioDelayParameters parameters;
+    FeedbackInsertGraphParameters feedbackInserts;
+    double maxTail_mSec;
+    const juce::AudioBuffer<float>* feedbackIR;
+    double feedbackIRSampleRate;
+
+    juce::String errorMessage;
+    double audioSeconds = 0.0;
+    double processingSeconds = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RenderJob)
+};
@@ -0,0 +1,105 @@
+// Main.cpp
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "../../../Source/Stats/StatsSegment.h"
+
+namespace
+{
+    const char* delayTypeNames[] = { "Normal", "PingPong", "FDN", "Reverse", "Spectral", "Multiband", "BBD" };
+
+    const char* delayTypeName(uint32_t algorithm)
+    {
+        return algorithm < sizeof(delayTypeNames) / sizeof(delayTypeNames[0]) ? delayTypeNames[algorithm] : "Unknown";
+    }
+
+    double averageBlockTime_us(const StatsSegment::SlotSnapshot& s)
+    {
+        return s.blocksProcessed > 0 ? (double)s.totalBlockTime_ns / (double)s.blocksProcessed / 1000.0 : 0.0;
+    }
+
+    void printText(const std::vector<StatsSegment::SlotSnapshot>& instances)
+    {
+        std::printf("%-8s %-4s %-10s %7s %12s %9s %9s %9s %9s %9s %10s %7s\n",
+                    "PID", "ID", "TYPE", "RATE", "BLOCKS", "AVG_US", "MAX_US", "OVERRUNS", "DENORMAL", "NAN", "MEMORY_KB", "QUALITY");
+
+        for (const auto& s : instances)
+            std::printf("%-8" PRIu32 " %-4" PRIu64 " %-10s %7" PRIu32 " %12" PRIu64 " %9.1f %9.1f %9" PRIu64 " %9" PRIu64 " %9" PRIu64 " %10" PRIu64 " %7" PRIu32 "\n",
+                        s.ownerPid, s.instanceId, delayTypeName(s.algorithm), s.sampleRate_Hz, s.blocksProcessed,
+                        averageBlockTime_us(s), (double)s.maxBlockTime_ns / 1000.0, s.deadlineOverruns,
+                        s.denormalBlocks, s.nanBlocks, s.bufferMemoryBytes / 1024, s.qualityLevel);
+    }
+
+    void printJson(const std::vector<StatsSegment::SlotSnapshot>& instances)
+    {
+        std::printf("[");
+
+        for (size_t i = 0; i < instances.size(); ++i)
+        {
+            const auto& s = instances[i];
+            std::printf("%s\n  { \"pid\": %" PRIu32 ", \"instance\": %" PRIu64 ", \"algorithm\": \"%s\", \"sample_rate\": %" PRIu32
+                        ", \"blocks\": %" PRIu64 ", \"samples\": %" PRIu64 ", \"avg_block_us\": %.3f, \"max_block_us\": %.3f"
+                        ", \"overruns\": %" PRIu64 ", \"denormal_blocks\": %" PRIu64 ", \"nan_blocks\": %" PRIu64
+                        ", \"buffer_bytes\": %" PRIu64 ", \"quality_level\": %" PRIu32 " }",
+                        i > 0 ? "," : "", s.ownerPid, s.instanceId, delayTypeName(s.algorithm), s.sampleRate_Hz,
+                        s.blocksProcessed, s.samplesProcessed, averageBlockTime_us(s), (double)s.maxBlockTime_ns / 1000.0,
+                        s.deadlineOverruns, s.denormalBlocks, s.nanBlocks, s.bufferMemoryBytes, s.qualityLevel);
+        }
+
+        std::printf("%s]\n", instances.empty() ? "" : "\n");
+    }
+
+    void printUsage()
+    {
+        std::printf("Usage: JDelayStats [--json]\n\n"
+                    "Prints the performance counters of every running JDelay instance on this machine.\n"
+                    "  --json    one JSON array, one object per instance\n");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    bool json = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--json") == 0)
+        {
+            json = true;
+        }
+        else
+        {
+            printUsage();
+            return std::strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    std::vector<StatsSegment::SlotSnapshot> instances;
+
+    // --- no segment yet: no instance has run since boot, which is an empty list, not an error
+    if (auto* segment = StatsSegment::open(false))
+    {
+        for (const auto& slot : segment->slots)
+        {
+            uint32_t owner = slot.ownerPid.load(std::memory_order_acquire);
+            if (owner == 0 || !StatsSegment::isProcessAlive(owner))
+                continue;
+
+            StatsSegment::SlotSnapshot snapshot;
+            if (StatsSegment::snapshot(slot, snapshot) && snapshot.ownerPid != 0)
+                instances.push_back(snapshot);
+        }
+
+        StatsSegment::close(segment);
+    }
+
+    if (json)
+        printJson(instances);
+    else
+        printText(instances);
+
+    return 0;
+}